@@ -282,6 +282,97 @@ def verify_configuration(ser, sent_config):
     return True
 
 
+# --- Effect Benchmark Mode ---
+
+
+def run_effect_bench(ser, frames, lengths):
+    """Runs the firmware 'bench' command and returns its JSON result."""
+    print("\n--- RUNNING EFFECT BENCHMARK ---")
+    ser.flushInput()
+    command = f"bench {frames} {' '.join(str(n) for n in lengths)}\n"
+    send_command(ser, command)
+    # Every effect at every length, one frame at a time: allow for a long run
+    result = read_json_response(ser, timeout_s=120)
+    if not result or "effects" not in result:
+        print("Benchmark FAILED: Did not receive benchmark JSON.")
+        return None
+    return result
+
+
+def bench_rows(result):
+    """Flattens a bench result into {row name: avg_us}."""
+    rows = {}
+    for row in result.get("effects", []):
+        rows[f"{row['effect']}@{row['length']}"] = row["avg_us"]
+    if "show" in result:
+        rows[f"show@{result['show']['length']}"] = result["show"]["avg_us"]
+    if "audio" in result:
+        rows[f"audio:{result['audio']['backend']}"] = result["audio"]["avg_us"]
+    return rows
+
+
+def compare_bench(result, baseline, tolerance_pct, min_delta_us):
+    """
+    Prints every row against the baseline and returns the regressed rows.
+    A row regresses when it is both tolerance_pct slower and min_delta_us
+    slower than the baseline, so sub-microsecond noise is not reported.
+    """
+    current = bench_rows(result)
+    previous = bench_rows(baseline)
+    regressions = []
+
+    print(f"\n{'row':<32}{'baseline':>10}{'now':>10}{'change':>10}")
+    for name, now_us in current.items():
+        if name not in previous:
+            print(f"{name:<32}{'-':>10}{now_us:>10}{'new':>10}")
+            continue
+        base_us = previous[name]
+        change = (now_us - base_us) * 100.0 / base_us if base_us else 0.0
+        flag = ""
+        if now_us - base_us > min_delta_us and now_us > base_us * (1 + tolerance_pct / 100.0):
+            regressions.append(name)
+            flag = "  <-- REGRESSION"
+        print(f"{name:<32}{base_us:>10}{now_us:>10}{change:>9.1f}%{flag}")
+    for name in previous:
+        if name not in current:
+            print(f"{name:<32}{previous[name]:>10}{'-':>10}{'gone':>10}")
+    return regressions
+
+
+def effect_bench_mode(args):
+    """Collects a benchmark and saves it as the baseline or diffs it against one."""
+    ser = serial.Serial(args.port, args.baud, timeout=5)
+    try:
+        time.sleep(2)  # Wait for initial connection
+        result = run_effect_bench(ser, args.bench_frames, args.bench_lengths)
+    finally:
+        ser.close()
+    if result is None:
+        return False
+
+    if args.save_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(result, f, indent=2)
+        print(f"\nBaseline written to {args.baseline}.")
+        return True
+
+    try:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    except FileNotFoundError:
+        print(f"No baseline at {args.baseline}; run with --save-baseline first.")
+        return False
+
+    if baseline.get("bench", {}).get("led_count") != result["bench"]["led_count"]:
+        print("Warning: the baseline was taken with a different LED count.")
+    regressions = compare_bench(result, baseline, args.tolerance, args.min_delta_us)
+    if regressions:
+        print(f"\n{len(regressions)} row(s) regressed: {', '.join(regressions)}")
+        return False
+    print("\nNo regressions against the baseline.")
+    return True
+
+
 # --- Main Script Execution ---
 
 
@@ -301,8 +392,57 @@ def main():
         default=45,
         help="Number of LEDs for the single test segment.",
     )
+    parser.add_argument(
+        "--effect-bench",
+        action="store_true",
+        help="Run the firmware effect benchmark and diff it against a baseline.",
+    )
+    parser.add_argument(
+        "--bench-frames", type=int, default=200, help="Timed frames per measurement."
+    )
+    parser.add_argument(
+        "--bench-lengths",
+        type=int,
+        nargs="+",
+        default=[30, 150, 585],
+        help="Segment lengths to run each effect at.",
+    )
+    parser.add_argument(
+        "--baseline",
+        type=str,
+        default="bench_baseline.json",
+        help="Benchmark baseline file.",
+    )
+    parser.add_argument(
+        "--save-baseline",
+        action="store_true",
+        help="Store this run as the baseline instead of comparing.",
+    )
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=10.0,
+        help="Percent slowdown allowed before a row counts as a regression.",
+    )
+    parser.add_argument(
+        "--min-delta-us",
+        type=int,
+        default=5,
+        help="Slowdowns smaller than this many microseconds are ignored.",
+    )
     args = parser.parse_args()
 
+    if args.effect_bench:
+        try:
+            passed = effect_bench_mode(args)
+        except serial.SerialException as e:
+            print(f"Error: Could not open serial port {args.port}. {e}")
+            passed = False
+        print("\n" + "=" * 30)
+        print("✅ NO PERFORMANCE REGRESSIONS ✅" if passed else "❌ BENCHMARK FAILED OR REGRESSED ❌")
+        print("=" * 30)
+        sys.exit(0 if passed else 1)
+
     ser = None
     all_tests_passed = True
     try:
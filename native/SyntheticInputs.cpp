@@ -0,0 +1,89 @@
+/**
+ * @file SyntheticInputs.cpp
+ * @brief The synthetic audio beat and motion pattern for native runs.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "SyntheticInputs.h"
+#include "AudioFeatures.h"
+#include "MotionEvents.h"
+
+namespace
+{
+    constexpr uint32_t BEAT_MS = 500;     // 120 BPM
+    constexpr uint32_t TRIGGER_MS = 100;  // Trigger held after each beat
+    constexpr uint32_t AUDIO_FRAME_MS = 8; // Roughly one analysis hop
+    constexpr uint32_t STEP_MS = 350;     // Running cadence; golden samples land at different points of a ripple
+    constexpr uint32_t STEPS_PER_IMPACT = 8;
+    constexpr uint32_t MOTION_BATCH_MS = 10;
+
+    // 255 at the start of the period, falling linearly to 0 at its end
+    uint8_t decay(uint32_t phaseMs, uint32_t periodMs)
+    {
+        return (uint8_t)(255 - phaseMs * 255 / periodMs);
+    }
+
+    void publishAudio(uint32_t nowMs)
+    {
+        AudioFeatures a;
+        uint32_t beats = nowMs / BEAT_MS;
+        uint32_t phase = nowMs % BEAT_MS;
+        a.sequence = nowMs / AUDIO_FRAME_MS + 1;
+        a.timestampMs = nowMs;
+
+        a.bandLevel[AUDIO_BAND_BASS] = decay(phase, BEAT_MS);
+        a.bandLevel[AUDIO_BAND_LOW_MID] = decay((phase + BEAT_MS / 4) % BEAT_MS, BEAT_MS);
+        a.bandLevel[AUDIO_BAND_HIGH_MID] = decay(nowMs % (BEAT_MS / 2), BEAT_MS / 2);
+        a.bandLevel[AUDIO_BAND_TREBLE] = (uint8_t)(128 + 127 * sinf(nowMs * (float)TWO_PI / 1700.0f));
+        for (uint8_t b = 0; b < AUDIO_BAND_COUNT; ++b)
+        {
+            a.bandMagnitude[b] = a.bandLevel[b] * 4.0f;
+        }
+        a.rmsLevel = (a.bandLevel[AUDIO_BAND_BASS] + a.bandLevel[AUDIO_BAND_LOW_MID]) / 2;
+        a.rms = a.rmsLevel * 16.0f;
+
+        a.triggerActive = phase < TRIGGER_MS;
+        a.triggerBrightness = a.triggerActive ? decay(phase, TRIGGER_MS) : 0;
+
+        a.onsetStrength = (nowMs % (BEAT_MS / 2)) < AUDIO_FRAME_MS ? 200 : 0;
+        a.onsetCount = nowMs / (BEAT_MS / 2);
+        a.beatCount = beats;
+        a.lastBeatMs = beats * BEAT_MS;
+        a.bpm = beats >= 2 ? 60000 / BEAT_MS : 0;
+        AudioFeatureBus::getInstance().publish(a);
+    }
+
+    void publishMotion(uint32_t nowMs)
+    {
+        MotionState m;
+        uint32_t steps = nowMs / STEP_MS;
+        uint32_t phase = nowMs % STEP_MS;
+        bool impact = steps > 0 && steps % STEPS_PER_IMPACT == 0;
+        float bump = phase < 60 ? (impact ? 2.5f : 0.8f) * (1.0f - phase / 60.0f) : 0.0f;
+
+        m.sequence = nowMs / MOTION_BATCH_MS + 1;
+        m.timestampMs = nowMs;
+        float angle = nowMs * (float)TWO_PI / 3000.0f;
+        m.accelX = 0.3f * sinf(angle);
+        m.accelY = 0.3f * cosf(angle);
+        m.accelZ = 1.0f + bump;
+        m.magnitude = sqrtf(m.accelX * m.accelX + m.accelY * m.accelY + m.accelZ * m.accelZ);
+
+        m.eventCount = steps;
+        if (steps > 0)
+        {
+            uint32_t lastStep = steps % STEPS_PER_IMPACT;
+            m.lastEvent.type = lastStep == 0 ? MotionEventType::IMPACT : MotionEventType::STEP;
+            m.lastEvent.timestampMs = steps * STEP_MS;
+            m.lastEvent.peakG = lastStep == 0 ? 3.5f : 1.8f;
+        }
+        MotionBus::getInstance().publish(m);
+    }
+}
+
+void publishSyntheticInputs(uint32_t nowMs)
+{
+    publishAudio(nowMs);
+    publishMotion(nowMs);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file SyntheticInputs.h
+ * @brief Stand-in audio and IMU data for native runs of the effect engine.
+ *
+ * @details On the device AudioTrigger and MotionSensor publish through the
+ * AudioFeatureBus and the MotionBus from core 0. Natively nothing does, so the
+ * harness publishes these instead, once per frame before renderSegments()
+ * latches them. Both are pure functions of the virtual time:
+ *
+ * - audio: a 120 BPM beat with decaying band levels, an onset on every half
+ *   beat and the legacy trigger held for the first 100 ms of each beat;
+ * - motion: a slow tilt of about 0.3 g around 1 g of gravity, a step every
+ *   350 ms and an impact on every eighth step.
+ *
+ * So every run, and every effect within a run, sees the same inputs at the
+ * same show time.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef SYNTHETIC_INPUTS_H
+#define SYNTHETIC_INPUTS_H
+
+#include <Arduino.h>
+
+/// Publishes the synthetic audio and motion snapshots for time `nowMs`.
+void publishSyntheticInputs(uint32_t nowMs);
+
+#endif // SYNTHETIC_INPUTS_H
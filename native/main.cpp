@@ -0,0 +1,331 @@
+/**
+ * @file main.cpp
+ * @brief Host-side effect benchmark and golden-frame checker.
+ *
+ * @details The `native` PlatformIO environment builds the effect engine
+ * (PixelStrip, the effects and the modulation engine) against the stand-ins
+ * in native/mock, and this driver on top:
+ *
+ *     pio run -e native
+ *     .pio/build/native/program bench [--frames N] [--lengths 30,150,585]
+ *     .pio/build/native/program golden check [file]
+ *     .pio/build/native/program golden record [file]
+ *
+ * Frames run on the virtual clock (mock Arduino.h): each one advances it by
+ * the frame budget, publishes the synthetic inputs (SyntheticInputs.h) and
+ * goes through beginFrame(), renderSegments(), compose() and present() as on
+ * core 1. Only the timings come from the host's wall clock.
+ *
+ * `bench` prints one JSON object in the layout of the on-device bench
+ * (EffectBench.h), with fractional microseconds and the output stage timed
+ * at every length instead of the audio analysis:
+ *
+ *     {"bench":{"platform":"native","frames":N,"frame_budget_us":..},
+ *      "effects":[{"effect":"Fire","length":30,"avg_us":..,"max_us":..,"drawn":..}, ...],
+ *      "show":[{"length":30,"avg_us":..,"max_us":..}, ...]}
+ *
+ * `golden` runs every effect on a strip of GOLDEN_LEDS with random() seeded
+ * alike, hashes what the outputs were sent every GOLDEN_EVERY frames, and
+ * records the hashes or compares them with the file (native/golden/frames.txt
+ * by default). A check exits 1 on any difference. After a change that is
+ * meant to look different, re-record and commit the file with it.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "PixelStrip.h"
+#include "EffectLookup.h"
+#include "Crc32.h"
+#include "SyntheticInputs.h"
+
+namespace
+{
+    // The bench defaults and limits are the device's (Config.h)
+
+    constexpr uint16_t GOLDEN_LEDS = 60;
+    constexpr uint16_t GOLDEN_FRAMES = 240;  // Four seconds at TARGET_FPS
+    constexpr uint16_t GOLDEN_EVERY = 16;    // Not a multiple of the synthetic beat, so hashes land at different phases
+    constexpr uint32_t GOLDEN_SEED = 1;
+    constexpr uint8_t GOLDEN_BRIGHTNESS = 255; // Full scale, so dim frames still hash differently
+    const char *const GOLDEN_DEFAULT_FILE = "native/golden/frames.txt";
+
+    typedef std::chrono::steady_clock HostClock;
+
+    struct Timing
+    {
+        double totalUs = 0;
+        double maxUs = 0;
+
+        void add(HostClock::time_point start)
+        {
+            double us = std::chrono::duration<double, std::micro>(HostClock::now() - start).count();
+            totalUs += us;
+            if (us > maxUs)
+                maxUs = us;
+        }
+    };
+
+    // Moves the virtual clock on by one frame and latches it, as the render
+    // loop does once a frame is due
+    void beginNextFrame(PixelStrip &strip)
+    {
+        nativeSetMicros(nativeMicros() + strip.getFrameBudgetUs());
+        publishSyntheticInputs(millis());
+        strip.beginFrame(micros());
+    }
+
+    // A fresh strip for every run, so no effect sees state another one left
+    PixelStrip *makeStrip(uint16_t ledCount, uint8_t effectId)
+    {
+        nativeSetMicros(0);
+        randomSeed(GOLDEN_SEED);
+        PixelStrip *strip = new PixelStrip(LED_OUTPUT_PINS, ledCount, GOLDEN_BRIGHTNESS);
+        strip->begin();
+        strip->getSegments()[0]->setEffect(effectId);
+        return strip;
+    }
+
+    uint32_t sentFrameCrc(PixelStrip &strip)
+    {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (uint8_t o = 0; o < strip.getOutputCount(); ++o)
+        {
+            PixelBus &bus = strip.getOutput(o);
+            crc = crc32Update(crc, bus.SentPixels(), bus.PixelsSize());
+        }
+        return ~crc;
+    }
+
+    // "<effect> <hash> <hash> ...", one hash per GOLDEN_EVERY frames
+    std::string goldenLine(uint8_t effectId)
+    {
+        PixelStrip *strip = makeStrip(GOLDEN_LEDS, effectId);
+        std::string line = EFFECT_REGISTRY[effectId].name;
+        for (uint16_t f = 1; f <= GOLDEN_FRAMES; ++f)
+        {
+            beginNextFrame(*strip);
+            strip->renderSegments();
+            strip->show();
+            if (f % GOLDEN_EVERY == 0)
+            {
+                char hash[10];
+                snprintf(hash, sizeof(hash), " %08x", (unsigned)sentFrameCrc(*strip));
+                line += hash;
+            }
+        }
+        delete strip;
+        return line;
+    }
+
+    int runGolden(bool record, const char *path)
+    {
+        if (record)
+        {
+            FILE *f = fopen(path, "w");
+            if (!f)
+            {
+                printf("ERR: Cannot write %s\n", path);
+                return 1;
+            }
+            fprintf(f, "# Golden frames: %u LEDs, %u frames, CRC-32 of the sent pixels every %u frames\n",
+                    (unsigned)GOLDEN_LEDS, (unsigned)GOLDEN_FRAMES, (unsigned)GOLDEN_EVERY);
+            fprintf(f, "# Re-record with `golden record` after an intended visual change\n");
+            for (uint8_t id = 0; id < EFFECT_COUNT; ++id)
+            {
+                fprintf(f, "%s\n", goldenLine(id).c_str());
+            }
+            fclose(f);
+            printf("OK: Recorded %u effects to %s\n", (unsigned)EFFECT_COUNT, path);
+            return 0;
+        }
+
+        FILE *f = fopen(path, "r");
+        if (!f)
+        {
+            printf("ERR: Cannot read %s\n", path);
+            return 1;
+        }
+        std::vector<std::string> expected;
+        char buf[256];
+        while (fgets(buf, sizeof(buf), f))
+        {
+            size_t len = strcspn(buf, "\r\n");
+            buf[len] = '\0';
+            if (len > 0 && buf[0] != '#')
+                expected.push_back(buf);
+        }
+        fclose(f);
+
+        uint8_t failures = 0;
+        for (uint8_t id = 0; id < EFFECT_COUNT; ++id)
+        {
+            std::string actual = goldenLine(id);
+            std::string prefix = std::string(EFFECT_REGISTRY[id].name) + " ";
+            const std::string *want = nullptr;
+            for (const std::string &e : expected)
+            {
+                if (e.compare(0, prefix.size(), prefix) == 0)
+                    want = &e;
+            }
+            if (!want)
+            {
+                printf("ERR: %s has no golden frames\n", EFFECT_REGISTRY[id].name);
+                failures++;
+            }
+            else if (*want != actual)
+            {
+                printf("ERR: %s differs\n  expected %s\n  actual   %s\n", EFFECT_REGISTRY[id].name,
+                       want->c_str() + prefix.size(), actual.c_str() + prefix.size());
+                failures++;
+            }
+        }
+        if (failures)
+        {
+            printf("ERR: %u of %u effects differ from %s\n", (unsigned)failures, (unsigned)EFFECT_COUNT, path);
+            return 1;
+        }
+        printf("OK: %u effects match %s\n", (unsigned)EFFECT_COUNT, path);
+        return 0;
+    }
+
+    void printTiming(const Timing &t, uint16_t frames)
+    {
+        printf("\"avg_us\":%.3f,\"max_us\":%.3f", frames ? t.totalUs / frames : 0.0, t.maxUs);
+    }
+
+    int runBench(uint16_t frames, const uint16_t *lengths, uint8_t lengthCount)
+    {
+        printf("{\"bench\":{\"platform\":\"native\",\"frames\":%u,\"frame_budget_us\":%lu},\"effects\":[",
+               (unsigned)frames, (unsigned long)(1000000UL / TARGET_FPS));
+
+        bool first = true;
+        for (uint8_t l = 0; l < lengthCount; ++l)
+        {
+            for (uint8_t id = 0; id < EFFECT_COUNT; ++id)
+            {
+                PixelStrip *strip = makeStrip(lengths[l], id);
+                beginNextFrame(*strip);
+                strip->renderSegments(); // Warm-up: scratch allocation and the first full draw
+
+                Timing t;
+                uint16_t drawn = 0;
+                for (uint16_t f = 0; f < frames; ++f)
+                {
+                    beginNextFrame(*strip);
+                    HostClock::time_point start = HostClock::now();
+                    bool changed = strip->renderSegments();
+                    t.add(start);
+                    drawn += changed;
+                }
+
+                printf("%s{\"effect\":\"%s\",\"length\":%u,", first ? "" : ",", EFFECT_REGISTRY[id].name, (unsigned)lengths[l]);
+                printTiming(t, frames);
+                printf(",\"drawn\":%u}", (unsigned)drawn);
+                first = false;
+                delete strip;
+            }
+        }
+        printf("],\"show\":[");
+
+        for (uint8_t l = 0; l < lengthCount; ++l)
+        {
+            PixelStrip *strip = makeStrip(lengths[l], 0);
+            Timing t;
+            for (uint16_t f = 0; f < frames; ++f)
+            {
+                HostClock::time_point start = HostClock::now();
+                strip->show();
+                t.add(start);
+            }
+            printf("%s{\"length\":%u,", l ? "," : "", (unsigned)lengths[l]);
+            printTiming(t, frames);
+            printf("}");
+            delete strip;
+        }
+        printf("]}\n");
+        return 0;
+    }
+
+    // "30,150,585" into `lengths`; false on anything but 1..LED_COUNT_MAX
+    bool parseLengths(const char *text, uint16_t *lengths, uint8_t &count)
+    {
+        count = 0;
+        const char *p = text;
+        while (*p)
+        {
+            char *end;
+            long v = strtol(p, &end, 10);
+            if (end == p || v < 1 || v > LED_COUNT_MAX || count == BENCH_MAX_LENGTHS)
+                return false;
+            lengths[count++] = (uint16_t)v;
+            p = end;
+            if (*p == ',')
+                p++;
+            else if (*p)
+                return false;
+        }
+        return count > 0;
+    }
+
+    int usage()
+    {
+        printf("Usage: program bench [--frames N] [--lengths L1,L2,...]\n"
+               "       program golden check|record [file]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        return usage();
+
+    if (strcmp(argv[1], "bench") == 0)
+    {
+        uint16_t frames = BENCH_DEFAULT_FRAMES;
+        uint16_t lengths[BENCH_MAX_LENGTHS];
+        uint8_t lengthCount = sizeof(BENCH_DEFAULT_LENGTHS) / sizeof(BENCH_DEFAULT_LENGTHS[0]);
+        memcpy(lengths, BENCH_DEFAULT_LENGTHS, sizeof(BENCH_DEFAULT_LENGTHS));
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            {
+                long v = strtol(argv[++i], nullptr, 10);
+                if (v < 1 || v > 65535)
+                {
+                    printf("ERR: --frames must be 1-65535\n");
+                    return 2;
+                }
+                frames = (uint16_t)v;
+            }
+            else if (strcmp(argv[i], "--lengths") == 0 && i + 1 < argc)
+            {
+                if (!parseLengths(argv[++i], lengths, lengthCount))
+                {
+                    printf("ERR: --lengths takes up to %u comma-separated lengths of 1-%u\n",
+                           (unsigned)BENCH_MAX_LENGTHS, (unsigned)LED_COUNT_MAX);
+                    return 2;
+                }
+            }
+            else
+            {
+                return usage();
+            }
+        }
+        return runBench(frames, lengths, lengthCount);
+    }
+
+    if (strcmp(argv[1], "golden") == 0 && argc >= 3 && argc <= 4)
+    {
+        const char *path = argc == 4 ? argv[3] : GOLDEN_DEFAULT_FILE;
+        if (strcmp(argv[2], "check") == 0)
+            return runGolden(false, path);
+        if (strcmp(argv[2], "record") == 0)
+            return runGolden(true, path);
+    }
+    return usage();
+}
@@ -0,0 +1,81 @@
+/**
+ * @file Arduino.cpp
+ * @brief Virtual clock, deterministic random() and stdout Serial for native builds.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "Arduino.h"
+
+HostSerial Serial;
+
+namespace
+{
+    uint64_t nowUs = 0;
+    uint32_t randomState = 0x9E3779B9u;
+
+    uint32_t nextRandom()
+    {
+        // xorshift32; never zero once seeded with a non-zero state
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState;
+    }
+}
+
+unsigned long millis() { return (unsigned long)(uint32_t)(nowUs / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)nowUs; }
+void delay(unsigned long ms) { nowUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { nowUs += us; }
+
+void nativeSetMicros(uint64_t us) { nowUs = us; }
+uint64_t nativeMicros() { return nowUs; }
+
+long random(long howBig)
+{
+    if (howBig <= 0)
+        return 0;
+    return (long)(nextRandom() % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig)
+{
+    if (howSmall >= howBig)
+        return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    randomState = seed ? (uint32_t)seed : 0x9E3779B9u;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+size_t Print::write(uint8_t c)
+{
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+size_t Print::print(long n)
+{
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%ld", n);
+    return write((const uint8_t *)buf, len);
+}
+
+size_t Print::print(unsigned long n)
+{
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%lu", n);
+    return write((const uint8_t *)buf, len);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the parts of the Arduino core the effect engine uses.
+ *
+ * @details Only the `native` PlatformIO environment sees this header. Time is
+ * virtual: millis() and micros() return whatever the harness last set with
+ * nativeSetMicros(), and delay() advances it, so a run draws the same frames
+ * however fast the host is. random() is a fixed xorshift generator seeded by
+ * randomSeed(), so the same seed gives the same frames with any C library.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+// As in ArduinoCore-API: templates rather than macros in C++, mixed types allowed
+template <class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a)
+{
+    return (b < a) ? b : a;
+}
+template <class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a)
+{
+    return (a < b) ? b : a;
+}
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+/// Sets the virtual clock that millis() and micros() read. Native builds only.
+void nativeSetMicros(uint64_t us);
+uint64_t nativeMicros();
+
+/**
+ * @brief Just enough of Arduino's String for headers that declare String
+ * members; the effect engine itself does not use it.
+ */
+class String
+{
+public:
+    String() = default;
+    String(const char *s) : s_(s ? s : "") {}
+    const char *c_str() const { return s_.c_str(); }
+    unsigned length() const { return (unsigned)s_.size(); }
+
+private:
+    std::string s_;
+};
+
+/// Output sink with the print()/println() overloads the harness uses, writing to stdout.
+class Print
+{
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t print(int n) { return print((long)n); }
+    size_t print(unsigned int n) { return print((unsigned long)n); }
+    size_t println() { return write("\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+};
+
+class HostSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    explicit operator bool() const { return true; }
+    void flush() { fflush(stdout); }
+};
+extern HostSerial Serial;
+
+#endif // NATIVE_ARDUINO_H
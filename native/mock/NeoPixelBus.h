@@ -0,0 +1,99 @@
+/**
+ * @file NeoPixelBus.h
+ * @brief Host stand-in for NeoPixelBus: a pixel buffer with nothing on the wire.
+ *
+ * @details PixelStrip only needs a bus's raw pixel buffer and its Show()
+ * call. Here Show() copies the buffer into a "sent" frame and counts, so the
+ * harness can read back exactly what the LEDs would have received, in the
+ * bus's GRB byte order.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef NATIVE_NEOPIXELBUS_H
+#define NATIVE_NEOPIXELBUS_H
+
+#include <Arduino.h>
+#include <vector>
+
+struct RgbColor
+{
+    uint8_t R, G, B;
+    RgbColor(uint8_t r = 0, uint8_t g = 0, uint8_t b = 0) : R(r), G(g), B(b) {}
+
+    /// A copy scaled by (ratio + 1) / 256, as NeoPixelBus does; the colour itself is unchanged.
+    RgbColor Dim(uint8_t ratio) const
+    {
+        return RgbColor(dim(R, ratio), dim(G, ratio), dim(B, ratio));
+    }
+
+private:
+    static uint8_t dim(uint8_t value, uint8_t ratio)
+    {
+        return (uint8_t)(((uint16_t)value * ((uint16_t)ratio + 1)) >> 8);
+    }
+};
+
+struct NeoGrbFeature
+{
+};
+struct Neo800KbpsMethod
+{
+};
+
+template <typename T_COLOR_FEATURE, typename T_METHOD>
+class NeoPixelBus
+{
+public:
+    NeoPixelBus(uint16_t countPixels, uint8_t pin) : pixels_(countPixels * 3u), sent_(countPixels * 3u), pin_(pin) {}
+
+    void Begin() {}
+    void Show(bool maintainBufferConsistency = true)
+    {
+        (void)maintainBufferConsistency;
+        sent_ = pixels_;
+        dirty_ = false;
+        shows_++;
+    }
+    bool CanShow() const { return true; }
+    bool IsDirty() const { return dirty_; }
+    void Dirty() { dirty_ = true; }
+    void ResetDirty() { dirty_ = false; }
+
+    uint8_t *Pixels() { return pixels_.data(); }
+    size_t PixelsSize() const { return pixels_.size(); }
+    uint16_t PixelCount() const { return (uint16_t)(pixels_.size() / 3); }
+
+    void SetPixelColor(uint16_t index, RgbColor color)
+    {
+        uint8_t *p = &pixels_[index * 3u];
+        p[0] = color.G;
+        p[1] = color.R;
+        p[2] = color.B;
+        dirty_ = true;
+    }
+    RgbColor GetPixelColor(uint16_t index) const
+    {
+        const uint8_t *p = &pixels_[index * 3u];
+        return RgbColor(p[1], p[0], p[2]);
+    }
+    void ClearTo(RgbColor color)
+    {
+        for (uint16_t i = 0; i < PixelCount(); ++i)
+            SetPixelColor(i, color);
+    }
+
+    // --- Native only ---
+    const uint8_t *SentPixels() const { return sent_.data(); } ///< The buffer as of the last Show()
+    uint32_t ShowCount() const { return shows_; }
+    uint8_t Pin() const { return pin_; }
+
+private:
+    std::vector<uint8_t> pixels_;
+    std::vector<uint8_t> sent_;
+    uint8_t pin_;
+    bool dirty_ = false;
+    uint32_t shows_ = 0;
+};
+
+#endif // NATIVE_NEOPIXELBUS_H
@@ -0,0 +1,193 @@
+/**
+ * @file AudioAnalysis.h
+ * @brief Band-energy analyzers used by AudioTrigger.
+ *
+ * @details Effects need a handful of frequency bands, not a full spectrum.
+ * Computing a 256-point double-precision FFT for them is wasteful on the
+ * RP2040, whose Cortex-M0+ cores have no FPU. Two interchangeable backends are
+ * provided here, each exposing
+ * `void bandMagnitudes(const int16_t *samples, float out[AUDIO_BAND_COUNT])`:
+ *
+ * - GoertzelBandAnalyzer: one Goertzel filter per band bin, in integer
+ *   arithmetic, over Q15 Hamming-windowed samples. The window and the filter
+ *   coefficients are computed at compile time. This is the default.
+ * - FftBandAnalyzer: the original ArduinoFFT<double> path, kept as a
+ *   reference for tuning and comparison.
+ *
+ * Each band is the sum of the unnormalized DFT magnitudes of a few bins after
+ * a Hamming window (audio_detail::kBandBins), so trigger thresholds mean the
+ * same with either backend. The bass band is bins 1-4, as it always was.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef AUDIO_ANALYSIS_H
+#define AUDIO_ANALYSIS_H
+
+#include <Arduino.h>
+#include <ArduinoFFT.h>
+#include <math.h>
+#include "AudioFeatures.h"
+
+namespace audio_detail
+{
+    constexpr double PI_D = 3.14159265358979323846;
+
+    // Taylor-series cosine, usable in constant expressions
+    constexpr double cosine(double x)
+    {
+        while (x > PI_D)
+            x -= 2 * PI_D;
+        while (x < -PI_D)
+            x += 2 * PI_D;
+        double term = 1, sum = 1;
+        for (int n = 1; n < 16; ++n)
+        {
+            term *= -x * x / ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr int32_t roundToInt(double v)
+    {
+        return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+    }
+
+    // Hamming window in Q15, matching ArduinoFFT's FFT_WIN_TYP_HAMMING:
+    // w[i] = 0.54 - 0.46 * cos(2 * pi * i / (N - 1)).
+    template <size_t N>
+    struct HammingQ15
+    {
+        int16_t w[N];
+        constexpr HammingQ15() : w()
+        {
+            for (size_t i = 0; i < N; ++i)
+                w[i] = (int16_t)roundToInt(32767.0 * (0.54 - 0.46 * cosine(2 * PI_D * i / (N - 1))));
+        }
+    };
+
+    // Bins making up each band, in cycles per BAND_REFERENCE_N samples, i.e.
+    // 62.5 Hz steps at 16 kHz. Higher bands are sampled sparsely: a Hamming
+    // main lobe is four bins wide, and a flash or a colour shift does not
+    // need every bin counted.
+    constexpr size_t BAND_REFERENCE_N = 256;
+    constexpr uint8_t kBandBins[] = {
+        1, 2, 3, 4,  // Bass
+        6, 9, 13,    // Low mid
+        20, 32, 48,  // High mid
+        72, 100,     // Treble
+    };
+    constexpr uint8_t kBandFirstBin[AUDIO_BAND_COUNT + 1] = {0, 4, 7, 10, 12};
+    constexpr uint8_t BAND_BIN_COUNT = sizeof(kBandBins);
+    static_assert(kBandFirstBin[AUDIO_BAND_COUNT] == BAND_BIN_COUNT, "Band table out of step with AudioBand");
+
+    // DFT index of band bin b for an N-point block
+    constexpr size_t bandBinIndex(size_t N, uint8_t b)
+    {
+        return kBandBins[b] * N / BAND_REFERENCE_N;
+    }
+
+    // Goertzel coefficients 2 * cos(2 * pi * k / N) in Q29, for every band bin.
+    template <size_t N>
+    struct GoertzelBandCoeffsQ29
+    {
+        int32_t c[BAND_BIN_COUNT];
+        constexpr GoertzelBandCoeffsQ29() : c()
+        {
+            for (uint8_t b = 0; b < BAND_BIN_COUNT; ++b)
+                c[b] = roundToInt(536870912.0 * 2 * cosine(2 * PI_D * bandBinIndex(N, b) / N));
+        }
+    };
+}
+
+/**
+ * @class GoertzelBandAnalyzer
+ * @brief Integer Goertzel filters for the band bins.
+ *
+ * @details One pass over the block windows each sample once and steps every
+ * bin's filter. The filter state stays within int32 for 16-bit input at
+ * N = 256. The feedback product and the final power use 64-bit intermediates.
+ * A square root per bin at the end is the only floating-point work.
+ */
+template <size_t N>
+class GoertzelBandAnalyzer
+{
+public:
+    void bandMagnitudes(const int16_t *samples, float out[AUDIO_BAND_COUNT])
+    {
+        int32_t s1[BINS] = {0};
+        int32_t s2[BINS] = {0};
+        for (size_t i = 0; i < N; ++i)
+        {
+            int32_t x = ((int32_t)samples[i] * kWindow.w[i]) >> 15;
+            for (uint8_t b = 0; b < BINS; ++b)
+            {
+                int32_t s = x + (int32_t)(((int64_t)kCoeffs.c[b] * s1[b]) >> 29) - s2[b];
+                s2[b] = s1[b];
+                s1[b] = s;
+            }
+        }
+
+        for (uint8_t band = 0; band < AUDIO_BAND_COUNT; ++band)
+        {
+            float sum = 0;
+            for (uint8_t b = audio_detail::kBandFirstBin[band]; b < audio_detail::kBandFirstBin[band + 1]; ++b)
+            {
+                // |X[k]|^2 = s1^2 + s2^2 - coeff * s1 * s2
+                int64_t cross = (((int64_t)kCoeffs.c[b] * s1[b]) >> 29) * s2[b];
+                int64_t power = (int64_t)s1[b] * s1[b] + (int64_t)s2[b] * s2[b] - cross;
+                sum += sqrtf(power > 0 ? (float)power : 0.0f);
+            }
+            out[band] = sum;
+        }
+    }
+
+private:
+    static constexpr uint8_t BINS = audio_detail::BAND_BIN_COUNT;
+    static constexpr audio_detail::HammingQ15<N> kWindow{};
+    static constexpr audio_detail::GoertzelBandCoeffsQ29<N> kCoeffs{};
+};
+
+template <size_t N>
+constexpr audio_detail::HammingQ15<N> GoertzelBandAnalyzer<N>::kWindow;
+template <size_t N>
+constexpr audio_detail::GoertzelBandCoeffsQ29<N> GoertzelBandAnalyzer<N>::kCoeffs;
+
+/**
+ * @class FftBandAnalyzer
+ * @brief Reference backend: the full ArduinoFFT<double> analysis.
+ */
+template <size_t N>
+class FftBandAnalyzer
+{
+public:
+    void bandMagnitudes(const int16_t *samples, float out[AUDIO_BAND_COUNT])
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            vReal[i] = samples[i];
+            vImag[i] = 0;
+        }
+        FFT.windowing(vReal, N, FFT_WIN_TYP_HAMMING, FFT_FORWARD);
+        FFT.compute(vReal, vImag, N, FFT_FORWARD);
+        FFT.complexToMagnitude(vReal, vImag, N);
+
+        for (uint8_t band = 0; band < AUDIO_BAND_COUNT; ++band)
+        {
+            double sum = 0;
+            for (uint8_t b = audio_detail::kBandFirstBin[band]; b < audio_detail::kBandFirstBin[band + 1]; ++b)
+            {
+                sum += vReal[audio_detail::bandBinIndex(N, b)];
+            }
+            out[band] = (float)sum;
+        }
+    }
+
+private:
+    ArduinoFFT<double> FFT;
+    double vReal[N];
+    double vImag[N];
+};
+
+#endif // AUDIO_ANALYSIS_H
@@ -0,0 +1,87 @@
+/**
+ * @file AudioFeatures.h
+ * @brief Per-frame audio analysis results shared by every effect.
+ *
+ * @details AudioTrigger analyses each PDM block once on core 0 and publishes
+ * an AudioFeatures snapshot through the AudioFeatureBus. The render loop on
+ * core 1 copies the latest snapshot once per frame (PixelStrip::renderSegments)
+ * and effects read that copy by reference through PixelStrip::getAudio(), so
+ * any number of audio-reactive segments share one analysis pass and all see
+ * the same values within a frame.
+ *
+ * The bus is a sequence lock (SeqLock.h): a single writer, readers that never
+ * block the writer and simply retry if a publish raced their copy. No mutex is
+ * taken on either core.
+ *
+ * Analysis frames (every AUDIO_HOP_SIZE samples) and render frames do not line
+ * up, so an effect can see the same snapshot twice or skip one. Events are
+ * therefore published as running counters (onsetCount, beatCount); an effect
+ * remembers the last count it acted on instead of looking for a one-frame flag.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef AUDIO_FEATURES_H
+#define AUDIO_FEATURES_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SeqLock.h"
+
+/// Frequency bands reported in AudioFeatures, lowest first.
+enum AudioBand : uint8_t
+{
+    AUDIO_BAND_BASS = 0, ///< ~60-250 Hz, the band the trigger threshold applies to
+    AUDIO_BAND_LOW_MID,  ///< ~375-800 Hz
+    AUDIO_BAND_HIGH_MID, ///< ~1.2-3 kHz
+    AUDIO_BAND_TREBLE,   ///< ~4.5-6 kHz
+    AUDIO_BAND_COUNT
+};
+
+/**
+ * @brief One audio frame's analysis results.
+ */
+struct AudioFeatures
+{
+    uint32_t sequence = 0;    ///< Audio frames analysed since boot; 0 until the first one
+    uint32_t timestampMs = 0; ///< End of the frame on the audio clock: ms of audio since the microphone started
+
+    float bandMagnitude[AUDIO_BAND_COUNT] = {}; ///< Summed DFT magnitudes, in trigger-threshold units
+    uint8_t bandLevel[AUDIO_BAND_COUNT] = {};   ///< 0-255 above the band's background, scaled to its recent peak
+    float rms = 0;                              ///< RMS of the raw block, in sample units
+    uint8_t rmsLevel = 0;                       ///< 0-255, auto-scaled like bandLevel
+
+    // The legacy bass trigger: threshold and brightness mapping as before
+    bool triggerActive = false;
+    uint8_t triggerBrightness = 0;
+
+    uint8_t onsetStrength = 0; ///< Largest rise in any bandLevel since the previous frame
+    uint32_t onsetCount = 0;   ///< Onsets detected since boot
+    uint32_t beatCount = 0;    ///< Bass onsets spaced as beats, since boot
+    uint32_t lastBeatMs = 0;   ///< Audio-clock time of the latest beat (compare with timestampMs)
+    uint16_t bpm = 0;          ///< Smoothed tempo estimate; 0 until two beats have been seen
+};
+
+/**
+ * @class AudioFeatureBus
+ * @brief Single-writer, lock-free publication of the latest AudioFeatures.
+ *
+ * @details publish() belongs to the audio path on core 0; read() is safe from
+ * any core.
+ */
+class AudioFeatureBus : public SeqLock<AudioFeatures>
+{
+public:
+    static AudioFeatureBus &getInstance()
+    {
+        static AudioFeatureBus instance;
+        return instance;
+    }
+
+private:
+    AudioFeatureBus() = default;
+    AudioFeatureBus(const AudioFeatureBus &) = delete;
+    AudioFeatureBus &operator=(const AudioFeatureBus &) = delete;
+};
+
+#endif // AUDIO_FEATURES_H
@@ -0,0 +1,130 @@
+/**
+ * @file AudioRing.h
+ * @brief Single-producer/single-consumer sample ring between the PDM ISR and
+ * the audio analysis stage.
+ *
+ * @details The PDM receive callback writes samples in place with
+ * writeSpan()/commit(); processAudio() in the main loop takes overlapping
+ * analysis frames out with readFrame(). Each side only ever writes its own
+ * index, so no lock or interrupt masking is needed. Indices run freely and
+ * are reduced modulo the power-of-two capacity, which keeps "full" and
+ * "empty" distinct without a spare slot.
+ *
+ * When the consumer falls far behind, the producer drops the newest samples
+ * and counts an overrun rather than overwriting a frame mid-copy. The
+ * consumer bounds its own latency with dropBacklog(), which skips whole hops.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <Arduino.h>
+
+/// Overrun and skip counters, as reported by `audiostats`.
+struct AudioRingStats
+{
+    uint32_t overruns = 0;       ///< PDM callbacks that found the ring full
+    uint32_t droppedSamples = 0; ///< Samples the producer discarded
+    uint32_t skippedFrames = 0;  ///< Hops the consumer skipped to catch up
+    uint32_t maxBacklog = 0;     ///< Most samples ever waiting for analysis
+};
+
+template <size_t Capacity>
+class AudioSampleRing
+{
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // --- Producer (PDM ISR) ---
+
+    /// Contiguous free space starting at the write position; 0 when full.
+    size_t writeSpan(int16_t *&dest)
+    {
+        uint32_t head = head_;
+        size_t free = Capacity - (size_t)(head - tail_);
+        size_t toEnd = Capacity - (head & MASK);
+        dest = &buffer_[head & MASK];
+        return free < toEnd ? free : toEnd;
+    }
+
+    /// Publishes `count` samples written through writeSpan().
+    void commit(size_t count)
+    {
+        __sync_synchronize(); // Samples land before the index that exposes them
+        head_ = head_ + count;
+    }
+
+    void recordOverrun(size_t dropped)
+    {
+        stats_.overruns++;
+        stats_.droppedSamples += dropped;
+    }
+
+    // --- Consumer (analysis) ---
+
+    size_t available() const
+    {
+        return (size_t)(head_ - tail_);
+    }
+
+    /**
+     * @brief Copies the oldest `frameLen` samples into `out` and advances by `hop`.
+     * @return false, leaving the ring untouched, until `frameLen` samples are waiting.
+     */
+    bool readFrame(int16_t *out, size_t frameLen, size_t hop)
+    {
+        size_t waiting = available();
+        if (waiting > stats_.maxBacklog)
+            stats_.maxBacklog = waiting;
+        if (waiting < frameLen)
+            return false;
+        __sync_synchronize(); // Index read before the samples it covers
+
+        uint32_t tail = tail_;
+        size_t start = tail & MASK;
+        size_t first = Capacity - start < frameLen ? Capacity - start : frameLen;
+        memcpy(out, &buffer_[start], first * sizeof(int16_t));
+        memcpy(out + first, &buffer_[0], (frameLen - first) * sizeof(int16_t));
+
+        __sync_synchronize(); // Copy finished before the producer may reuse it
+        tail_ = tail + hop;
+        samplesConsumed_ += hop;
+        return true;
+    }
+
+    /**
+     * @brief Skips whole hops until at most `maxWaiting` samples are left.
+     * @return The number of hops skipped.
+     */
+    uint32_t dropBacklog(size_t maxWaiting, size_t hop)
+    {
+        uint32_t hops = 0;
+        while (available() > maxWaiting)
+        {
+            tail_ = tail_ + hop;
+            samplesConsumed_ += hop;
+            hops++;
+        }
+        stats_.skippedFrames += hops;
+        return hops;
+    }
+
+    /// Samples advanced past since boot; the analysis stage's clock.
+    uint64_t samplesConsumed() const { return samplesConsumed_; }
+
+    const AudioRingStats &stats() const { return stats_; }
+    void resetStats() { stats_ = AudioRingStats(); }
+
+private:
+    static constexpr uint32_t MASK = Capacity - 1;
+
+    int16_t buffer_[Capacity];
+    volatile uint32_t head_ = 0; ///< Written by the producer only
+    volatile uint32_t tail_ = 0; ///< Written by the consumer only
+    uint64_t samplesConsumed_ = 0;
+    AudioRingStats stats_;
+};
+
+#endif // AUDIO_RING_H
@@ -7,6 +7,7 @@
  */
 #include "BLEManager.h"
 #include "BinaryCommandHandler.h" // ADDED: Include to access BleCommand enum
+#include "Log.h"
 
 // --- UUIDs for the BLE Service and Characteristics ---
 // These MUST match the UUIDs in the Android app's BluetoothService.kt
@@ -16,6 +17,10 @@ const char *TX_CHAR_UUID = "19B10001-E8F2-537E-4F6C-D104768A1214";
 // RX is for receiving data FROM the App (Writes)
 const char *RX_CHAR_UUID = "19B10002-E8F2-537E-4F6C-D104768A1214";
 
+// Notification payload at the minimum ATT MTU of 23 (3 bytes go to the ATT header)
+static const uint16_t BLE_DEFAULT_CHUNK_SIZE = 20;
+static const size_t TX_HEADER_SIZE = 2;
+
 // --- Static C-Style Callback Functions ---
 // The BLE library requires simple C-style function pointers for callbacks.
 // These static functions will simply call the public methods on our singleton instance,
@@ -40,7 +45,14 @@ BLEManager::BLEManager() : bleService(SERVICE_UUID),
                            // RX characteristic is set to WRITE, so the app can send commands.
                            rxCharacteristic(RX_CHAR_UUID, BLEWrite, 512), // Allow large writes for batch configs
                            deviceName_(nullptr),
-                           commandHandlerCallback(nullptr)
+                           commandHandlerCallback(nullptr),
+                           txHead_(0),
+                           txTail_(0),
+                           txUsed_(0),
+                           txMsgRemaining_(0),
+                           chunkSize_(BLE_DEFAULT_CHUNK_SIZE),
+                           rxBytes_(0),
+                           txBytes_(0)
 {
 }
 
@@ -48,15 +60,15 @@ BLEManager::BLEManager() : bleService(SERVICE_UUID),
 
 void BLEManager::begin(const char *deviceName, CommandCallback callback)
 {
-    Serial.println("BLE: Initializing BLE Manager...");
+    LOG_INFO("BLE: Initializing BLE Manager...");
     deviceName_ = deviceName;
     if (!BLE.begin())
     {
-        Serial.println("FATAL: Starting BLE failed!");
+        LOG_ERROR("FATAL: Starting BLE failed!");
         while (1)
             ; // Halt execution
     }
-    Serial.println("BLE: BLE stack started successfully");
+    LOG_INFO("BLE: BLE stack started successfully");
 
     // Set the device name and advertise the service
     BLE.setLocalName(deviceName);
@@ -79,91 +91,173 @@ void BLEManager::begin(const char *deviceName, CommandCallback callback)
 
     // Start advertising
     BLE.advertise();
-    Serial.print("BLE Manager initialized. Advertising as '");
-    Serial.print(deviceName);
-    Serial.print("' with service UUID: ");
-    Serial.println(SERVICE_UUID);
-    Serial.println("BLE: Ready for connections");
+    LOG_INFO("BLE Manager initialized. Advertising as '%s' with service UUID: %s", deviceName, SERVICE_UUID);
+    LOG_INFO("BLE: Ready for connections");
 }
 
 void BLEManager::update()
 {
     // This is the only function that needs to be called in the main loop()
-    // It processes all incoming BLE events.
+    // It processes all incoming BLE events, then sends a few queued
+    // notifications so a large transfer never holds up the loop.
     BLE.poll();
+    if (txUsed_ > 0)
+    {
+        drainTx(BLE_TX_CHUNKS_PER_POLL);
+    }
 }
 
 void BLEManager::reset()
 {
-    Serial.println("BLE: Resetting BLE stack...");
+    LOG_INFO("BLE: Resetting BLE stack...");
     BLE.stopAdvertise();
     BLE.end();
+    clearTx();
+    chunkSize_ = BLE_DEFAULT_CHUNK_SIZE;
     delay(200);
     begin(deviceName_, commandHandlerCallback);
-    Serial.println("BLE: Reset complete.");
+    LOG_INFO("BLE: Reset complete.");
 }
 
 void BLEManager::sendMessage(const String &message)
 {
     // This is a convenience wrapper to send a String.
     // It calls the byte array version.
-    Serial.print("BLE TX (String): '");
-    Serial.print(message);
-    Serial.print("' (");
-    Serial.print(message.length());
-    Serial.println(" bytes)");
     sendMessage((const uint8_t *)message.c_str(), message.length());
 }
 
+void BLEManager::sendMessage(const char *message)
+{
+    sendMessage((const uint8_t *)message, strlen(message));
+}
+
 void BLEManager::sendMessage(const uint8_t *data, size_t len)
 {
     if (!isConnected())
     {
-        Serial.println("BLE TX Failed: Not connected");
+        LOG_DEBUG("BLE TX Failed: Not connected");
+        return;
+    }
+    // Without notifications enabled the app never sees it, and drainTx()
+    // would discard it anyway
+    if (!txCharacteristic.subscribed())
+    {
+        LOG_DEBUG("BLE TX Failed: Not subscribed");
+        return;
+    }
+    if (len == 0)
+        return;
+    if (len + TX_HEADER_SIZE > BLE_TX_QUEUE_SIZE)
+    {
+        LOG_ERROR("BLE TX Failed: Message of %u bytes is larger than the TX queue", (unsigned)len);
         return;
     }
 
-    Serial.print("BLE TX (Raw): ");
-    Serial.print(len);
-    Serial.print(" bytes - ");
-    for (size_t i = 0; i < min(len, (size_t)32); i++)
+    LOG_DEBUG_BYTES("BLE TX: ", data, len);
+
+    // Back-pressure: if the queue is full, send until this message fits.
+    if (BLE_TX_QUEUE_SIZE - txUsed_ < len + TX_HEADER_SIZE)
     {
-        if (data[i] >= 32 && data[i] <= 126)
-        {
-            Serial.print((char)data[i]);
-        }
-        else
+        LOG_WARN("BLE TX: Queue full, flushing...");
+        unsigned long start = millis();
+        while (BLE_TX_QUEUE_SIZE - txUsed_ < len + TX_HEADER_SIZE)
         {
-            Serial.print("[0x");
-            Serial.print(data[i], HEX);
-            Serial.print("]");
+            BLE.poll();
+            if (!isConnected() || !txCharacteristic.subscribed() || millis() - start > BLE_TX_FLUSH_TIMEOUT_MS)
+            {
+                LOG_ERROR("BLE TX Failed: Queue did not drain");
+                return;
+            }
+            drainTx(1);
         }
     }
-    if (len > 32)
-        Serial.print("...");
-    Serial.println();
-
-    // BLE can only send a limited number of bytes at a time (the MTU, max transmission unit).
-    // This loop breaks the data into chunks and sends them sequentially.
-    // The Android side will be responsible for reassembling them.
-    size_t offset = 0;
-    int chunkCount = 0;
-    // MODIFIED: Changed chunk size to 20 bytes as requested by the user.
-    const size_t BLE_MAX_CHUNK_SIZE = 20; 
-    while (offset < len)
+
+    uint8_t header[TX_HEADER_SIZE] = {(uint8_t)((len >> 8) & 0xFF), (uint8_t)(len & 0xFF)};
+    txWrite(header, TX_HEADER_SIZE);
+    txWrite(data, len);
+}
+
+void BLEManager::setMtu(uint16_t mtu)
+{
+    uint16_t chunk = mtu > 3 ? mtu - 3 : BLE_DEFAULT_CHUNK_SIZE;
+    chunkSize_ = constrain(chunk, BLE_DEFAULT_CHUNK_SIZE, BLE_TX_MAX_CHUNK);
+    LOG_INFO("BLE: MTU %u, notification size %u", mtu, chunkSize_);
+}
+
+uint16_t BLEManager::getChunkSize() const
+{
+    return chunkSize_;
+}
+
+size_t BLEManager::getTxQueued() const
+{
+    return txUsed_;
+}
+
+uint32_t BLEManager::getRxBytes() const { return rxBytes_; }
+uint32_t BLEManager::getTxBytes() const { return txBytes_; }
+
+// --- TX Queue ---
+
+void BLEManager::txWrite(const uint8_t *data, size_t len)
+{
+    // Callers have checked for space; copy in at most two runs around the wrap.
+    size_t first = min(len, BLE_TX_QUEUE_SIZE - txHead_);
+    memcpy(txQueue_ + txHead_, data, first);
+    memcpy(txQueue_, data + first, len - first);
+    txHead_ = (txHead_ + len) % BLE_TX_QUEUE_SIZE;
+    txUsed_ += len;
+}
+
+void BLEManager::txRead(uint8_t *out, size_t len)
+{
+    size_t first = min(len, BLE_TX_QUEUE_SIZE - txTail_);
+    memcpy(out, txQueue_ + txTail_, first);
+    memcpy(out + first, txQueue_, len - first);
+    txTail_ = (txTail_ + len) % BLE_TX_QUEUE_SIZE;
+    txUsed_ -= len;
+}
+
+bool BLEManager::drainTx(uint8_t maxChunks)
+{
+    // Nobody will ever receive what is queued: drop it rather than let it
+    // fill the queue and make sendMessage block.
+    if (!isConnected() || !txCharacteristic.subscribed())
+    {
+        clearTx();
+        return false;
+    }
+    for (uint8_t sent = 0; sent < maxChunks && txUsed_ > 0; ++sent)
     {
-        size_t chunkSize = min(BLE_MAX_CHUNK_SIZE, len - offset); 
-        Serial.print("  Chunk ");
-        Serial.print(++chunkCount);
-        Serial.print(": ");
-        Serial.print(chunkSize);
-        Serial.println(" bytes");
-        txCharacteristic.writeValue(data + offset, chunkSize);
-        offset += chunkSize;
+        if (txMsgRemaining_ == 0)
+        {
+            uint8_t header[TX_HEADER_SIZE];
+            txRead(header, TX_HEADER_SIZE);
+            txMsgRemaining_ = ((size_t)header[0] << 8) | header[1];
+        }
+
+        // writeValue() returns once the controller has taken the notification,
+        // so a refusal means its buffers are full: leave the chunk queued and
+        // try again after the next poll.
+        size_t chunk = min((size_t)chunkSize_, txMsgRemaining_);
+        size_t first = min(chunk, BLE_TX_QUEUE_SIZE - txTail_);
+        memcpy(txChunk_, txQueue_ + txTail_, first);
+        memcpy(txChunk_ + first, txQueue_, chunk - first);
+        if (!txCharacteristic.writeValue(txChunk_, chunk))
+        {
+            return false;
+        }
+        txTail_ = (txTail_ + chunk) % BLE_TX_QUEUE_SIZE;
+        txUsed_ -= chunk;
+        txMsgRemaining_ -= chunk;
+        txBytes_ += chunk;
     }
-    Serial.print("BLE TX Complete: ");
-    Serial.print(chunkCount);
-    Serial.println(" chunks sent");
+    return true;
+}
+
+void BLEManager::clearTx()
+{
+    txHead_ = txTail_ = txUsed_ = txMsgRemaining_ = 0;
 }
 
 bool BLEManager::isConnected()
@@ -179,71 +273,65 @@ bool BLEManager::isConnected()
 
 void BLEManager::handleConnect(BLEDevice central)
 {
-    Serial.print("BLE CONNECT: Device connected - ");
-    Serial.print(central.address());
-    Serial.print(" (Name: ");
-    Serial.print(central.localName());
-    Serial.println(")");
+    LOG_INFO("BLE CONNECT: Device connected - %s (Name: %s)", central.address().c_str(), central.localName().c_str());
 }
 
 void BLEManager::handleDisconnect(BLEDevice central)
 {
-    Serial.print("BLE DISCONNECT: Device disconnected - ");
-    Serial.print(central.address());
-    Serial.print(" (Name: ");
-    Serial.print(central.localName());
-    Serial.println(")");
+    LOG_INFO("BLE DISCONNECT: Device disconnected - %s (Name: %s)", central.address().c_str(), central.localName().c_str());
+    // Anything still queued was meant for that central; the next one starts at the default MTU.
+    clearTx();
+    chunkSize_ = BLE_DEFAULT_CHUNK_SIZE;
     // After disconnecting, start advertising again to allow new connections.
     BLE.advertise();
-    Serial.println("BLE: Advertising restarted after disconnect");
+    LOG_INFO("BLE: Advertising restarted after disconnect");
 }
 
 void BLEManager::handleWrite(BLEDevice central, BLECharacteristic characteristic)
 {
     // This function is called whenever the app writes data to our RX characteristic.
-    Serial.print("BLE RX: Received ");
-    Serial.print(characteristic.valueLength());
-    Serial.print(" bytes from ");
-    Serial.print(central.address());
-    Serial.print(" - ");
-
-    // Print the received data in a readable format
     const uint8_t *data = characteristic.value();
     size_t len = characteristic.valueLength();
-    for (size_t i = 0; i < min(len, (size_t)32); i++)
-    {
-        if (data[i] >= 32 && data[i] <= 126)
-        {
-            Serial.print((char)data[i]);
-        }
-        else
-        {
-            Serial.print("[0x");
-            Serial.print(data[i], HEX);
-            Serial.print("]");
-        }
-    }
-    if (len > 32)
-        Serial.print("...");
-    Serial.println();
+    rxBytes_ += len;
+    LOG_DEBUG_BYTES("BLE RX: ", data, len);
 
     // If a command handler callback is registered, call it with the received data.
+    // The value buffer is only valid until the next poll, so the callback copies it.
     if (commandHandlerCallback)
     {
-        Serial.print("BLE RX: Command: ");
-        // Check if data is long enough to safely cast to BleCommand
-        if (len > 0) {
-            Serial.print((BleCommand)data[0]); // Print the command type
-        } else {
-            Serial.print("Empty command");
-        }
-        Serial.println(" bytes)");
-    
-        commandHandlerCallback(characteristic.value(), characteristic.valueLength());
-        Serial.println("BLE RX: Command handler completed");
+        commandHandlerCallback(data, len);
     }
     else
     {
-        Serial.println("BLE RX: No command handler registered!");
+        LOG_ERROR("BLE RX: No command handler registered!");
     }
 }
+
+// --- BLETextSink ---
+
+size_t BLETextSink::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t BLETextSink::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t done = 0; done < size;)
+    {
+        if (used_ == sizeof(buffer_))
+            flush();
+        size_t n = min(size - done, sizeof(buffer_) - used_);
+        memcpy(buffer_ + used_, buffer + done, n);
+        used_ += n;
+        done += n;
+    }
+    return size;
+}
+
+void BLETextSink::flush()
+{
+    if (used_ == 0)
+        return;
+    BLEManager::getInstance().sendMessage(buffer_, used_);
+    used_ = 0;
+}
@@ -54,29 +54,59 @@ public:
     /**
      * @brief Initial7izes the BLE service, characteristics, and starts advertising.
      * @param deviceName The name the device will advertise.
-     * @param callback The function to call when a command is received.
+     * @param callback The function to call when a command is received. It runs
+     * inside BLE.poll(), so it should only queue the packet (see RxQueue.h).
      */
     void begin(const char *deviceName, CommandCallback callback);
 
     /**
-     * @brief Polls for BLE events. This should be called in the main loop.
+     * @brief Polls for BLE events and sends queued notifications. This should be called in the main loop.
+     * @details At most BLE_TX_CHUNKS_PER_POLL notifications go out per call, after
+     * BLE.poll() has let the controller report the packets it has completed.
      */
     void update();
 
     /**
-     * @brief Sends a String message to the connected central device (the app).
-     * @details This function handles chunking the message if it's too large for a single BLE packet.
+     * @brief Queues a String message for the connected central device (the app).
      * @param message The String message to send.
      */
     void sendMessage(const String &message);
 
     /**
-     * @brief Sends a raw byte array to the connected central device.
+     * @brief Queues a C string, such as a fixed JSON reply, without building a String.
+     */
+    void sendMessage(const char *message);
+
+    /**
+     * @brief Queues a raw byte array for the connected central device.
+     * @details Returns without waiting for the radio; update() sends the message in
+     * MTU-sized notifications. A notification never spans two messages, so each
+     * message still starts a new notification. Only a full queue makes this block,
+     * for at most BLE_TX_FLUSH_TIMEOUT_MS. Dropped unless the app is subscribed
+     * to TX notifications.
      * @param data A pointer to the byte array.
      * @param len The length of the byte array.
      */
     void sendMessage(const uint8_t *data, size_t len);
 
+    /**
+     * @brief Sets the notification size from the ATT MTU the app negotiated.
+     * @details ArduinoBLE does not expose the negotiated MTU, so the app reports it
+     * (CMD_SET_MTU). The default is the 23-byte minimum MTU. It reverts to that default on disconnect.
+     * @param mtu The negotiated ATT MTU; notifications carry up to mtu - 3 bytes.
+     */
+    void setMtu(uint16_t mtu);
+
+    /** @brief Payload bytes per notification at the current MTU. */
+    uint16_t getChunkSize() const;
+
+    /** @brief Bytes waiting in the TX queue, including per-message headers. */
+    size_t getTxQueued() const;
+
+    /** @brief Bytes written by the central since boot, and bytes notified to it. */
+    uint32_t getRxBytes() const;
+    uint32_t getTxBytes() const;
+
     /**
      * @brief Resets the BLE stack.
     */
@@ -111,6 +141,44 @@ private:
     BLECharacteristic rxCharacteristic; ///< For receiving data FROM the app (App -> Arduino).
     const char *deviceName_;            ///< Stores the device name for reset purposes.
     CommandCallback commandHandlerCallback; ///< Function pointer to the command handler.
+
+    // --- TX Queue ---
+    // A ring of [length MSB, length LSB, bytes...] messages.
+    uint8_t txQueue_[BLE_TX_QUEUE_SIZE];
+    size_t txHead_;          ///< Next byte to write.
+    size_t txTail_;          ///< Next byte to send.
+    size_t txUsed_;          ///< Bytes in the ring.
+    size_t txMsgRemaining_;  ///< Bytes left of the message at the tail; 0 means a header is next.
+    uint16_t chunkSize_;     ///< Payload bytes per notification.
+    uint8_t txChunk_[BLE_TX_MAX_CHUNK]; ///< A chunk copied out of the ring, which may wrap.
+    uint32_t rxBytes_;       ///< Telemetry (Telemetry.h)
+    uint32_t txBytes_;
+
+    void txWrite(const uint8_t *data, size_t len);
+    void txRead(uint8_t *out, size_t len);
+    bool drainTx(uint8_t maxChunks); ///< Returns false if the stack refused a notification
+    void clearTx();
+};
+
+/**
+ * @class BLETextSink
+ * @brief Print that sends what is written to it over BLE, for text command replies.
+ *
+ * @details Output is collected into messages of up to BLE_TX_MAX_CHUNK bytes
+ * and queued with BLEManager::sendMessage, so a reply printed a few bytes at
+ * a time still leaves in full notifications. Call flush() once the command
+ * is done to send the rest.
+ */
+class BLETextSink : public Print
+{
+public:
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    void flush() override;
+
+private:
+    uint8_t buffer_[BLE_TX_MAX_CHUNK];
+    size_t used_ = 0;
 };
 
 #endif // BLE_MANAGER_H
\ No newline at end of file
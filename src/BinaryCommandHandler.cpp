@@ -3,119 +3,66 @@
 #include "EffectLookup.h"
 #include "ConfigManager.h"
 #include "BLEManager.h"
+#include "ByteOrder.h"
+#include "RenderEngine.h"
+#include "PresetBank.h"
+#include "Telemetry.h"
+#include "Modulation.h"
+#include "ShowClock.h"
+#include "SerialCommandHandler.h"
+#include "EffectCatalog.h"
+#include "Log.h"
 #include <ArduinoJson.h>
 
 extern PixelStrip *strip;
 extern uint16_t LED_COUNT;
+extern SerialCommandHandler serialCommandHandler;
+
+namespace
+{
+    // A single [segment id, param index, value] record: later ones for the
+    // same parameter make it redundant
+    bool isCoalescable(const uint8_t *data, size_t len)
+    {
+        return len == 7 && data[0] == CMD_SET_EFFECT_PARAMETER;
+    }
+}
 
 // Constructor
 BinaryCommandHandler::BinaryCommandHandler()
     : _incomingBatchState(IncomingBatchState::IDLE),
       _jsonBufferIndex(0), // Initialize buffer index
-      _isSerialEffectsTest(false),
       _isSerialBatch(false),
-      _ackReceived(false),
-      _ackTimeoutStart(0),
       _expectedSegmentsToReceive(0),
       _segmentsReceivedInBatch(0),
-      _expectedEffectsToSend(0),
-      _effectsSentInBatch(0),
-      _expectedSegmentsToSend_Out(0), // NEW
-      _segmentsSentInBatch_Out(0)     // NEW
+      _streamLastRxMs(0),
+      _rxFrameTick(0),
+      _rxCoalesced(0),
+      _rxDropped(0),
+      _rxDropUnreported(false),
+      _arrivedUs(0),
+      _dispatching(false)
 {
     // Ensure the buffer is cleared on startup
     memset(_incomingJsonBuffer, 0, sizeof(_incomingJsonBuffer));
 }
 
 // Main Command Router
-void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len)
+void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len, uint32_t arrivedUs)
 {
+    _arrivedUs = arrivedUs;
     if (len < 1)
     {
-        Serial.println("ERR: Received empty command.");
-        return;
-    }
-
-    // Handle ACK for the get all effects command
-    if (_incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK)
-    {
-        // Use CMD_ACK_GENERIC
-        bool isAck = (data[0] == (uint8_t)CMD_ACK_GENERIC);
-        if (isAck)
-        {
-            handleAck();
-            if (_effectsSentInBatch < _expectedEffectsToSend)
-            {
-                String effectJson = buildEffectInfoJson(_effectsSentInBatch);
-                if (_isSerialEffectsTest)
-                {
-                    Serial.println(effectJson);
-                }
-                else
-                {
-                    BLEManager::getInstance().sendMessage(effectJson);
-                    // Add a small delay here to ensure the previous write completes fully
-                    // This is a common workaround for some BLE stacks that might have internal buffering delays
-                    delay(5); // Add this line
-                }
-                _effectsSentInBatch++;
-                if (_effectsSentInBatch >= _expectedEffectsToSend)
-                {
-                    Serial.println("OK: All effects sent.");
-                    _incomingBatchState = IncomingBatchState::IDLE;
-                    _isSerialEffectsTest = false;
-                }
-                else
-                {
-                    Serial.print("Now waiting for ACK to send effect ");
-                    Serial.print(_effectsSentInBatch);
-                    Serial.println("...");
-                    _ackReceived = false;        // Reset ACK for the next expected ACK
-                    _ackTimeoutStart = millis(); // Restart timeout for the next ACK
-                }
-            }
-        }
+        LOG_ERROR("ERR: Received empty command.");
         return;
     }
 
-    // NEW: Handle ACK for the get all segments command
-    if (_incomingBatchState == IncomingBatchState::EXPECTING_SEGMENT_ACK)
+    // ACKs for an outgoing effect or segment transfer
+    if ((_incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK ||
+         _incomingBatchState == IncomingBatchState::EXPECTING_SEGMENT_ACK) &&
+        data[0] == (uint8_t)CMD_ACK_GENERIC)
     {
-        bool isAck = (data[0] == (uint8_t)CMD_ACK_GENERIC);
-        if (isAck)
-        {
-            handleAck(); // Call general ACK handler
-            if (_segmentsSentInBatch_Out < _expectedSegmentsToSend_Out)
-            {
-                // Send next segment
-                String segmentJson = buildSegmentInfoJson(_segmentsSentInBatch_Out);
-                // Decide if serial or BLE, based on _isSerialBatch
-                if (_isSerialBatch)
-                {
-                    Serial.println(segmentJson);
-                }
-                else
-                {
-                    BLEManager::getInstance().sendMessage(segmentJson);
-                    delay(5); // Add this line for segment JSONs too
-                }
-                _segmentsSentInBatch_Out++;
-                if (_segmentsSentInBatch_Out >= _expectedSegmentsToSend_Out)
-                {
-                    Serial.println("OK: All segments sent.");
-                    _incomingBatchState = IncomingBatchState::IDLE;
-                    _isSerialBatch = false; // Reset the flag
-                }
-                else
-                {
-                    Serial.print("Now waiting for ACK to send segment ");
-                    Serial.print(_segmentsSentInBatch_Out);
-                    Serial.println("...");
-                    _ackReceived = false;        // Reset ACK for the next expected ACK
-                    _ackTimeoutStart = millis(); // Restart timeout for the next ACK
-                }
-            }
-        }
+        handleTransferAck(data, len);
         return;
     }
 
@@ -127,6 +74,20 @@ void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len)
         return;
     }
 
+    // Binary segment streams may span any number of packets
+    if (_incomingBatchState == IncomingBatchState::RECEIVING_SEGMENT_STREAM)
+    {
+        processSegmentStreamData(data, len);
+        return;
+    }
+
+    // Host-rendered frames, until the stream's end marker
+    if (_incomingBatchState == IncomingBatchState::RECEIVING_PIXEL_STREAM)
+    {
+        processPixelStreamData(data, len);
+        return;
+    }
+
     // Process new commands
     BleCommand cmd = (BleCommand)data[0];
     const uint8_t *payload = data + 1;
@@ -144,15 +105,23 @@ void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len)
         sendGenericAck = false; // Handled by getLedCount
         break;
     case CMD_GET_ALL_SEGMENT_CONFIGS:
-        handleGetAllSegmentConfigs(false); // False for BLE
+        handleGetAllSegmentConfigs(false, payloadLen > 0 ? payload[0] : 0); // Optional window byte
         sendGenericAck = false;            // Handled by getAllSegmentConfigs
         break;
     case CMD_SET_ALL_SEGMENT_CONFIGS:
         handleSetAllSegmentConfigsCommand(false); // False for BLE
         sendGenericAck = false;                   // Handled by setAllSegmentConfigsCommand
         break;
+    case CMD_GET_ALL_SEGMENTS_BINARY:
+        handleGetAllSegmentsBinary(false);
+        sendGenericAck = false; // The stream is the reply
+        break;
+    case CMD_SET_ALL_SEGMENTS_BINARY:
+        handleSetAllSegmentsBinary(false, payload, payloadLen);
+        sendGenericAck = false; // ACKed once the whole stream is applied
+        break;
     case CMD_GET_ALL_EFFECTS:
-        handleGetAllEffectsCommand(false); // False for BLE
+        handleGetAllEffectsCommand(false, payloadLen > 0 ? payload[0] : 0); // Optional window byte
         sendGenericAck = false;            // Handled by getAllEffectsCommand
         break;
     case CMD_ACK_GENERIC: // Use CMD_ACK_GENERIC
@@ -160,16 +129,68 @@ void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len)
         sendGenericAck = false; // This is an ACK, not a command to ACK
         break;
     case CMD_READY: // CMD_READY is an indicator, not a command to be actively handled with a function call here.
-        Serial.println("CMD: Device Ready received.");
+        LOG_DEBUG("CMD: Device Ready received.");
         sendGenericAck = false; // No ACK needed for a READY signal
         break;
     case CMD_CLEAR_SEGMENTS: // <-- ADD THIS CASE BLOCK
         handleClearSegments();
         sendGenericAck = false;
         break;
+    case CMD_SET_EFFECT:
+        sendGenericAck = handleSetEffect(payload, payloadLen);
+        break;
+    case CMD_SET_EFFECT_PARAMETER:
+        handleSetEffectParameter(payload, payloadLen);
+        sendGenericAck = false; // Streamed at slider rate; only errors are reported
+        break;
+    case CMD_SET_MTU:
+        sendGenericAck = handleSetMtu(payload, payloadLen);
+        break;
+    case CMD_ACTIVATE_PRESET:
+        sendGenericAck = handleActivatePreset(payload, payloadLen);
+        break;
+    case CMD_SAVE_PRESET:
+        handleSavePreset(payload, payloadLen);
+        sendGenericAck = false; // Replies with a status message
+        break;
+    case CMD_DELETE_PRESET:
+        sendGenericAck = handleDeletePreset(payload, payloadLen);
+        break;
+    case CMD_LIST_PRESETS:
+        handleListPresets();
+        sendGenericAck = false; // The list is the reply
+        break;
+    case CMD_GET_STATS:
+        handleGetStats();
+        sendGenericAck = false; // The packet is the reply
+        break;
+    case CMD_SET_MODULATION:
+        sendGenericAck = handleSetModulation(payload, payloadLen);
+        break;
+    case CMD_CLEAR_MODULATION:
+        sendGenericAck = handleClearModulation(payload, payloadLen);
+        break;
+    case CMD_SYNC_CLOCK:
+        handleSyncClock(payload, payloadLen);
+        sendGenericAck = false; // Sent every few seconds; only errors are reported
+        break;
+    case CMD_GET_CLOCK:
+        handleGetClock();
+        sendGenericAck = false; // The packet is the reply
+        break;
+    case CMD_PIXEL_STREAM:
+        handleStartPixelStream(false, payload, payloadLen);
+        sendGenericAck = false; // Statistics are sent when the stream ends
+        break;
+    case CMD_TEXT_COMMAND:
+        sendGenericAck = handleTextCommand(payload, payloadLen);
+        break;
+    case CMD_GET_EFFECT_CATALOG_HASH:
+        handleGetEffectCatalogHash();
+        sendGenericAck = false; // The packet is the reply
+        break;
     default:
-        Serial.print("ERR: Unknown binary command: 0x");
-        Serial.println(cmd, HEX);
+        LOG_ERROR("ERR: Unknown binary command: 0x%X", cmd);
         sendGenericAck = false; // Unknown command, no ACK
         break;
     }
@@ -178,39 +199,40 @@ void BinaryCommandHandler::handleCommand(const uint8_t *data, size_t len)
     {
         uint8_t ack_payload[] = {(uint8_t)CMD_ACK_GENERIC}; // Use CMD_ACK_GENERIC
         BLEManager::getInstance().sendMessage(ack_payload, 1);
-        Serial.println("-> Sent Generic ACK");
+        LOG_DEBUG("-> Sent Generic ACK");
     }
 }
 
 void BinaryCommandHandler::handleSaveConfig()
 {
-    Serial.println("CMD: Save Config");
+    LOG_DEBUG("CMD: Save Config");
     if (saveConfig())
     {
-        Serial.println("-> OK: Config saved.");
+        LOG_INFO("-> OK: Config saved.");
         BLEManager::getInstance().sendMessage("{\"status\":\"OK\", \"message\":\"Config saved\"}");
     }
     else
     {
-        Serial.println("-> ERR: Failed to save config.");
+        LOG_ERROR("-> ERR: Failed to save config.");
         BLEManager::getInstance().sendMessage("{\"error\":\"Failed to save config\"}");
     }
 }
 
 void BinaryCommandHandler::handleAck()
 {
-    Serial.println("<- Received ACK from app.");
-    _ackReceived = true;
+    LOG_DEBUG("<- Received ACK from app.");
 }
 
 void BinaryCommandHandler::handleSetAllSegmentConfigsCommand(bool viaSerial)
 {
     _isSerialBatch = viaSerial; // Set the flag
-    Serial.println("CMD: Set All Segment Configurations - Initiated.");
+    LOG_DEBUG("CMD: Set All Segment Configurations - Initiated.");
     if (strip)
     {
+        FrameLock frameLock;
         strip->clearUserSegments();
-        Serial.println("OK: Cleared existing user segments.");
+        markConfigDirty();
+        LOG_INFO("OK: Cleared existing user segments.");
     }
     _incomingBatchState = IncomingBatchState::EXPECTING_ALL_SEGMENTS_COUNT;
     _jsonBufferIndex = 0;
@@ -219,40 +241,16 @@ void BinaryCommandHandler::handleSetAllSegmentConfigsCommand(bool viaSerial)
     _segmentsReceivedInBatch = 0;
     uint8_t ack_payload[] = {(uint8_t)CMD_ACK_GENERIC}; // Use CMD_ACK_GENERIC
     BLEManager::getInstance().sendMessage(ack_payload, 1);
-    Serial.println("-> Sent ACK for CMD_SET_ALL_SEGMENT_CONFIGS initiation.");
+    LOG_DEBUG("-> Sent ACK for CMD_SET_ALL_SEGMENT_CONFIGS initiation.");
 }
 
-void BinaryCommandHandler::handleGetAllEffectsCommand(bool viaSerial)
+void BinaryCommandHandler::handleGetAllEffectsCommand(bool viaSerial, uint8_t window)
 {
-    _isSerialBatch = viaSerial;
     if (!viaSerial)
     {
-        Serial.println("CMD: Get All Effects - Initiated.");
-    }
-    _expectedEffectsToSend = EFFECT_COUNT;
-    _effectsSentInBatch = 0;
-    _isSerialEffectsTest = viaSerial;
-
-    uint8_t count_payload[3];
-    count_payload[0] = (uint8_t)CMD_GET_ALL_EFFECTS; // Cast to uint8_t
-    count_payload[1] = (_expectedEffectsToSend >> 8) & 0xFF;
-    count_payload[2] = _expectedEffectsToSend & 0xFF;
-
-    if (viaSerial)
-    {
-        Serial.write(count_payload, 3);
+        LOG_DEBUG("CMD: Get All Effects - Initiated.");
     }
-    else
-    {
-        BLEManager::getInstance().sendMessage(count_payload, 3);
-    }
-
-    Serial.print("-> Sent effect count: ");
-    Serial.println(_expectedEffectsToSend);
-    Serial.println("Now waiting for ACK to send first effect...");
-    _incomingBatchState = IncomingBatchState::EXPECTING_EFFECT_ACK;
-    _ackReceived = false;        // Set to false to wait for the first ACK
-    _ackTimeoutStart = millis(); // Start timeout for the first ACK
+    beginTransfer(IncomingBatchState::EXPECTING_EFFECT_ACK, EFFECT_COUNT, window, viaSerial);
 }
 
 void BinaryCommandHandler::processIncomingAllSegmentsData(const uint8_t *data, size_t len)
@@ -260,7 +258,7 @@ void BinaryCommandHandler::processIncomingAllSegmentsData(const uint8_t *data, s
     // Append new data to the buffer, checking for overflow
     if (_jsonBufferIndex + len >= sizeof(_incomingJsonBuffer))
     {
-        Serial.println("ERR: JSON buffer overflow!");
+        LOG_ERROR("ERR: JSON buffer overflow!");
         _incomingBatchState = IncomingBatchState::IDLE;
         _jsonBufferIndex = 0;
         memset(_incomingJsonBuffer, 0, sizeof(_incomingJsonBuffer));
@@ -276,15 +274,14 @@ void BinaryCommandHandler::processIncomingAllSegmentsData(const uint8_t *data, s
         if (_jsonBufferIndex >= 2)
         {
             _expectedSegmentsToReceive = (_incomingJsonBuffer[0] << 8) | _incomingJsonBuffer[1];
-            Serial.print("Expected segments to receive: ");
-            Serial.println(_expectedSegmentsToReceive);
+            LOG_DEBUG("Expected segments to receive: %u", _expectedSegmentsToReceive);
             _segmentsReceivedInBatch = 0;
             _incomingBatchState = IncomingBatchState::EXPECTING_ALL_SEGMENTS_JSON;
             _jsonBufferIndex = 0; // Clear buffer for incoming JSON
             memset(_incomingJsonBuffer, 0, sizeof(_incomingJsonBuffer));
             uint8_t ack_payload[] = {(uint8_t)CMD_ACK_GENERIC}; // Use CMD_ACK_GENERIC
             BLEManager::getInstance().sendMessage(ack_payload, 1);
-            Serial.println("-> Sent ACK for segment count.");
+            LOG_DEBUG("-> Sent ACK for segment count.");
         }
     }
     else if (_incomingBatchState == IncomingBatchState::EXPECTING_ALL_SEGMENTS_JSON)
@@ -315,82 +312,311 @@ void BinaryCommandHandler::processIncomingAllSegmentsData(const uint8_t *data, s
 
             uint8_t ack_payload[] = {(uint8_t)CMD_ACK_GENERIC}; // Use CMD_ACK_GENERIC
             BLEManager::getInstance().sendMessage(ack_payload, 1);
-            Serial.print("-> Sent ACK for segment ");
-            Serial.print(_segmentsReceivedInBatch);
-            Serial.println(".");
+            LOG_DEBUG("-> Sent ACK for segment %u.", _segmentsReceivedInBatch);
 
             if (_segmentsReceivedInBatch >= _expectedSegmentsToReceive)
             {
-                Serial.println("OK: All segment configurations received and applied.");
+                LOG_INFO("OK: All segment configurations received and applied.");
                 _incomingBatchState = IncomingBatchState::IDLE;
                 _jsonBufferIndex = 0;
                 memset(_incomingJsonBuffer, 0, sizeof(_incomingJsonBuffer));
-                strip->show(); // Update strip after all segments are applied
+                // The render engine picks the new configuration up on its next frame.
             }
         }
     }
 }
 
-IncomingBatchState BinaryCommandHandler::getIncomingBatchState() const
+void BinaryCommandHandler::handleSetAllSegmentsBinary(bool viaSerial, const uint8_t *data, size_t len)
 {
-    return _incomingBatchState;
+    _isSerialBatch = viaSerial;
+    LOG_DEBUG("CMD: Set All Segments (binary) - Initiated.");
+    _segmentParser.reset();
+    _stagedSegments.clear();
+    _incomingBatchState = IncomingBatchState::RECEIVING_SEGMENT_STREAM;
+    _streamLastRxMs = millis();
+    if (len > 0)
+    {
+        processSegmentStreamData(data, len);
+    }
 }
 
-bool BinaryCommandHandler::isSerialBatchActive() const
+void BinaryCommandHandler::processSegmentStreamData(const uint8_t *data, size_t len)
 {
-    return _isSerialBatch;
+    _streamLastRxMs = millis();
+    for (size_t i = 0; i < len; ++i)
+    {
+        const char *error = nullptr;
+        switch (_segmentParser.feed(data[i]))
+        {
+        case SegmentRecordParser::Status::NeedMore:
+            break;
+        case SegmentRecordParser::Status::Record:
+        {
+            // Staged in the same length-prefixed form as a preset's records
+            size_t bodyLen;
+            const uint8_t *body = _segmentParser.recordBody(bodyLen);
+            if (_stagedSegments.size() + 2 + bodyLen > SEGMENT_STREAM_STAGING_MAX)
+            {
+                error = "Segment stream too large";
+                break;
+            }
+            size_t pos = _stagedSegments.size();
+            _stagedSegments.resize(pos + 2 + bodyLen);
+            putU16(&_stagedSegments[pos], (uint16_t)bodyLen);
+            memcpy(&_stagedSegments[pos + 2], body, bodyLen);
+            if (!_segmentParser.isDone())
+                break;
+        }
+            // fall through: that was the last record
+        case SegmentRecordParser::Status::Done:
+            applyStagedSegments();
+            if (!_isSerialBatch)
+            {
+                uint8_t ack_payload[] = {(uint8_t)CMD_ACK_GENERIC};
+                BLEManager::getInstance().sendMessage(ack_payload, 1);
+                LOG_DEBUG("-> Sent ACK for segment stream.");
+            }
+            _incomingBatchState = IncomingBatchState::IDLE;
+            _isSerialBatch = false;
+            return; // Bytes after the stream belong to the next command
+        case SegmentRecordParser::Status::Error:
+            error = _segmentParser.error();
+            break;
+        }
+
+        if (error)
+        {
+            LOG_ERROR("ERR: Segment stream rejected: %s", error);
+            if (!_isSerialBatch)
+            {
+                BLEManager::getInstance().sendMessage("{\"error\":\"Invalid segment stream\"}");
+            }
+            discardStagedSegments();
+            _incomingBatchState = IncomingBatchState::IDLE;
+            _isSerialBatch = false;
+            return;
+        }
+    }
 }
 
-void BinaryCommandHandler::update()
+void BinaryCommandHandler::applyStagedSegments()
 {
-    // Check for ACK timeout when sending effect info
-    if (_incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK)
+    if (strip)
     {
-        if (!_ackReceived && (millis() - _ackTimeoutStart > ACK_WAIT_TIMEOUT_MS))
+        // The render core sees either the old segments or the new ones, never a mix
+        FrameLock frameLock;
+        strip->clearUserSegments();
+        SegmentRecord rec;
+        for (size_t pos = 0; pos + 2 <= _stagedSegments.size();)
         {
-            // --- IMPROVED DEBUG MESSAGE FOR EFFECTS ---
-            const char *failedEffectName = getEffectNameFromId(_effectsSentInBatch);
-            Serial.print("WARN: ACK timeout. Expected ACK for effect #");
-            Serial.print(_effectsSentInBatch);
-            Serial.print(" ('");
-            Serial.print(failedEffectName ? failedEffectName : "Unknown");
-            Serial.println("'). Resetting batch state.");
-            // --- END OF IMPROVEMENT ---
+            size_t bodyLen = getU16(&_stagedSegments[pos]);
+            decodeSegmentRecordBody(&_stagedSegments[pos + 2], bodyLen, rec); // Checked by the parser
+            applySegmentRecord(*strip, rec);
+            pos += 2 + bodyLen;
+        }
+        markConfigDirty();
+    }
+    LOG_INFO("OK: %u segment record(s) received and applied.", _segmentParser.recordsParsed());
+    discardStagedSegments();
+}
 
-            _incomingBatchState = IncomingBatchState::IDLE;
-            _effectsSentInBatch = 0;
-            _expectedEffectsToSend = 0;
-            _isSerialEffectsTest = false;
+void BinaryCommandHandler::discardStagedSegments()
+{
+    std::vector<uint8_t>().swap(_stagedSegments);
+}
+
+void BinaryCommandHandler::handleStartPixelStream(bool viaSerial, const uint8_t *data, size_t len)
+{
+    LOG_DEBUG("CMD: Pixel Stream - Initiated.");
+    if (!strip)
+    {
+        LOG_ERROR("ERR: Strip not initialized.");
+        return;
+    }
+    // Held until the stream ends: the render core stops and this core owns
+    // the output buffers
+    RenderEngine::getInstance().pause();
+    _isSerialBatch = viaSerial;
+    _pixelStream.begin(*strip);
+    _incomingBatchState = IncomingBatchState::RECEIVING_PIXEL_STREAM;
+    _streamLastRxMs = millis();
+    LOG_INFO("OK: Pixel stream started; segments paused.");
+    if (len > 0)
+    {
+        processPixelStreamData(data, len);
+    }
+}
+
+void BinaryCommandHandler::processPixelStreamData(const uint8_t *data, size_t len)
+{
+    _streamLastRxMs = millis();
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t used;
+        PixelStreamDecoder::Status status = _pixelStream.feed(data + pos, len - pos, used);
+        pos += used;
+        if (status == PixelStreamDecoder::Status::Frame)
+        {
+            uint32_t showMs = _pixelStream.frameShowMs();
+            int32_t lateMs = (int32_t)(ShowClock::getInstance().showMs(micros()) - showMs);
+            if (showMs != 0 && lateMs > (int32_t)(strip->getFrameBudgetUs() / 1000))
+                _pixelStream.stats().late++;
+            strip->present(); // Waits for the previous frame's DMA, then swaps buffers
+        }
+        else if (status == PixelStreamDecoder::Status::End)
+        {
+            endPixelStream("end marker");
+            return; // Bytes after the stream belong to the next command
         }
     }
-    // Check for ACK timeout when sending segment configs
-    else if (_incomingBatchState == IncomingBatchState::EXPECTING_SEGMENT_ACK)
+}
+
+void BinaryCommandHandler::endPixelStream(const char *reason)
+{
+    const PixelStreamStats &s = _pixelStream.stats();
+    char json[128];
+    snprintf(json, sizeof(json), "{\"pixel_stream\":{\"frames\":%lu,\"dropped\":%lu,\"late\":%lu,\"bytes\":%lu}}",
+             (unsigned long)s.frames, (unsigned long)s.dropped, (unsigned long)s.late, (unsigned long)s.bytes);
+    LOG_INFO("OK: Pixel stream ended (%s): %s", reason, json);
+    if (!_isSerialBatch)
+    {
+        BLEManager::getInstance().sendMessage(json);
+    }
+    _incomingBatchState = IncomingBatchState::IDLE;
+    _isSerialBatch = false;
+
+    // The outputs hold the last streamed frame; every segment draws again
+    strip->markAllDirty();
+    RenderEngine::getInstance().resume();
+}
+
+IncomingBatchState BinaryCommandHandler::getIncomingBatchState() const
+{
+    return _incomingBatchState;
+}
+
+void BinaryCommandHandler::queueCommand(const uint8_t *data, size_t len)
+{
+    // Replace the value of a queued update to the same parameter. Only the
+    // run of parameter updates at the back of the queue is searched: they
+    // commute with each other, but not with whatever came before them.
+    if (isCoalescable(data, len) && !receivingRawPackets())
     {
-        if (!_ackReceived && (millis() - _ackTimeoutStart > ACK_WAIT_TIMEOUT_MS))
+        // The packet being dispatched, if any, has already been read
+        int oldest = _dispatching ? 1 : 0;
+        for (int i = (int)_rxQueue.count() - 1; i >= oldest; --i)
         {
-            // --- IMPROVED DEBUG MESSAGE FOR SEGMENTS ---
-            const char *failedSegmentName = "Unknown";
-            if (strip && _segmentsSentInBatch_Out < strip->getSegments().size())
+            RxQueue::Packet queued = _rxQueue.at(i);
+            if (!isCoalescable(queued.data, queued.len))
+                break;
+            if (queued.data[1] == data[1] && queued.data[2] == data[2])
             {
-                failedSegmentName = strip->getSegments()[_segmentsSentInBatch_Out]->getName();
+                memcpy(queued.data + 3, data + 3, 4);
+                _rxCoalesced++;
+                return;
             }
-            Serial.print("WARN: ACK timeout. Expected ACK for segment #");
-            Serial.print(_segmentsSentInBatch_Out);
-            Serial.print(" ('");
-            Serial.print(failedSegmentName);
-            Serial.println("'). Resetting batch state.");
-            // --- END OF IMPROVEMENT ---
+        }
+    }
+
+    // Full, which takes a burst far beyond the app's normal rate. Nothing is
+    // applied from inside the callback: the packet is dropped, and
+    // dispatchQueued() tells the app so.
+    if (!_rxQueue.push(data, len, micros()))
+    {
+        _rxDropped++;
+        _rxDropUnreported = true;
+    }
+}
+
+void BinaryCommandHandler::dispatchQueued()
+{
+    if (_dispatching)
+        return;
+    if (_rxDropUnreported)
+    {
+        _rxDropUnreported = false;
+        LOG_ERROR("ERR: BLE RX queue full; %lu packet(s) dropped since boot.", (unsigned long)_rxDropped);
+        char reply[64];
+        int n = snprintf(reply, sizeof(reply), "{\"error\":\"RX queue full\",\"dropped\":%lu}", (unsigned long)_rxDropped);
+        BLEManager::getInstance().sendMessage((const uint8_t *)reply, n);
+    }
+    if (_rxQueue.count() == 0)
+        return;
+
+    // Hold parameter updates until the render core has moved on a frame, so
+    // the ones arriving meanwhile coalesce into them. Anything else in the
+    // queue is applied straight away, and the updates ahead of it with it.
+    uint32_t frameTick = strip ? strip->getFrameStats().framesRendered : 0;
+    if (strip && frameTick == _rxFrameTick && !receivingRawPackets())
+    {
+        bool onlyParameters = true;
+        for (uint8_t i = 0; i < _rxQueue.count() && onlyParameters; ++i)
+        {
+            RxQueue::Packet queued = _rxQueue.at(i);
+            onlyParameters = isCoalescable(queued.data, queued.len);
+        }
+        if (onlyParameters)
+            return;
+    }
+
+    _dispatching = true;
+    while (_rxQueue.count() > 0)
+    {
+        RxQueue::Packet packet = _rxQueue.front();
+        if (isCoalescable(packet.data, packet.len))
+            _rxFrameTick = frameTick;
+        handleCommand(packet.data, packet.len, packet.arrivedUs);
+        _rxQueue.pop();
+    }
+    _dispatching = false;
+}
+
+bool BinaryCommandHandler::receivingRawPackets() const
+{
+    return _incomingBatchState == IncomingBatchState::EXPECTING_ALL_SEGMENTS_COUNT ||
+           _incomingBatchState == IncomingBatchState::EXPECTING_ALL_SEGMENTS_JSON ||
+           _incomingBatchState == IncomingBatchState::RECEIVING_SEGMENT_STREAM ||
+           _incomingBatchState == IncomingBatchState::RECEIVING_PIXEL_STREAM;
+}
+
+bool BinaryCommandHandler::isSerialBatchActive() const
+{
+    return _isSerialBatch;
+}
 
+void BinaryCommandHandler::update()
+{
+    // Retransmit or give up on an outgoing transfer that stopped being ACKed
+    if (_incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK ||
+        _incomingBatchState == IncomingBatchState::EXPECTING_SEGMENT_ACK)
+    {
+        checkTransferTimeout();
+    }
+    // Abandon a segment stream that stops arriving part way through
+    else if (_incomingBatchState == IncomingBatchState::RECEIVING_SEGMENT_STREAM)
+    {
+        if (millis() - _streamLastRxMs > ACK_WAIT_TIMEOUT_MS)
+        {
+            LOG_WARN("WARN: Segment stream timed out after %u record(s); segments left unchanged.", _segmentParser.recordsParsed());
+            discardStagedSegments();
             _incomingBatchState = IncomingBatchState::IDLE;
-            _segmentsSentInBatch_Out = 0;
-            _expectedSegmentsToSend_Out = 0;
             _isSerialBatch = false;
         }
     }
+    // A host that stops streaming gives the cape back to its segments
+    else if (_incomingBatchState == IncomingBatchState::RECEIVING_PIXEL_STREAM)
+    {
+        if (millis() - _streamLastRxMs > PIXEL_STREAM_TIMEOUT_MS)
+        {
+            LOG_WARN("WARN: Pixel stream timed out.");
+            endPixelStream("timeout");
+        }
+    }
 }
 
 // NEW: buildSegmentInfoJson function
-String BinaryCommandHandler::buildSegmentInfoJson(uint8_t segmentIndex)
+String BinaryCommandHandler::buildSegmentInfoJson(uint8_t segmentIndex, int32_t seq)
 {
     if (!strip || segmentIndex >= strip->getSegments().size())
     {
@@ -401,11 +627,18 @@ String BinaryCommandHandler::buildSegmentInfoJson(uint8_t segmentIndex)
 
     StaticJsonDocument<512> doc; // Adjust size if segments can be very large
     JsonObject segObj = doc.to<JsonObject>();
+    if (seq >= 0)
+    {
+        segObj["seq"] = seq;
+    }
     segObj["id"] = s->getId();
     segObj["name"] = s->getName();
     segObj["startLed"] = s->startIndex();
     segObj["endLed"] = s->endIndex();
     segObj["brightness"] = s->getBrightness();
+    segObj["blend"] = blendModeName(s->getBlend());
+    segObj["opacity"] = s->getOpacity();
+    segObj["layer"] = s->getZOrder();
 
     if (s->activeEffect)
     {
@@ -441,124 +674,267 @@ String BinaryCommandHandler::buildSegmentInfoJson(uint8_t segmentIndex)
     return response;
 }
 
-void BinaryCommandHandler::handleGetAllSegmentConfigs(bool viaSerial)
+void BinaryCommandHandler::handleGetAllSegmentConfigs(bool viaSerial, uint8_t window)
 {
-    _isSerialBatch = viaSerial;
     if (!viaSerial)
     {
-        Serial.println("CMD: Get All Segment Configurations - Initiated.");
+        LOG_DEBUG("CMD: Get All Segment Configurations - Initiated.");
     }
+    beginTransfer(IncomingBatchState::EXPECTING_SEGMENT_ACK, strip ? strip->getSegments().size() : 0, window, viaSerial);
+}
 
-    _expectedSegmentsToSend_Out = strip ? strip->getSegments().size() : 0;
-    _segmentsSentInBatch_Out = 0;
+// --- Outgoing transfers (get all effects / get all segments) ---
+//
+// Lockstep mode (window 0) is the original protocol: after the count message
+// each ACK releases exactly one more item, and the effects list waits for an
+// ACK of the count before the first item. It never retransmits.
+//
+// Windowed mode keeps up to `window` items in flight. Each item carries a
+// "seq" field and the app answers with [CMD_ACK_GENERIC, seq MSB, seq LSB],
+// confirming every item up to and including seq. If the window stalls for
+// TRANSFER_RETRANSMIT_MS, sending goes back to the oldest unconfirmed item.
 
-    // Send count of segments first
-    uint8_t count_payload[3];
-    count_payload[0] = (uint8_t)CMD_GET_ALL_SEGMENT_CONFIGS;      // Command for batch segment config
-    count_payload[1] = (_expectedSegmentsToSend_Out >> 8) & 0xFF; // MSB
-    count_payload[2] = _expectedSegmentsToSend_Out & 0xFF;        // LSB
+void BinaryCommandHandler::beginTransfer(IncomingBatchState kind, uint16_t total, uint8_t window, bool viaSerial)
+{
+    _isSerialBatch = viaSerial;
+    _transfer.total = total;
+    _transfer.acked = 0;
+    _transfer.sent = 0;
+    _transfer.windowed = window > 0;
+    _transfer.window = window == 0 ? 1 : min(window, TRANSFER_WINDOW_MAX);
+    _transfer.waitForStartAck = !_transfer.windowed && kind == IncomingBatchState::EXPECTING_EFFECT_ACK;
+    _transfer.retries = 0;
+    _transfer.lastProgressMs = millis();
 
+    // Count message: [command, count MSB, count LSB] plus the accepted window in windowed mode
+    uint8_t count_payload[4];
+    count_payload[0] = kind == IncomingBatchState::EXPECTING_EFFECT_ACK ? (uint8_t)CMD_GET_ALL_EFFECTS
+                                                                         : (uint8_t)CMD_GET_ALL_SEGMENT_CONFIGS;
+    count_payload[1] = (total >> 8) & 0xFF;
+    count_payload[2] = total & 0xFF;
+    count_payload[3] = _transfer.window;
+    size_t count_len = _transfer.windowed ? 4 : 3;
     if (viaSerial)
     {
-        Serial.write(count_payload, 3);
+        Serial.write(count_payload, count_len);
     }
     else
     {
-        BLEManager::getInstance().sendMessage(count_payload, 3);
+        BLEManager::getInstance().sendMessage(count_payload, count_len);
     }
 
-    Serial.print("-> Sent segment count: ");
-    Serial.println(_expectedSegmentsToSend_Out);
+    LOG_DEBUG("-> Sent item count: %u, window %u%s", total, _transfer.window, _transfer.windowed ? "" : " (lockstep)");
 
-    if (_expectedSegmentsToSend_Out > 0)
+    if (total == 0)
     {
-        Serial.println("Now waiting for ACK to send first segment...");
-        _incomingBatchState = IncomingBatchState::EXPECTING_SEGMENT_ACK; // Transition to waiting for ACK
-        _ackReceived = false;                                            // Set to false to wait for the first ACK
-        _ackTimeoutStart = millis();                                     // Start timeout for the first ACK
+        LOG_INFO("OK: Nothing to send.");
+        finishTransfer();
+        return;
+    }
+    _incomingBatchState = kind;
+    pumpTransfer();
+}
+
+void BinaryCommandHandler::pumpTransfer()
+{
+    if (_transfer.waitForStartAck)
+        return;
 
-        // Send the first segment immediately after sending the count, if any segments exist
-        String segmentJson = buildSegmentInfoJson(_segmentsSentInBatch_Out);
-        if (_isSerialBatch)
+    while (_transfer.sent < _transfer.total && _transfer.sent - _transfer.acked < _transfer.window)
+    {
+        int32_t seq = _transfer.windowed ? _transfer.sent : -1;
+        if (_incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK)
         {
-            Serial.println(segmentJson);
+            sendEffectInfo(_transfer.sent, seq);
         }
         else
         {
-            BLEManager::getInstance().sendMessage(segmentJson);
+            String item = buildSegmentInfoJson(_transfer.sent, seq);
+            if (_isSerialBatch)
+            {
+                Serial.println(item);
+            }
+            else
+            {
+                BLEManager::getInstance().sendMessage(item);
+            }
         }
-        _segmentsSentInBatch_Out++;
+        _transfer.sent++;
     }
-    else
+
+    // Lockstep transfers end once the last item is out, as they always have.
+    if (!_transfer.windowed && _transfer.sent >= _transfer.total)
+    {
+        LOG_INFO("OK: All items sent.");
+        finishTransfer();
+    }
+}
+
+void BinaryCommandHandler::handleTransferAck(const uint8_t *data, size_t len)
+{
+    handleAck();
+    _transfer.lastProgressMs = millis();
+    _transfer.retries = 0;
+
+    if (_transfer.waitForStartAck)
+    {
+        _transfer.waitForStartAck = false; // That ACK was for the count message
+    }
+    else if (_transfer.windowed && len >= 3)
+    {
+        // Cumulative: everything up to and including seq has arrived.
+        // Stale or out-of-range ACKs are ignored.
+        uint16_t seq = ((uint16_t)data[1] << 8) | data[2];
+        if (seq >= _transfer.acked && seq < _transfer.sent)
+        {
+            _transfer.acked = seq + 1;
+        }
+    }
+    else if (_transfer.acked < _transfer.sent)
+    {
+        _transfer.acked++;
+    }
+
+    if (_transfer.windowed && _transfer.acked >= _transfer.total)
+    {
+        LOG_INFO("OK: All items sent and acknowledged.");
+        finishTransfer();
+        return;
+    }
+    pumpTransfer();
+}
+
+void BinaryCommandHandler::checkTransferTimeout()
+{
+    unsigned long limit = _transfer.windowed ? TRANSFER_RETRANSMIT_MS : ACK_WAIT_TIMEOUT_MS;
+    if (millis() - _transfer.lastProgressMs <= limit)
+        return;
+
+    if (_transfer.windowed && _transfer.retries < TRANSFER_MAX_RETRIES)
+    {
+        LOG_WARN("WARN: ACK timeout. Resending from item #%u", _transfer.acked);
+        _transfer.retries++;
+        _transfer.lastProgressMs = millis();
+        _transfer.sent = _transfer.acked; // Go back to the oldest unconfirmed item
+        pumpTransfer();
+        return;
+    }
+
+    const bool effects = _incomingBatchState == IncomingBatchState::EXPECTING_EFFECT_ACK;
+    const char *failedName = "Unknown";
+    if (effects)
+    {
+        const char *effectName = getEffectNameFromId(_transfer.acked);
+        if (effectName)
+            failedName = effectName;
+    }
+    else if (strip && _transfer.acked < strip->getSegments().size())
+    {
+        failedName = strip->getSegments()[_transfer.acked]->getName();
+    }
+    LOG_WARN("WARN: ACK timeout. Expected ACK for %s #%u ('%s'). Resetting batch state.",
+             effects ? "effect" : "segment", _transfer.acked, failedName);
+    finishTransfer();
+}
+
+void BinaryCommandHandler::finishTransfer()
+{
+    _incomingBatchState = IncomingBatchState::IDLE;
+    _isSerialBatch = false;
+    _transfer = OutgoingTransfer();
+}
+
+void BinaryCommandHandler::handleGetAllSegmentsBinary(bool viaSerial)
+{
+    LOG_DEBUG("CMD: Get All Segments (binary)");
+    const uint16_t count = strip ? strip->getSegments().size() : 0;
+
+    // Records are packed into one buffer and flushed when the next one would
+    // not fit, so BLE sees few, full writes instead of one per segment.
+    uint8_t buffer[256];
+    static_assert(sizeof(buffer) >= 1 + SEGMENT_STREAM_HEADER_SIZE + SEGMENT_RECORD_MAX_SIZE,
+                  "Segment stream buffer must hold the header and one record");
+    size_t used = 0;
+    buffer[used++] = (uint8_t)CMD_GET_ALL_SEGMENTS_BINARY;
+    used += encodeSegmentStreamHeader(count, buffer + used, sizeof(buffer) - used);
+
+    auto flush = [&]()
+    {
+        if (viaSerial)
+            Serial.write(buffer, used);
+        else
+            BLEManager::getInstance().sendMessage(buffer, used);
+        used = 0;
+    };
+
+    for (uint16_t i = 0; i < count; ++i)
     {
-        Serial.println("OK: No segments to send.");
-        _incomingBatchState = IncomingBatchState::IDLE; // No segments, go back to IDLE
+        PixelStrip::Segment *s = strip->getSegments()[i];
+        size_t written = encodeSegmentRecord(*s, buffer + used, sizeof(buffer) - used);
+        if (written == 0)
+        {
+            flush();
+            written = encodeSegmentRecord(*s, buffer, sizeof(buffer));
+        }
+        used += written;
     }
+    flush();
+
+    LOG_DEBUG("-> Sent %u segment record(s).", count);
 }
 
 void BinaryCommandHandler::handleGetLedCount()
 {
-    Serial.println("CMD: Get LED Count");
+    LOG_DEBUG("CMD: Get LED Count");
     uint8_t response[3];
     response[0] = (uint8_t)CMD_GET_LED_COUNT;
     response[1] = (LED_COUNT >> 8) & 0xFF;
     response[2] = LED_COUNT & 0xFF;
     BLEManager::getInstance().sendMessage(response, 3);
-    Serial.print("-> Sent LED Count: ");
-    Serial.println(LED_COUNT);
+    LOG_DEBUG("-> Sent LED Count: %u", LED_COUNT);
 }
 
-String BinaryCommandHandler::buildEffectInfoJson(uint8_t effectIndex)
+void BinaryCommandHandler::sendEffectInfo(uint8_t effectIndex, int32_t seq)
 {
-    const char *effectName = getEffectNameFromId(effectIndex);
-    if (!effectName || !strip || strip->getSegments().empty())
+    // Entries are serialized once at boot; only "seq" is added per send
+    const EffectCatalog &catalog = EffectCatalog::getInstance();
+    char withSeq[EFFECT_CATALOG_ITEM_MAX];
+    size_t len = 0;
+    const char *entry;
+    if (seq >= 0)
     {
-        return "{\"error\":\"Invalid effect index or strip not ready\"}";
+        len = catalog.itemWithSeq(effectIndex, seq, withSeq, sizeof(withSeq));
+        entry = withSeq;
     }
-    // Create a dummy segment to instantiate the effect and get its parameters
-    // This is a temporary object and will be deleted.
-    PixelStrip::Segment *dummySegment = new PixelStrip::Segment(*strip, 0, 0, "dummy", 255);
-    BaseEffect *tempEffect = createEffectByName(effectName, dummySegment);
-    if (!tempEffect)
+    else
     {
-        delete dummySegment; // Clean up dummy segment
-        return "{\"error\":\"Failed to create temporary effect\"}";
+        entry = catalog.item(effectIndex, len);
     }
-    StaticJsonDocument<512> doc;
-    doc["effect"] = tempEffect->getName();
-    JsonArray params = doc.createNestedArray("params");
-    for (int i = 0; i < tempEffect->getParameterCount(); ++i)
-    {
-        EffectParameter *p = tempEffect->getParameter(i);
-        JsonObject p_obj = params.createNestedObject();
-        p_obj["name"] = p->name;
-        switch (p->type)
-        {
-        case ParamType::INTEGER:
-            p_obj["type"] = "integer";
-            p_obj["value"] = p->value.intValue;
-            break;
-        case ParamType::FLOAT:
-            p_obj["type"] = "float";
-            p_obj["value"] = p->value.floatValue;
-            break;
-        case ParamType::COLOR:
-            p_obj["type"] = "color";
-            p_obj["value"] = p->value.colorValue;
-            break;
-        case ParamType::BOOLEAN:
-            p_obj["type"] = "boolean";
-            p_obj["value"] = p->value.boolValue;
-            break;
-        }
-        p_obj["min_val"] = p->min_val;
-        p_obj["max_val"] = p->max_val;
+    if (!entry || len == 0)
+    {
+        entry = "{\"error\":\"Invalid effect index\"}";
+        len = strlen(entry);
     }
-    String response;
-    serializeJson(doc, response);
-    delete tempEffect;   // Clean up temporary effect
-    delete dummySegment; // Clean up dummy segment
-    return response;
+
+    if (_isSerialBatch)
+    {
+        Serial.write((const uint8_t *)entry, len);
+        Serial.println();
+    }
+    else
+    {
+        BLEManager::getInstance().sendMessage((const uint8_t *)entry, len);
+    }
+}
+
+void BinaryCommandHandler::handleGetEffectCatalogHash()
+{
+    LOG_DEBUG("CMD: Get Effect Catalog Hash");
+    const EffectCatalog &catalog = EffectCatalog::getInstance();
+    uint8_t response[7];
+    response[0] = (uint8_t)CMD_GET_EFFECT_CATALOG_HASH;
+    putU16(putU32(response + 1, catalog.hash()), catalog.count());
+    BLEManager::getInstance().sendMessage(response, sizeof(response));
 }
 
 // processSingleSegmentJson is kept because it's a public method in the provided header
@@ -569,8 +945,7 @@ void BinaryCommandHandler::processSingleSegmentJson(const char *jsonString)
     DeserializationError error = deserializeJson(doc, jsonString);
     if (error)
     {
-        Serial.print("ERR: JSON parse error for segment config: ");
-        Serial.println(error.c_str());
+        LOG_ERROR("ERR: JSON parse error for segment config: %s", error.c_str());
         BLEManager::getInstance().sendMessage("{\"error\":\"JSON_PARSE_ERROR_SEGMENT\"}");
         return;
     }
@@ -578,10 +953,13 @@ void BinaryCommandHandler::processSingleSegmentJson(const char *jsonString)
     uint16_t start = doc["startLed"] | 0;
     uint16_t end = doc["endLed"] | 0;
     uint8_t brightness = doc["brightness"] | 255;
-    const char *effectNameStr = doc["effect"] | "SolidColor";
+    uint8_t effectId = effectIdFromJson(doc["effect"]); // ID or name
     uint8_t segmentId = doc["id"] | 0;
     PixelStrip::Segment *targetSeg = nullptr;
 
+    // Hold frames off until the whole segment config is applied.
+    FrameLock frameLock;
+
     // Find existing segment by ID or create a new one
     bool segmentFound = false;
     if (strip)
@@ -616,113 +994,372 @@ void BinaryCommandHandler::processSingleSegmentJson(const char *jsonString)
     if (targetSeg)
     {
         targetSeg->setBrightness(brightness);
-        if (targetSeg->activeEffect)
+        // Keep the running effect (and its state) if it is unchanged
+        if (targetSeg->getEffectId() != effectId)
         {
-            if (strcmp(targetSeg->activeEffect->getName(), effectNameStr) != 0)
-            {
-                delete targetSeg->activeEffect;
-                targetSeg->activeEffect = createEffectByName(effectNameStr, targetSeg);
-            }
-        }
-        else
-        {
-            targetSeg->activeEffect = createEffectByName(effectNameStr, targetSeg);
+            if (!targetSeg->setEffect(effectId))
+                targetSeg->clearEffect();
         }
 
-        // This block now correctly parses parameters from the top level of the JSON object.
-        // if (targetSeg->activeEffect)
-        // {
-        //     JsonObject docObj = doc.as<JsonObject>();
-        //     for (int i = 0; i < targetSeg->activeEffect->getParameterCount(); ++i)
-        //     {
-        //         EffectParameter *p = targetSeg->activeEffect->getParameter(i);
-        //         if (docObj.containsKey(p->name))
-        //         {
-        //             switch (p->type)
-        //             {
-        //             case ParamType::INTEGER:
-        //                 targetSeg->activeEffect->setParameter(p->name, docObj[p->name].as<int>());
-        //                 break;
-        //             case ParamType::FLOAT:
-        //                 targetSeg->activeEffect->setParameter(p->name, docObj[p->name].as<float>());
-        //                 break;
-        //             case ParamType::COLOR:
-        //                 targetSeg->activeEffect->setParameter(p->name, docObj[p->name].as<uint32_t>());
-        //                 break;
-        //             case ParamType::BOOLEAN:
-        //                 targetSeg->activeEffect->setParameter(p->name, docObj[p->name].as<bool>());
-        //                 break;
-        //             }
-        //         }
-        //     }
-        if (targetSeg->activeEffect)
-        {
-            JsonObject docObj = doc.as<JsonObject>();
-            JsonObject paramsSource = docObj; // Default to top-level object
-
-            // Check if there is a nested "parameters" object and use it as the source
-            if (docObj.containsKey("parameters") && docObj["parameters"].is<JsonObject>())
-            {
-                paramsSource = docObj["parameters"].as<JsonObject>();
-            }
-
-            for (int i = 0; i < targetSeg->activeEffect->getParameterCount(); ++i)
-            {
-                EffectParameter *p = targetSeg->activeEffect->getParameter(i);
-                if (paramsSource.containsKey(p->name))
-                {
-                    switch (p->type)
-                    {
-                    case ParamType::INTEGER:
-                        targetSeg->activeEffect->setParameter(p->name, paramsSource[p->name].as<int>());
-                        break;
-                    case ParamType::FLOAT:
-                        targetSeg->activeEffect->setParameter(p->name, paramsSource[p->name].as<float>());
-                        break;
-                    case ParamType::COLOR:
-                        // Handle color which may be sent as a double from the app
-                        if (paramsSource[p->name].is<double>())
-                        {
-                            targetSeg->activeEffect->setParameter(p->name, (uint32_t)paramsSource[p->name].as<double>());
-                        }
-                        else
-                        {
-                            targetSeg->activeEffect->setParameter(p->name, paramsSource[p->name].as<uint32_t>());
-                        }
-                        break;
-                    case ParamType::BOOLEAN:
-                        targetSeg->activeEffect->setParameter(p->name, paramsSource[p->name].as<bool>());
-                        break;
-                    }
-                }
-            }
-        }
+        // Parameters may sit at the top level or in a nested "parameters" object
+        JsonObjectConst docObj = doc.as<JsonObjectConst>();
+        JsonObjectConst nested = docObj["parameters"];
+        applySegmentBlend(targetSeg, docObj);
+        applyEffectParameters(targetSeg->activeEffect, nested.isNull() ? docObj : nested);
+        markConfigDirty();
 
-        Serial.print("OK: Segment ID ");
-        Serial.print(targetSeg->getId());
-        Serial.print(" (");
-        Serial.print(targetSeg->getName());
-        Serial.println(") config applied.");
+        LOG_INFO("OK: Segment ID %u (%s) config applied.", targetSeg->getId(), targetSeg->getName());
     }
     else
     {
-        Serial.println("ERR: Failed to find or create segment.");
+        LOG_ERROR("ERR: Failed to find or create segment.");
     }
-    // strip->show() is called after all segments are received in processIncomingAllSegmentsData
+    // The render engine shows the change on its next frame.
 }
 // Add the new handler function's implementation at the end of the file
 void BinaryCommandHandler::handleClearSegments()
 {
-    Serial.println("CMD: Clear Segments");
+    LOG_DEBUG("CMD: Clear Segments");
     if (strip)
     {
+        FrameLock frameLock;
         strip->clearUserSegments();
-        Serial.println("-> OK: Segments cleared.");
+        markConfigDirty();
+        LOG_INFO("-> OK: Segments cleared.");
         BLEManager::getInstance().sendMessage("{\"status\":\"OK\", \"message\":\"Segments cleared\"}");
     }
     else
     {
-        Serial.println("-> ERR: Strip not initialized.");
+        LOG_ERROR("-> ERR: Strip not initialized.");
         BLEManager::getInstance().sendMessage("{\"error\":\"Strip not initialized\"}");
     }
-}
\ No newline at end of file
+}
+
+bool BinaryCommandHandler::handleSetEffect(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Set Effect");
+    if (!strip || len < 2 || (len % 2) != 0)
+    {
+        LOG_ERROR("-> ERR: Expected [segment id, effect id] pairs.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+
+    // Segment IDs are their index in the strip (see PixelStrip::addSection).
+    // Validate every pair first so a bad one leaves the show untouched.
+    const std::vector<PixelStrip::Segment *> &segments = strip->getSegments();
+    for (size_t i = 0; i < len; i += 2)
+    {
+        if (payload[i] >= segments.size())
+        {
+            LOG_ERROR("-> ERR: Invalid segment id %u", payload[i]);
+            BLEManager::getInstance().sendMessage("{\"error\":\"Invalid segment id\"}");
+            return false;
+        }
+        if (payload[i + 1] >= EFFECT_COUNT)
+        {
+            LOG_ERROR("-> ERR: Unknown effect id %u", payload[i + 1]);
+            BLEManager::getInstance().sendMessage("{\"error\":\"Unknown effect id\"}");
+            return false;
+        }
+    }
+
+    FrameLock frameLock;
+    for (size_t i = 0; i < len; i += 2)
+    {
+        segments[payload[i]]->setEffect(payload[i + 1]);
+    }
+    markConfigDirty();
+    LOG_INFO("-> OK: Effect set on %u segment(s).", (unsigned)(len / 2));
+    return true;
+}
+
+void BinaryCommandHandler::handleSetEffectParameter(const uint8_t *payload, size_t len)
+{
+    const size_t RECORD_SIZE = 6; // segment id, param index, 4-byte value
+    if (!strip || len < RECORD_SIZE || (len % RECORD_SIZE) != 0)
+    {
+        LOG_ERROR("-> ERR: Expected [segment id, param index, value] records.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return;
+    }
+
+    const std::vector<PixelStrip::Segment *> &segments = strip->getSegments();
+    for (size_t i = 0; i < len; i += RECORD_SIZE)
+    {
+        if (payload[i] >= segments.size() || !segments[payload[i]]->activeEffect)
+        {
+            LOG_ERROR("-> ERR: No effect on segment id %u", payload[i]);
+            BLEManager::getInstance().sendMessage("{\"error\":\"Invalid segment id\"}");
+            return;
+        }
+        if (payload[i + 1] >= segments[payload[i]]->activeEffect->getParameterCount())
+        {
+            LOG_ERROR("-> ERR: Invalid parameter index %u", payload[i + 1]);
+            BLEManager::getInstance().sendMessage("{\"error\":\"Invalid parameter index\"}");
+            return;
+        }
+        // The modulation engine rewrites a bound parameter every frame
+        PixelStrip::Segment *seg = segments[payload[i]];
+        if (ModulationEngine::getInstance().isModulated(seg->getId(), payload[i + 1], seg->getEffectId()))
+        {
+            LOG_ERROR("-> ERR: Parameter %u of segment id %u is modulated", payload[i + 1], payload[i]);
+            BLEManager::getInstance().sendMessage("{\"error\":\"Parameter is modulated\"}");
+            return;
+        }
+    }
+
+    // Each record is one aligned 32-bit store the render core sees whole, and
+    // none of these parameters is written by the modulation engine on core 1,
+    // so the frame lock is not needed.
+    for (size_t i = 0; i < len; i += RECORD_SIZE)
+    {
+        segments[payload[i]]->activeEffect->setParameterRaw(payload[i + 1], getU32(payload + i + 2));
+    }
+    markConfigDirty(); // Coalesced: a slider drag is saved once it stops
+}
+
+bool BinaryCommandHandler::handleSetMtu(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Set MTU");
+    if (len != 2)
+    {
+        LOG_ERROR("-> ERR: Expected [MTU MSB, MTU LSB].");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+    BLEManager::getInstance().setMtu(((uint16_t)payload[0] << 8) | payload[1]);
+    return true;
+}
+
+bool BinaryCommandHandler::handleActivatePreset(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Activate Preset");
+    if (!strip || (len != 1 && len != 5))
+    {
+        LOG_ERROR("-> ERR: Expected [slot] or [slot, show time ms].");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+    PresetBank &bank = PresetBank::getInstance();
+    bool ok;
+    if (len == 5)
+    {
+        ok = bank.schedule(payload[0], getU32(payload + 1)); // Made by PresetBank::service()
+    }
+    else
+    {
+        ok = bank.activate(payload[0], *strip);
+    }
+    if (!ok)
+    {
+        LOG_ERROR("-> ERR: Preset slot %u is empty.", payload[0]);
+        BLEManager::getInstance().sendMessage("{\"error\":\"Empty preset slot\"}");
+        return false;
+    }
+    if (len == 5)
+    {
+        LOG_INFO("-> OK: Preset %u (%s) scheduled.", payload[0], bank.name(payload[0]));
+        return true;
+    }
+    markConfigDirty();
+    LOG_INFO("-> OK: Preset %u (%s) active.", payload[0], bank.name(payload[0]));
+    return true;
+}
+
+void BinaryCommandHandler::handleSavePreset(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Save Preset");
+    if (!strip || len < 1 || payload[0] >= PRESET_SLOTS)
+    {
+        LOG_ERROR("-> ERR: Expected [slot] then an optional name.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return;
+    }
+    char name[PRESET_NAME_MAX + 1];
+    size_t nameLen = min(len - 1, PRESET_NAME_MAX);
+    memcpy(name, payload + 1, nameLen);
+    name[nameLen] = '\0';
+
+    if (PresetBank::getInstance().save(payload[0], name, *strip))
+    {
+        LOG_INFO("-> OK: Preset %u saved.", payload[0]);
+        BLEManager::getInstance().sendMessage("{\"status\":\"OK\", \"message\":\"Preset saved\"}");
+    }
+    else
+    {
+        BLEManager::getInstance().sendMessage("{\"error\":\"Failed to save preset\"}");
+    }
+}
+
+bool BinaryCommandHandler::handleDeletePreset(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Delete Preset");
+    if (len != 1 || !PresetBank::getInstance().remove(payload[0]))
+    {
+        LOG_ERROR("-> ERR: No preset to delete.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Empty preset slot\"}");
+        return false;
+    }
+    LOG_INFO("-> OK: Preset %u deleted.", payload[0]);
+    return true;
+}
+
+void BinaryCommandHandler::handleListPresets()
+{
+    LOG_DEBUG("CMD: List Presets");
+    PresetBank &bank = PresetBank::getInstance();
+    StaticJsonDocument<1024> doc;
+    JsonArray presets = doc.createNestedArray("presets");
+    for (uint8_t slot = 0; slot < PRESET_SLOTS; ++slot)
+    {
+        if (!bank.isUsed(slot))
+            continue;
+        JsonObject p = presets.createNestedObject();
+        p["slot"] = slot;
+        p["name"] = bank.name(slot);
+        p["segments"] = bank.segmentCount(slot);
+    }
+    String response;
+    serializeJson(doc, response);
+    BLEManager::getInstance().sendMessage(response);
+}
+
+void BinaryCommandHandler::handleGetStats()
+{
+    LOG_DEBUG("CMD: Get Stats");
+    uint8_t response[TELEMETRY_PACKET_SIZE];
+    Telemetry::encode(Telemetry::getInstance().snapshot(), response);
+    BLEManager::getInstance().sendMessage(response, sizeof(response));
+}
+
+bool BinaryCommandHandler::handleSetModulation(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Set Modulation");
+    const size_t RECORD_SIZE = 7; // segment id, param index, source, low, high, 2-byte time
+    if (!strip || len < RECORD_SIZE || (len % RECORD_SIZE) != 0)
+    {
+        LOG_ERROR("-> ERR: Expected [segment id, param index, source, low, high, time] records.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+
+    auto decode = [&](size_t i)
+    {
+        return ModBinding{payload[i], payload[i + 1], (ModSource)payload[i + 2], payload[i + 3], payload[i + 4],
+                          getU16(payload + i + 5)};
+    };
+
+    ModulationEngine &mod = ModulationEngine::getInstance();
+    FrameLock frameLock;
+
+    // Every record is checked before any is applied, so a refused command
+    // changes nothing. `bound` follows which parameters would hold a binding
+    // after each record (segment id << 8 | param index), for the room check.
+    uint16_t bound[MOD_MAX_BINDINGS];
+    uint8_t boundCount = mod.count();
+    for (uint8_t b = 0; b < boundCount; ++b)
+    {
+        bound[b] = ((uint16_t)mod.binding(b).segmentId << 8) | mod.binding(b).paramIndex;
+    }
+    for (size_t i = 0; i < len; i += RECORD_SIZE)
+    {
+        uint16_t key = ((uint16_t)payload[i] << 8) | payload[i + 1];
+        uint8_t at = 0;
+        while (at < boundCount && bound[at] != key)
+            ++at;
+
+        if (payload[i + 2] == 0xFF)
+        {
+            if (at < boundCount)
+                bound[at] = bound[--boundCount];
+            continue;
+        }
+        ModBindStatus status = mod.check(*strip, decode(i));
+        if (status == ModBindStatus::Ok && at == boundCount)
+        {
+            if (boundCount < MOD_MAX_BINDINGS)
+                bound[boundCount++] = key;
+            else
+                status = ModBindStatus::Full;
+        }
+        if (status != ModBindStatus::Ok)
+        {
+            const char *message = ModulationEngine::statusMessage(status);
+            LOG_ERROR("-> ERR: Segment %u parameter %u: %s", payload[i], payload[i + 1], message);
+            char json[64];
+            snprintf(json, sizeof(json), "{\"error\":\"%s\"}", message);
+            BLEManager::getInstance().sendMessage(json);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < len; i += RECORD_SIZE)
+    {
+        if (payload[i + 2] == 0xFF)
+            mod.unbind(payload[i], payload[i + 1]);
+        else
+            mod.bind(*strip, decode(i)); // Cannot fail: checked above
+    }
+    return true;
+}
+
+bool BinaryCommandHandler::handleClearModulation(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Clear Modulation");
+    if (len > 1)
+    {
+        LOG_ERROR("-> ERR: Expected [segment id] or nothing.");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+    FrameLock frameLock;
+    ModulationEngine::getInstance().clear(len ? payload[0] : 0xFF);
+    return true;
+}
+
+void BinaryCommandHandler::handleSyncClock(const uint8_t *payload, size_t len)
+{
+    if (len != 4)
+    {
+        LOG_ERROR("-> ERR: Expected [show time ms].");
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return;
+    }
+    ShowClock::getInstance().beacon(getU32(payload), _arrivedUs); // When it was received, not when it was dispatched
+}
+
+bool BinaryCommandHandler::handleTextCommand(const uint8_t *payload, size_t len)
+{
+    LOG_DEBUG("CMD: Text Command");
+    if (len == 0 || len > TEXT_COMMAND_MAX_LENGTH)
+    {
+        LOG_ERROR("-> ERR: Expected a command line of 1 to %u bytes.", TEXT_COMMAND_MAX_LENGTH);
+        BLEManager::getInstance().sendMessage("{\"error\":\"Invalid payload\"}");
+        return false;
+    }
+
+    // The tokenizer works in place, so the line needs a writable, terminated copy
+    char line[TEXT_COMMAND_MAX_LENGTH + 1];
+    memcpy(line, payload, len);
+    line[len] = '\0';
+    // The command's output is the reply; the ACK or error follows it
+    BLETextSink out;
+    TextCommandStatus status = serialCommandHandler.handleCommand(line, out, false);
+    out.flush();
+    if (status == TextCommandStatus::Ok)
+        return true;
+
+    char reply[48];
+    int n = snprintf(reply, sizeof(reply), "{\"error\":\"%s\"}", SerialCommandHandler::statusMessage(status));
+    BLEManager::getInstance().sendMessage((const uint8_t *)reply, n);
+    return false;
+}
+
+void BinaryCommandHandler::handleGetClock()
+{
+    LOG_DEBUG("CMD: Get Clock");
+    uint8_t response[SHOWCLOCK_PACKET_SIZE];
+    ShowClock::encode(ShowClock::getInstance().status(micros()), response);
+    BLEManager::getInstance().sendMessage(response, sizeof(response));
+}
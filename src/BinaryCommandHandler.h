@@ -2,6 +2,11 @@
 #define BINARY_COMMAND_HANDLER_H
 
 #include <Arduino.h>
+#include <vector>
+#include "Config.h"
+#include "SegmentRecord.h"
+#include "PixelStream.h"
+#include "RxQueue.h"
 
 /**
  * @brief Enumerates the various binary commands that can be sent or received via BLE.
@@ -13,11 +18,37 @@ enum BleCommand : uint8_t
 {
     // GETTERS
     CMD_GET_LED_COUNT = 0x0D,           ///< Requests the current total number of LEDs.
-    CMD_GET_ALL_SEGMENT_CONFIGS = 0x0E, ///< Requests the full configuration of all segments as JSON.
-    CMD_SET_ALL_SEGMENT_CONFIGS = 0x0F, ///< Initiates receiving multiple segment configurations in a batch.
+    CMD_GET_ALL_SEGMENT_CONFIGS = 0x0E, ///< Requests the full configuration of all segments as JSON, one ACK per segment (legacy).
+    CMD_SET_ALL_SEGMENT_CONFIGS = 0x0F, ///< Initiates receiving segment JSON configs, one ACK per segment (legacy).
     CMD_GET_ALL_EFFECTS = 0x10,         ///< Requests detailed information for all available effects.
     CMD_SAVE_CONFIG = 0x12,             ///< Saves the current configuration to persistent storage.
     CMD_CLEAR_SEGMENTS = 0x06,          ///< Clears all segment configurations.
+    CMD_GET_ALL_SEGMENTS_BINARY = 0x14, ///< Requests every segment as one binary segment stream (SegmentRecord.h).
+    CMD_SET_ALL_SEGMENTS_BINARY = 0x13, ///< Replaces all segments from a binary segment stream, which may span packets.
+    CMD_LIST_PRESETS = 0x19,            ///< Requests the preset slots in use as JSON: slot, name and segment count.
+    CMD_GET_STATS = 0x1A,               ///< Requests live performance counters as one binary packet (Telemetry.h).
+
+    // MODULATION (Modulation.h)
+    CMD_SET_MODULATION = 0x1B,   ///< Binds parameters to sources. Payload: one or more [segment id, param index, source, low, high, time ms (2 bytes)]; source 0xFF unbinds.
+    CMD_CLEAR_MODULATION = 0x1C, ///< Removes bindings. Payload: [segment id], or nothing for all of them.
+
+    // SHOW CLOCK (ShowClock.h)
+    CMD_SYNC_CLOCK = 0x1D, ///< Time beacon, not ACKed. Payload: [show time ms (4 bytes)].
+    CMD_GET_CLOCK = 0x1E,  ///< Requests the show time and sync state as one binary packet.
+
+    CMD_PIXEL_STREAM = 0x1F, ///< Segments stop and every following byte is a pixel stream (PixelStream.h) until its end marker.
+    CMD_TEXT_COMMAND = 0x20, ///< Runs a serial console command line. Payload: the line's text. Replies with the command's text output, then the generic ACK or an error.
+    CMD_GET_EFFECT_CATALOG_HASH = 0x21, ///< Requests the effect catalog's hash and effect count (EffectCatalog.h), to skip CMD_GET_ALL_EFFECTS when unchanged.
+
+    // PRESETS (PresetBank.h)
+    CMD_ACTIVATE_PRESET = 0x16, ///< Switches to a stored preset within one frame. Payload: [slot], then optionally the show time to switch at (4 bytes).
+    CMD_SAVE_PRESET = 0x17,     ///< Stores the current segments as a preset. Payload: [slot] then an optional name.
+    CMD_DELETE_PRESET = 0x18,   ///< Deletes a preset. Payload: [slot].
+
+    // SETTERS
+    CMD_SET_EFFECT = 0x02,           ///< Sets effects by ID. Payload: one or more [segment id, effect id] byte pairs.
+    CMD_SET_EFFECT_PARAMETER = 0x0A, ///< Sets parameters by index. Payload: one or more [segment id, param index, value (4 bytes, big-endian)].
+    CMD_SET_MTU = 0x15,              ///< Reports the negotiated ATT MTU. Payload: [MTU MSB, MTU LSB].
 
     CMD_ACK_GENERIC = 0xA0, ///< Generic acknowledgment for a received command.
 
@@ -36,8 +67,10 @@ enum class IncomingBatchState
     // Removed EXPECTING_BATCH_CONFIG_JSON as it's no longer used.
     EXPECTING_ALL_SEGMENTS_COUNT, ///< Expecting the total count of segments for a batch update.
     EXPECTING_ALL_SEGMENTS_JSON,  ///< Expecting individual segment JSON payloads.
-    EXPECTING_EFFECT_ACK,         ///< Waiting for an ACK before sending the next effect's info.
-    EXPECTING_SEGMENT_ACK         ///< Waiting for an ACK before sending the next segment's info.
+    EXPECTING_EFFECT_ACK,         ///< Sending effect info; waiting for ACKs to release more.
+    EXPECTING_SEGMENT_ACK,        ///< Sending segment info; waiting for ACKs to release more.
+    RECEIVING_SEGMENT_STREAM,     ///< Feeding incoming packets to the binary segment parser.
+    RECEIVING_PIXEL_STREAM        ///< Feeding incoming packets to the pixel stream decoder.
 };
 
 /**
@@ -60,14 +93,39 @@ public:
      * @brief Processes an incoming raw binary command.
      * @param data A pointer to the raw byte array of the command.
      * @param len The length of the command data.
+     * @param arrivedUs micros() when the command was received; time beacons are measured from it.
+     */
+    void handleCommand(const uint8_t *data, size_t len, uint32_t arrivedUs = micros());
+
+    /**
+     * @brief Queues a packet received over BLE for dispatchQueued().
+     * @details Called from the BLE write callback, inside BLE.poll(), so it
+     * only copies the packet. A parameter update for the same segment and
+     * parameter as one still waiting replaces that one's value instead. A
+     * packet that does not fit is dropped and counted; the next
+     * dispatchQueued() reports it to the app as {"error":"RX queue full"}.
+     */
+    void queueCommand(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Applies the queued BLE packets, in the order they arrived.
+     * @details Call once per loop pass. Parameter updates are held until the
+     * render core has started a new frame since the last ones were applied,
+     * so a burst of slider packets is applied once per frame.
      */
-    void handleCommand(const uint8_t *data, size_t len);
+    void dispatchQueued();
+
+    /** @brief Parameter updates merged into a queued one since boot, packets dropped because the queue was full, and the most packets ever queued. */
+    uint32_t getRxCoalesced() const { return _rxCoalesced; }
+    uint32_t getRxDropped() const { return _rxDropped; }
+    uint8_t getRxQueuePeak() const { return _rxQueue.peak(); }
 
     /**
      * @brief Initiates the process of sending all segment configurations.
      * @param viaSerial If true, sends output to Serial; otherwise, sends via BLE.
+     * @param window Items kept in flight; 0 selects the original one-ACK-per-item protocol.
      */
-    void handleGetAllSegmentConfigs(bool viaSerial);
+    void handleGetAllSegmentConfigs(bool viaSerial, uint8_t window = 0);
 
     /**
      * @brief Initiates the process of receiving all segment configurations in a batch.
@@ -75,11 +133,36 @@ public:
      */
     void handleSetAllSegmentConfigsCommand(bool viaSerial);
 
+    /**
+     * @brief Sends every segment as a binary segment stream, without per-segment ACKs.
+     * @param viaSerial If true, writes the stream to Serial; otherwise, sends via BLE.
+     */
+    void handleGetAllSegmentsBinary(bool viaSerial);
+
+    /**
+     * @brief Starts receiving a binary segment stream that will replace the user segments.
+     * @details The segments are left alone until the whole stream is in; see
+     * processSegmentStreamData().
+     * @param viaSerial If true, the stream is read from Serial; otherwise, from BLE.
+     * @param data Any stream bytes that arrived with the command itself.
+     * @param len Length of `data`.
+     */
+    void handleSetAllSegmentsBinary(bool viaSerial, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Pauses segment rendering and starts decoding a pixel stream.
+     * @param viaSerial If true, the stream is read from Serial; otherwise, from BLE.
+     * @param data Any stream bytes that arrived with the command itself.
+     * @param len Length of `data`.
+     */
+    void handleStartPixelStream(bool viaSerial, const uint8_t *data, size_t len);
+
     /**
      * @brief Initiates the process of sending information for all available effects.
      * @param viaSerial If true, sends output to Serial; otherwise, sends via BLE.
+     * @param window Items kept in flight; 0 selects the original one-ACK-per-item protocol.
      */
-    void handleGetAllEffectsCommand(bool viaSerial);
+    void handleGetAllEffectsCommand(bool viaSerial, uint8_t window = 0);
 
     /**
      * @brief Gets the current state of the incoming batch processing.
@@ -109,19 +192,43 @@ private:
     char _incomingJsonBuffer[1024];                 ///< Buffer to accumulate incoming JSON data for multi-part commands.
     size_t _jsonBufferIndex;                        ///< Current index/length of data in `_incomingJsonBuffer`.
     IncomingBatchState _incomingBatchState;         ///< Current state of the incoming multi-part command handler.
-    bool _isSerialEffectsTest;                      ///< Flag to indicate if effects info is being sent via Serial for testing.
     bool _isSerialBatch;                            ///< Flag to indicate if the current batch operation is via Serial.
-    volatile bool _ackReceived;                     ///< Flag set when an ACK is received (used for handshake).
-    unsigned long _ackTimeoutStart;                 ///< @brief Timestamp when ACK waiting started.
     const unsigned long ACK_WAIT_TIMEOUT_MS = 5000; ///< @brief Timeout duration in milliseconds for waiting for an ACK.
     uint16_t _expectedSegmentsToReceive;            ///< Expected number of segments in an incoming batch.
     uint16_t _segmentsReceivedInBatch;              ///< Number of segments received so far in a batch.
-    uint16_t _expectedEffectsToSend;                ///< Total number of effects to send.
-    uint16_t _effectsSentInBatch;                   ///< Number of effects sent so far.
 
-    // NEW variables for outgoing segment batch
-    uint16_t _expectedSegmentsToSend_Out; ///< Total number of segments to send in an outgoing batch.
-    uint16_t _segmentsSentInBatch_Out;    ///< Number of segments sent so far in an outgoing batch.
+    /**
+     * @brief Progress of an outgoing effect or segment transfer.
+     * @details Items [acked, sent) are in flight; at most `window` of them.
+     */
+    struct OutgoingTransfer
+    {
+        uint16_t total = 0;            ///< Items to send.
+        uint16_t acked = 0;            ///< Items the app has confirmed.
+        uint16_t sent = 0;             ///< Next item to send.
+        uint8_t window = 1;            ///< Items allowed in flight.
+        bool windowed = false;         ///< Sequence-numbered items and cumulative ACKs.
+        bool waitForStartAck = false;  ///< Lockstep effects list: hold the first item until the count is ACKed.
+        uint8_t retries = 0;           ///< Retransmissions since the last ACK.
+        unsigned long lastProgressMs = 0;
+    };
+    OutgoingTransfer _transfer;
+
+    SegmentRecordParser _segmentParser; ///< Parser for incoming binary segment streams (BLE and Serial).
+    PixelStreamDecoder _pixelStream;    ///< Decoder for host-rendered frames (BLE and Serial).
+    unsigned long _streamLastRxMs;      ///< When the last segment stream bytes arrived; used for the timeout.
+    std::vector<uint8_t> _stagedSegments; ///< Length-prefixed record bodies of the stream being received, applied when it ends.
+
+    RxQueue _rxQueue;           ///< BLE packets waiting for dispatchQueued().
+    uint32_t _rxFrameTick;      ///< FrameStats::framesRendered when parameter updates were last applied.
+    uint32_t _rxCoalesced;      ///< Parameter updates merged into one still queued, since boot.
+    uint32_t _rxDropped;        ///< Packets dropped because the queue was full, since boot.
+    bool _rxDropUnreported;     ///< A packet was dropped since the app was last told.
+    uint32_t _arrivedUs;        ///< Receive time of the command being handled.
+    bool _dispatching;          ///< Inside dispatchQueued(); the queue must not be drained re-entrantly.
+
+    /** @brief True while incoming packets are stream data rather than commands. */
+    bool receivingRawPackets() const;
 
     // --- Helper Functions ---
     // Removed sendAck and sendNack as they are no longer used in the new protocol.
@@ -141,18 +248,24 @@ private:
     void handleGetLedCount();
 
     /**
-     * @brief Builds a JSON string containing information about a specific effect.
-     * @param effectIndex The index of the effect to build info for.
-     * @return A String containing the JSON representation of the effect's info.
+     * @brief Runs the payload through the text command core (SerialCommandHandler).
+     * @return True if the command ran; otherwise an error reply has been sent.
+     */
+    bool handleTextCommand(const uint8_t *payload, size_t len);
+
+    /**
+     * @brief Sends one effect's catalog entry (EffectCatalog.h).
+     * @param seq Transfer sequence number to include as "seq", or -1 for none.
      */
-    String buildEffectInfoJson(uint8_t effectIndex);
+    void sendEffectInfo(uint8_t effectIndex, int32_t seq = -1);
 
     /**
      * @brief Builds a JSON string containing information about a specific segment.
      * @param segmentIndex The index of the segment to build info for.
+     * @param seq Transfer sequence number to include as "seq", or -1 for none.
      * @return A String containing the JSON representation of the segment's info.
      */
-    String buildSegmentInfoJson(uint8_t segmentIndex);
+    String buildSegmentInfoJson(uint8_t segmentIndex, int32_t seq = -1);
 
     /**
      * @brief Processes incoming data for multi-part commands (batch config, all segments).
@@ -161,12 +274,116 @@ private:
      */
     void processIncomingAllSegmentsData(const uint8_t *data, size_t len);
 
+    /**
+     * @brief Feeds a binary segment stream packet to the parser, staging each
+     * record as it is completed.
+     * @details Once the last record is in, applyStagedSegments() replaces the
+     * user segments. A stream that fails or times out is dropped and the
+     * running segments are untouched.
+     */
+    void processSegmentStreamData(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Clears the user segments and applies every staged record under
+     * one FrameLock, so the render core goes from the old segments to the
+     * new ones between two frames.
+     */
+    void applyStagedSegments();
+
+    /** @brief Drops the staged records and frees their memory. */
+    void discardStagedSegments();
+
+    /**
+     * @brief Feeds pixel stream bytes to the decoder, presenting each frame
+     * as soon as its last byte is in.
+     */
+    void processPixelStreamData(const uint8_t *data, size_t len);
+
+    /** @brief Leaves pixel-stream mode, resumes the segments and reports the stream's statistics. */
+    void endPixelStream(const char *reason);
+
+    /**
+     * @brief Sends the count message and starts an outgoing transfer.
+     * @param kind EXPECTING_EFFECT_ACK or EXPECTING_SEGMENT_ACK.
+     */
+    void beginTransfer(IncomingBatchState kind, uint16_t total, uint8_t window, bool viaSerial);
+
+    /**
+     * @brief Sends items until the window is full or everything is out.
+     */
+    void pumpTransfer();
+
+    /**
+     * @brief Advances the transfer on an ACK: [CMD_ACK_GENERIC] confirms one
+     * item, [CMD_ACK_GENERIC, seq MSB, seq LSB] every item up to seq.
+     */
+    void handleTransferAck(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Called from update(): retransmits a stalled window, or abandons
+     * the transfer once the retries are spent.
+     */
+    void checkTransferTimeout();
+
+    void finishTransfer();
+
     /**
      * @brief Handles the reception of an ACK.
      */
     void handleAck();
 
     void handleClearSegments();
+
+    /**
+     * @brief Handles the Set Effect command: applies every (segment id, effect id)
+     * pair in the payload, or none of them if any pair is invalid.
+     * @return True if the effects were applied (the caller sends the generic ACK).
+     */
+    bool handleSetEffect(const uint8_t *payload, size_t len);
+
+    /**
+     * @brief Handles the Set Effect Parameter command, meant for streaming live
+     * slider changes: no JSON, no name lookups, and no ACK on success.
+     * @details Values use BaseEffect::setParameterRaw's wire form. The payload is
+     * validated in full before any parameter is written; a parameter with an
+     * active modulation binding is refused, since the render core would
+     * overwrite it on the next frame.
+     */
+    void handleSetEffectParameter(const uint8_t *payload, size_t len);
+
+    /**
+     * @brief Handles the Set MTU command, which sizes BLE notifications.
+     * @return True if the MTU was applied (the caller sends the generic ACK).
+     */
+    bool handleSetMtu(const uint8_t *payload, size_t len);
+
+    /**
+     * @brief Preset commands (PresetBank.h). Activate and delete return true
+     * on success, for the generic ACK; save replies with a status message.
+     */
+    bool handleActivatePreset(const uint8_t *payload, size_t len);
+    void handleSavePreset(const uint8_t *payload, size_t len);
+    bool handleDeletePreset(const uint8_t *payload, size_t len);
+    void handleListPresets();
+
+    /** @brief Replies with the Telemetry packet. */
+    void handleGetStats();
+
+    /**
+     * @brief Modulation commands (Modulation.h); true on success, for the
+     * generic ACK. Set records are all checked first and applied in order;
+     * if any cannot be bound, none are, and the error names the first.
+     */
+    bool handleSetModulation(const uint8_t *payload, size_t len);
+    bool handleClearModulation(const uint8_t *payload, size_t len);
+
+    /** @brief Feeds a time beacon to the ShowClock. */
+    void handleSyncClock(const uint8_t *payload, size_t len);
+    /** @brief Replies with the ShowClock packet. */
+    void handleGetClock();
+
+    /** @brief Replies with [command, catalog hash (4 bytes), effect count (2 bytes)], big-endian. */
+    void handleGetEffectCatalogHash();
 };
 
 #endif // BINARY_COMMAND_HANDLER_H
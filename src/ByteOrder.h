@@ -0,0 +1,44 @@
+/**
+ * @file ByteOrder.h
+ * @brief Big-endian field access for the wire and on-flash formats.
+ *
+ * @details Every binary format here (BLE packets, segment records, the state
+ * file, presets, telemetry) stores multi-byte fields most significant byte
+ * first, at any alignment. The writers return the byte after the field, so a
+ * packet can be built with `p = putU16(p, v)`.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef BYTE_ORDER_H
+#define BYTE_ORDER_H
+
+#include <stdint.h>
+
+inline uint8_t *putU16(uint8_t *out, uint16_t v)
+{
+    out[0] = v >> 8;
+    out[1] = v & 0xFF;
+    return out + 2;
+}
+
+inline uint8_t *putU32(uint8_t *out, uint32_t v)
+{
+    out[0] = v >> 24;
+    out[1] = (v >> 16) & 0xFF;
+    out[2] = (v >> 8) & 0xFF;
+    out[3] = v & 0xFF;
+    return out + 4;
+}
+
+inline uint16_t getU16(const uint8_t *in)
+{
+    return ((uint16_t)in[0] << 8) | in[1];
+}
+
+inline uint32_t getU32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+#endif // BYTE_ORDER_H
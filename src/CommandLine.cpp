@@ -0,0 +1,54 @@
+/**
+ * @file CommandLine.cpp
+ * @brief In-place command tokenizer.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "CommandLine.h"
+
+namespace
+{
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    char *skipBlanks(char *p)
+    {
+        while (p && isBlank(*p))
+            ++p;
+        return p;
+    }
+}
+
+char *CommandArgs::next()
+{
+    char *word = skipBlanks(next_);
+    if (!word || !*word)
+    {
+        next_ = nullptr;
+        return nullptr;
+    }
+    char *end = word;
+    while (*end && !isBlank(*end))
+        ++end;
+    if (*end)
+        *end++ = '\0';
+    next_ = end;
+    return word;
+}
+
+char *CommandArgs::rest()
+{
+    char *text = skipBlanks(next_);
+    next_ = nullptr;
+    if (!text || !*text)
+        return nullptr;
+    // Trailing blanks too, such as the CR of a CRLF line ending
+    char *end = text + strlen(text);
+    while (isBlank(end[-1]))
+        --end;
+    *end = '\0';
+    return text;
+}
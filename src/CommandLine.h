@@ -0,0 +1,38 @@
+/**
+ * @file CommandLine.h
+ * @brief In-place tokenizer for text commands.
+ *
+ * @details Splits a mutable command line into words by writing NULs into it,
+ * the way strtok_r does, so a command and its arguments are parsed without
+ * copying or allocating. Words are separated by any run of spaces, tabs, CR
+ * or LF. A null line behaves like an empty one, so a handler can start
+ * tokenizing its arguments without checking whether there were any.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <Arduino.h>
+
+class CommandArgs
+{
+public:
+    explicit CommandArgs(char *text) : next_(text) {}
+
+    /// The next word, or nullptr once there are none left.
+    char *next();
+
+    /**
+     * @brief Everything after the words taken so far, for trailing free text
+     * such as a name or JSON, without leading or trailing blanks; nullptr if
+     * nothing is left.
+     */
+    char *rest();
+
+private:
+    char *next_; ///< Where the next word starts looking; nullptr once the line is used up
+};
+
+#endif // COMMAND_LINE_H
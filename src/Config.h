@@ -3,27 +3,161 @@
 
 #pragma once
 #include <stdint.h>
-#include <LittleFS_Mbed_RP2040.h>
+#include <stddef.h>
+#include "pinMap.h"
 
 // —— Pin Definitions ——
 constexpr uint8_t LEDR_PIN = 25;
 constexpr uint8_t LEDG_PIN = 26;
 constexpr uint8_t LEDB_PIN = 27;
-constexpr uint8_t LED_PIN  = 4;
+constexpr uint8_t LED_DATA_PIN = D12_GPIO;
+
+// —— LED Outputs ——
+// The logical strip is the outputs' LEDs end to end: output 0 drives the first
+// LEDS_PER_OUTPUT[0] LEDs, output 1 the next LEDS_PER_OUTPUT[1], and so on.
+// LED_COUNT defaults to their sum; when it is changed at run time (setledcount)
+// the last output takes up the difference. Segments address the logical
+// strip, so one can sit on any output or run across several. Each output has
+// its own PIO1 state machine and DMA channel, so all of them clock out at once
+// and a frame takes as long as the longest output. PIO0 is left to the PDM
+// microphone.
+constexpr uint8_t  LED_OUTPUT_COUNT = 1;  // 1-4 (state machines on one PIO)
+constexpr uint8_t  LED_OUTPUT_PINS[4] = {LED_DATA_PIN, D4_GPIO, D5_GPIO, D6_GPIO};
+constexpr uint16_t LEDS_PER_OUTPUT[LED_OUTPUT_COUNT] = {585}; // One count per output, in strip order
+constexpr uint16_t LEDS_PER_OUTPUT_MAX = 4000;
+static_assert(LED_OUTPUT_COUNT >= 1 && LED_OUTPUT_COUNT <= 4, "LED_OUTPUT_COUNT must be 1-4");
+
+constexpr uint32_t ledsOnOutputs(uint8_t count)
+{
+    uint32_t sum = 0;
+    for (uint8_t o = 0; o < count; ++o)
+        sum += LEDS_PER_OUTPUT[o];
+    return sum;
+}
+constexpr bool outputCountsFit()
+{
+    for (uint8_t o = 0; o < LED_OUTPUT_COUNT; ++o)
+    {
+        if (LEDS_PER_OUTPUT[o] == 0 || LEDS_PER_OUTPUT[o] > LEDS_PER_OUTPUT_MAX)
+            return false;
+    }
+    return true;
+}
+static_assert(outputCountsFit(), "Every LEDS_PER_OUTPUT entry must be 1-LEDS_PER_OUTPUT_MAX");
+
+constexpr uint16_t LED_COUNT_DEFAULT = ledsOnOutputs(LED_OUTPUT_COUNT);
+// The largest run-time LED_COUNT: the earlier outputs as configured, the last one full
+constexpr uint16_t LED_COUNT_MAX = ledsOnOutputs(LED_OUTPUT_COUNT - 1) + LEDS_PER_OUTPUT_MAX;
 
 // —— LED Strip Configuration ——
 extern uint16_t LED_COUNT;
 constexpr uint8_t  BRIGHTNESS    = 10;
 constexpr uint8_t  SEGMENT_COUNT = 0;
-constexpr uint16_t EFFECT_SCRATCHPAD_SIZE = 600;
+constexpr uint16_t EFFECT_ARENA_SIZE = 8192; // Scratch memory shared out per segment to buffered effects
+constexpr uint16_t EFFECT_STORAGE_SIZE = 256; // In-segment storage for the active effect; must fit the largest class in EFFECT_LIST
+
+// —— Rendering ——
+// When true, segment updates and strip output run on core 1 (see RenderEngine).
+constexpr bool     RENDER_ON_SECOND_CORE  = true;
+constexpr uint16_t RENDER_CORE_STACK_SIZE = 4096;
+constexpr uint8_t  TARGET_FPS             = 60;  // Default frame scheduler rate
+// Output stage (PixelStrip::show): segment brightness, global brightness and
+// gamma are applied there through per-segment lookup tables
+constexpr uint8_t  GLOBAL_BRIGHTNESS      = 255;
+constexpr float    OUTPUT_GAMMA           = 2.2f; // 1.0 turns gamma correction off
+
+// —— Modulation ——
+constexpr uint8_t MOD_MAX_BINDINGS = 16;    // Parameters that can be modulated at once, across all segments (Modulation.h)
+constexpr float   MOD_ACCEL_RANGE_G = 2.0f; // Acceleration that drives an accelerometer source to full level
+
+// —— Show Clock ——
+// Shared show time across devices (ShowClock.h)
+constexpr uint32_t SHOWCLOCK_STEP_MS = 250;             // Beacon errors beyond this step the clock instead of slewing it
+constexpr uint8_t  SHOWCLOCK_PHASE_SHIFT = 2;           // Each beacon corrects 1/4 of the phase error, and the rate likewise
+constexpr int32_t  SHOWCLOCK_MAX_PPM = 500;             // Largest rate correction; crystals are good to ~50 ppm
+constexpr uint32_t SHOWCLOCK_REANCHOR_MS = 60000;       // Mapping refresh, well inside the 71-minute micros() wrap
+constexpr uint32_t SHOWCLOCK_BEACON_TIMEOUT_MS = 30000; // Reported as unsynced after this long without a beacon
+
+// —— Telemetry ——
+constexpr uint32_t TELEMETRY_WINDOW_MS = 1000; // Loop, audio and FPS figures cover the last complete window (Telemetry.h)
+
+// —— Benchmark ——
+// Defaults for the serial `bench` command (EffectBench.h)
+constexpr uint16_t BENCH_DEFAULT_FRAMES = 200;
+constexpr uint16_t BENCH_DEFAULT_LENGTHS[] = {30, 150, 585};
+constexpr uint8_t  BENCH_MAX_LENGTHS = 8;
+static_assert(sizeof(BENCH_DEFAULT_LENGTHS) / sizeof(BENCH_DEFAULT_LENGTHS[0]) <= BENCH_MAX_LENGTHS,
+              "BENCH_DEFAULT_LENGTHS has more entries than BENCH_MAX_LENGTHS");
+
+// —— Bluetooth ——
+constexpr uint16_t BLE_TX_QUEUE_SIZE       = 4096; // Outgoing notification queue drained by BLEManager::update()
+constexpr uint16_t BLE_TX_MAX_CHUNK        = 512;  // Largest notification; the TX characteristic's size
+constexpr uint8_t  BLE_TX_CHUNKS_PER_POLL  = 4;    // Notifications issued per update() before yielding
+constexpr uint16_t BLE_TX_FLUSH_TIMEOUT_MS = 250;  // How long sendMessage may block when the queue is full
+constexpr uint16_t BLE_RX_QUEUE_SIZE       = 2048; // Received packets waiting for BinaryCommandHandler::dispatchQueued() (RxQueue.h)
+constexpr uint8_t  BLE_RX_QUEUE_PACKETS    = 32;   // Most packets that can wait at once
+constexpr uint8_t  TEXT_COMMAND_MAX_LENGTH = 255;  // Longest command line CMD_TEXT_COMMAND accepts, like a serial line
+
+// —— Logging ——
+// Levels are filtered at compile time by LOG_LEVEL (see Log.h).
+constexpr uint16_t LOG_LINE_MAX   = 160;  // Longest formatted log line
+constexpr uint16_t LOG_RING_SIZE  = 2048; // Ring sink buffer; full lines are dropped when it runs out
+constexpr uint16_t LOG_POLL_BYTES = 64;   // Ring output written to Serial per logPoll()
+
+// —— Multi-part Transfers ——
+// Windowed "get all effects/segments" transfers (see BinaryCommandHandler).
+constexpr uint8_t       TRANSFER_WINDOW_MAX    = 8;   // Largest window an app may request
+constexpr unsigned long TRANSFER_RETRANSMIT_MS = 300; // Stall time before resending the window
+constexpr uint8_t       TRANSFER_MAX_RETRIES   = 3;   // Resends without progress before giving up
+constexpr uint16_t      EFFECT_CATALOG_SIZE     = 3072; // Every effect's serialized entry, built at boot (EffectCatalog.h); about 2.2 KB with 11 effects
+constexpr uint16_t      EFFECT_CATALOG_ITEM_MAX = 512;  // Longest entry as sent, "seq" included
+constexpr uint16_t      SEGMENT_STREAM_STAGING_MAX = 8192; // Largest binary segment stream held until it is complete (SegmentRecord.h)
+constexpr unsigned long PIXEL_STREAM_TIMEOUT_MS = 2000; // A pixel stream with no bytes for this long ends (PixelStream.h)
 
 // —— Accelerometer & Step Detection ——
+// Thresholds are on the acceleration magnitude, in g (MotionSensor).
 constexpr float        STEP_THRESHOLD      = 2.5f;
 constexpr unsigned long STEP_COOLDOWN_MS    = 300;
+constexpr float        IMU_IMPACT_THRESHOLD = 3.5f;  // A step this hard is reported as an impact (full scale is 4 g)
+constexpr float        IMU_RELEASE_RATIO    = 0.8f;  // An event ends below STEP_THRESHOLD * ratio
+constexpr unsigned long IMU_POLL_INTERVAL_MS = 20;   // FIFO drain cadence; ~2 samples per batch at 104 Hz
+constexpr uint16_t     IMU_SAMPLE_RATE_HZ   = 104;   // Accelerometer ODR set by Arduino_LSM6DSOX
+constexpr uint8_t      IMU_FIFO_BATCH_MAX   = 16;    // Most FIFO samples read per poll; the rest wait for the next
 
 // —— Audio Input ——
 constexpr int SAMPLES         = 256;
 constexpr int SAMPLING_FREQ   = 16000;
+constexpr bool AUDIO_USE_FFT_BACKEND = false; // true: ArduinoFFT<double> reference; false: integer Goertzel (AudioAnalysis.h)
+constexpr size_t AUDIO_RING_SAMPLES     = 2048; // PDM-to-analysis ring (AudioRing.h), 128 ms; a power of two
+constexpr size_t AUDIO_HOP_SIZE         = 128;  // Samples between analysis frames; SAMPLES - hop overlap
+constexpr size_t AUDIO_MAX_BACKLOG_HOPS = 12;   // Queued hops beyond one frame (~100 ms) before old audio is skipped
+static_assert(AUDIO_HOP_SIZE > 0 && AUDIO_HOP_SIZE <= (size_t)SAMPLES && SAMPLES % AUDIO_HOP_SIZE == 0,
+              "AUDIO_HOP_SIZE must divide SAMPLES");
+static_assert(AUDIO_RING_SAMPLES >= SAMPLES + (AUDIO_MAX_BACKLOG_HOPS + 1) * AUDIO_HOP_SIZE,
+              "AUDIO_RING_SAMPLES cannot hold the allowed backlog");
+
+// —— Audio Features ——
+// Level scaling and beat tracking for the AudioFeatures snapshot (AudioFeatures.h).
+// Rates are per analysis frame (every AUDIO_HOP_SIZE samples, 8 ms by default).
+constexpr float         AUDIO_BACKGROUND_RATE      = 0.015f;  // Background follows a band over ~0.5 s
+constexpr float         AUDIO_PEAK_DECAY           = 0.9975f; // Peak halves in ~2 s of quiet
+constexpr float         AUDIO_BAND_MIN_RANGE       = 2000.0f; // Smallest magnitude span scaled to a full bandLevel
+constexpr float         AUDIO_RMS_MIN_RANGE        = 200.0f;  // Same, for rmsLevel
+constexpr uint8_t       AUDIO_ONSET_DELTA          = 64;      // bandLevel rise over one frame length that counts as an onset
+constexpr unsigned long AUDIO_BEAT_MIN_INTERVAL_MS = 250;     // Bass onsets closer than this are not new beats
+constexpr unsigned long AUDIO_BEAT_TIMEOUT_MS      = 2000;    // Longer beat gaps leave the tempo estimate alone
+constexpr float         AUDIO_BPM_MIN              = 60.0f;   // Tempo estimates are folded into this octave
+constexpr float         AUDIO_BPM_MAX              = 180.0f;
+constexpr float         AUDIO_BPM_SMOOTHING        = 0.25f;   // Weight of each new beat interval
+
+// —— Persistence ——
+constexpr size_t STATE_EFFECT_TABLE_SIZE = 512; // Effect-name table in the state file (StateFile.h)
+constexpr uint8_t STATE_SLOTS_PER_STEP = 2;     // Segment slots written per main-loop pass while saving
+constexpr uint8_t PRESET_SLOTS = 8;             // Preset slots, each a file on LittleFS (PresetBank.h)
+// Autosave: changes are saved once nothing has changed for the quiet period,
+// or after the maximum delay if changes keep coming.
+constexpr uint32_t CONFIG_AUTOSAVE_QUIET_MS = 3000;
+constexpr uint32_t CONFIG_AUTOSAVE_MAX_DELAY_MS = 30000;
 
 // NOTE: The definition for STATE_FILE has been removed from here.
 // It is now defined in main.cpp and declared extern in globals.h
@@ -4,6 +4,9 @@
 #include <LittleFS_Mbed_RP2040.h>
 #include "EffectLookup.h"
 #include "BLEManager.h"
+#include "RenderEngine.h"
+#include "Log.h"
+#include "StateFile.h"
 
 // --- External globals defined in main.cpp ---
 extern PixelStrip *strip;
@@ -11,76 +14,84 @@ extern uint16_t LED_COUNT;
 extern const char *STATE_FILE;
 extern BLEManager &bleManager;
 
+// --- Autosave state ---
+namespace
+{
+    bool configDirty = false;
+    bool autosaveForced = false; // The running save was started by the maximum delay
+    uint32_t firstDirtyMs = 0;
+    uint32_t lastDirtyMs = 0;
+}
+
 // --- Saves the complete strip configuration ---
 bool saveConfig()
 {
-    StaticJsonDocument<2048> doc;
-    doc["led_count"] = LED_COUNT;
+    if (!saveState(strip, LED_COUNT))
+        return false;
+    configDirty = false;
+    return true;
+}
 
-    JsonArray segments = doc.createNestedArray("segments");
-    if (strip)
+void markConfigDirty()
+{
+    uint32_t now = millis();
+    if (!configDirty)
+        firstDirtyMs = now;
+    configDirty = true;
+    lastDirtyMs = now;
+
+    // The snapshot being written is already stale. Start again once things
+    // settle, unless changes have been coming for so long that a slightly
+    // stale save beats none.
+    if (stateSaveInProgress() && !autosaveForced)
+        abortStateSave();
+}
+
+void serviceConfigAutosave()
+{
+    if (stateSaveInProgress())
     {
-        for (auto *s : strip->getSegments())
+        StateSaveStatus status = stepStateSave();
+        if (status == StateSaveStatus::Done)
         {
-            JsonObject segObj = segments.createNestedObject();
-            segObj["id"] = s->getId();
-            segObj["name"] = s->getName();
-            segObj["startLed"] = s->startIndex();
-            segObj["endLed"] = s->endIndex();
-            segObj["brightness"] = s->getBrightness();
-            
-            if (s->activeEffect) {
-                segObj["effect"] = s->activeEffect->getName();
-                
-                for (int i = 0; i < s->activeEffect->getParameterCount(); ++i)
-                {
-                    EffectParameter *p = s->activeEffect->getParameter(i);
-                    switch (p->type)
-                    {
-                    case ParamType::INTEGER:
-                        segObj[p->name] = p->value.intValue;
-                        break;
-                    case ParamType::FLOAT:
-                        segObj[p->name] = p->value.floatValue;
-                        break;
-                    case ParamType::COLOR:
-                        segObj[p->name] = p->value.colorValue;
-                        break;
-                    case ParamType::BOOLEAN:
-                        segObj[p->name] = p->value.boolValue;
-                        break;
-                    }
-                }
-            } else {
-                segObj["effect"] = "None";
-            }
+            const StateSaveStats &stats = lastStateSave();
+            LOG_DEBUG("Autosave: %u segments in %u steps, longest %lu us.", stats.slotsWritten, stats.steps,
+                      (unsigned long)stats.longestStepUs);
         }
-    }
-
-    FILE *file = fopen(STATE_FILE, "w");
-    if (file)
-    {
-        // MODIFIED: Use a static buffer to prevent stack overflow.
-        static char serializationBuffer[2048];
-        size_t bytesWritten = serializeJson(doc, serializationBuffer, sizeof(serializationBuffer));
-        
-        if (bytesWritten > 0) {
-            fprintf(file, "%s", serializationBuffer);
+        else if (status == StateSaveStatus::Failed)
+        {
+            LOG_WARN("WARN: Autosave failed; retrying after the next quiet period.");
+            markConfigDirty();
         }
-        
-        fclose(file);
-        Serial.println("OK: Config saved.");
-        return true;
+        return;
     }
-    else
+
+    if (!configDirty || !strip)
+        return;
+    uint32_t now = millis();
+    autosaveForced = now - firstDirtyMs >= CONFIG_AUTOSAVE_MAX_DELAY_MS;
+    if (now - lastDirtyMs < CONFIG_AUTOSAVE_QUIET_MS && !autosaveForced)
+        return;
+
+    configDirty = false; // Changes from here on need another save
+    if (beginStateSave(strip, LED_COUNT) == StateSaveStatus::Failed)
     {
-        Serial.println("ERR: Failed to open state file for writing.");
-        return false;
+        LOG_WARN("WARN: Autosave could not start; retrying after the next quiet period.");
+        markConfigDirty();
     }
 }
 
-// --- Loads the configuration from the filesystem ---
+// --- Loads the configuration as JSON, from the binary state if there is one ---
 size_t loadConfig(char* buffer, size_t bufferSize)
+{
+    size_t len = savedStateToJson(buffer, bufferSize);
+    if (len > 0)
+        return len;
+    return loadLegacyConfig(buffer, bufferSize);
+}
+
+// --- Loads the legacy JSON state file ---
+size_t loadLegacyConfig(char* buffer, size_t bufferSize)
 {
     FILE *file = fopen(STATE_FILE, "r");
     if (file)
@@ -96,14 +107,12 @@ size_t loadConfig(char* buffer, size_t bufferSize)
 // --- Sets a new LED count, saves it, and restarts the device ---
 void setLedCount(uint16_t newSize)
 {
-    if (newSize > 0 && newSize <= 4000)
+    if (newSize > 0 && newSize <= LED_COUNT_MAX)
     {
         LED_COUNT = newSize;
         if (saveConfig())
         {
-            Serial.print("LED count set to ");
-            Serial.print(newSize);
-            Serial.println(". Restarting to apply changes.");
+            LOG_INFO("LED count set to %u. Restarting to apply changes.", newSize);
             delay(200); 
             NVIC_SystemReset();
         }
@@ -126,14 +135,14 @@ void handleBatchConfigJson(const char* json)
 
     if (error)
     {
-        Serial.print("ERR: handleBatchConfig JSON parse error: ");
-        Serial.println(error.c_str());
+        LOG_ERROR("ERR: handleBatchConfig JSON parse error: %s", error.c_str());
         bleManager.sendMessage("{\"error\":\"JSON_PARSE_ERROR\"}");
         return;
     }
 
     if (strip)
     {
+        FrameLock frameLock;
         strip->clearUserSegments();
         JsonArray segments = doc["segments"];
         for (JsonObject segData : segments)
@@ -142,7 +151,7 @@ void handleBatchConfigJson(const char* json)
             uint16_t start = segData["startLed"];
             uint16_t end = segData["endLed"];
             uint8_t brightness = segData["brightness"] | 255;
-            const char* effectNameStr = segData["effect"] | "SolidColor";
+            uint8_t effectId = effectIdFromJson(segData["effect"]);
 
             PixelStrip::Segment *targetSeg;
             if (strcmp(name, "all") == 0)
@@ -157,38 +166,67 @@ void handleBatchConfigJson(const char* json)
             }
 
             targetSeg->setBrightness(brightness);
-            if (targetSeg->activeEffect)
-                delete targetSeg->activeEffect;
-            targetSeg->activeEffect = createEffectByName(effectNameStr, targetSeg);
+            if (!targetSeg->setEffect(effectId))
+                targetSeg->clearEffect();
 
-            if (targetSeg->activeEffect)
-            {
-                for (int i = 0; i < targetSeg->activeEffect->getParameterCount(); ++i)
-                {
-                    EffectParameter *p = targetSeg->activeEffect->getParameter(i);
-                    if (segData.containsKey(p->name))
-                    {
-                        switch (p->type)
-                        {
-                        case ParamType::INTEGER:
-                            targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<int>());
-                            break;
-                        case ParamType::FLOAT:
-                            targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<float>());
-                            break;
-                        case ParamType::COLOR:
-                            targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<uint32_t>());
-                            break;
-                        case ParamType::BOOLEAN:
-                            targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<bool>());
-                            break;
-                        }
-                    }
-                }
-            }
+            applySegmentBlend(targetSeg, segData);
+            applyEffectParameters(targetSeg->activeEffect, segData);
         }
-        strip->show();
-        Serial.println("OK: Batch configuration applied.");
+        markConfigDirty();
+        LOG_INFO("OK: Batch configuration applied.");
         bleManager.sendMessage("{\"status\":\"OK\"}");
     }
-}
\ No newline at end of file
+}
+
+// --- Applies effect parameters from a JSON object ---
+void applyEffectParameters(BaseEffect *effect, JsonObjectConst source)
+{
+    if (!effect)
+        return;
+
+    // One hashed lookup per key instead of a strcmp scan per parameter
+    for (JsonPairConst kv : source)
+    {
+        EffectParameter *p = effect->getParameter(effect->findParameter(kv.key().c_str()));
+        if (!p)
+            continue;
+
+        JsonVariantConst v = kv.value();
+        switch (p->type)
+        {
+        case ParamType::INTEGER:
+            p->value.intValue = v.as<int>();
+            break;
+        case ParamType::FLOAT:
+            p->value.floatValue = v.as<float>();
+            break;
+        case ParamType::COLOR:
+            // The app may send colours as doubles
+            p->value.colorValue = (uint32_t)v.as<double>();
+            break;
+        case ParamType::BOOLEAN:
+            p->value.boolValue = v.as<bool>();
+            break;
+        }
+    }
+    effect->markDirty();
+}
+
+// --- Applies blend mode, opacity and layer from a JSON object ---
+void applySegmentBlend(PixelStrip::Segment *segment, JsonObjectConst source)
+{
+    if (!segment)
+        return;
+
+    BlendMode mode = segment->getBlend();
+    JsonVariantConst blend = source["blend"];
+    if (blend.is<uint8_t>())
+        mode = (BlendMode)blend.as<uint8_t>(); // setBlend() ignores unknown numbers
+    else if (blend.is<const char *>() && !parseBlendMode(blend.as<const char *>(), mode))
+        LOG_WARN("WARN: Unknown blend mode '%s'; keeping %s.", blend.as<const char *>(), blendModeName(mode));
+    segment->setBlend(mode, source["opacity"] | segment->getOpacity());
+
+    JsonVariantConst layer = source["layer"];
+    if (layer.is<int>())
+        segment->setZOrder((int8_t)constrain(layer.as<int>(), -128, 127));
+}
@@ -2,18 +2,48 @@
 #define CONFIG_MANAGER_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
+#include "PixelStrip.h"
+
+class BaseEffect;
 
 // Declares the functions that can be used by any part of the program
 // to manage the device's configuration state.
 
 void setLedCount(uint16_t newSize);
+// Saves to the binary state file (StateFile.h) right away. Nothing is
+// written if nothing changed since the last save.
 bool saveConfig();
 
-// Corrected Declaration: Takes a buffer and returns the size.
+// Records that the live configuration has changed. Called by every command
+// that edits segments, effects or parameters; the change is saved by
+// serviceConfigAutosave() once things have been quiet for a while.
+void markConfigDirty();
+
+// Autosave driver, called once per main-loop pass. Starts a save after
+// CONFIG_AUTOSAVE_QUIET_MS without changes (or CONFIG_AUTOSAVE_MAX_DELAY_MS
+// after the first unsaved one) and writes it a step at a time.
+void serviceConfigAutosave();
+
+// Fills `buffer` with the saved configuration as JSON: the binary state
+// rendered in the state.json layout, or the legacy file if there is no
+// binary state yet. Returns the size.
 size_t loadConfig(char* buffer, size_t bufferSize);
 
+// Reads the legacy JSON state file as-is. Returns the size.
+size_t loadLegacyConfig(char* buffer, size_t bufferSize);
+
 // Corrected Declaration: Takes a C-style string.
 void handleBatchConfigJson(const char* json);
 
+// Applies every key in `source` that names one of the effect's parameters.
+// Other keys (segment fields such as "name" or "startLed") are ignored, so a
+// whole segment object can be passed in. Shared by all JSON config paths.
+void applyEffectParameters(BaseEffect* effect, JsonObjectConst source);
+
+// Applies "blend" (a name or BlendMode number), "opacity" and "layer" from a
+// segment object. Keys that are absent leave the segment's setting as it is.
+void applySegmentBlend(PixelStrip::Segment* segment, JsonObjectConst source);
+
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+/**
+ * @file Crc32.h
+ * @brief CRC-32 (IEEE 802.3, reflected 0xEDB88320) for on-flash integrity checks.
+ *
+ * @details Bitwise rather than table-driven: the data checked here is a few
+ * hundred bytes at a time, so 1 KB of table would buy nothing noticeable.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// Continues a CRC over `data`. Start with crc32() or pass the previous result.
+inline uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+inline uint32_t crc32(const uint8_t *data, size_t len)
+{
+    return crc32Update(0, data, len);
+}
+
+#endif // CRC32_H
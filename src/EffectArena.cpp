@@ -0,0 +1,60 @@
+/**
+ * @file EffectArena.cpp
+ * @brief Implementation of the effect scratch-memory arena.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "EffectArena.h"
+
+EffectArena::EffectArena() : used_(0), highWater_(0), failed_(0)
+{
+}
+
+uint8_t *EffectArena::allocate(size_t bytes)
+{
+    size_t rounded = (bytes + 3) & ~(size_t)3;
+    if (rounded == 0 || rounded > sizeof(storage_) - used_)
+    {
+        failed_++;
+        return nullptr;
+    }
+
+    uint8_t *region = storage_ + used_;
+    used_ += rounded;
+    if (used_ > highWater_)
+        highWater_ = used_;
+
+    memset(region, 0, rounded);
+    return region;
+}
+
+uint8_t *EffectArena::grow(uint8_t *region, size_t oldBytes, size_t bytes)
+{
+    size_t oldRounded = (oldBytes + 3) & ~(size_t)3;
+    size_t rounded = (bytes + 3) & ~(size_t)3;
+    if (region + oldRounded != storage_ + used_ || rounded - oldRounded > sizeof(storage_) - used_)
+        return nullptr;
+
+    memset(storage_ + used_, 0, rounded - oldRounded);
+    used_ += rounded - oldRounded;
+    if (used_ > highWater_)
+        highWater_ = used_;
+    return region;
+}
+
+void EffectArena::reset()
+{
+    used_ = 0;
+}
+
+void EffectArena::rewind(size_t mark)
+{
+    if (mark < used_)
+        used_ = mark;
+}
+
+size_t EffectArena::capacity() const { return sizeof(storage_); }
+size_t EffectArena::used() const { return used_; }
+size_t EffectArena::highWaterMark() const { return highWater_; }
+uint16_t EffectArena::failedAllocations() const { return failed_; }
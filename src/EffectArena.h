@@ -0,0 +1,71 @@
+/**
+ * @file EffectArena.h
+ * @brief Bump allocator for the scratch memory used by buffered effects.
+ *
+ * @details Buffered effects (Fire, Flare, ColoredFire) need a working buffer
+ * as long as their segment. The arena hands each segment its own region out
+ * of one fixed block, so several heat-map effects can run side by side without
+ * `new`/`delete` churn on the heap. Regions are never freed individually; the
+ * whole arena is reset when the user segments are cleared. The most recent
+ * region can grow in place, so the last segment to allocate can widen without
+ * abandoning its region; a region abandoned elsewhere is reclaimed when the
+ * strip repacks the arena (PixelStrip::repackArena).
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef EFFECT_ARENA_H
+#define EFFECT_ARENA_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * @class EffectArena
+ * @brief Fixed-capacity, reset-only allocator with a high-water mark.
+ */
+class EffectArena
+{
+public:
+    EffectArena();
+
+    /**
+     * @brief Allocates a zeroed region.
+     * @param bytes The size of the region in bytes.
+     * @return Pointer to the region (4-byte aligned), or nullptr if the arena is exhausted.
+     */
+    uint8_t *allocate(size_t bytes);
+
+    /**
+     * @brief Extends the most recent region to `bytes`, keeping its contents
+     * and zeroing what is added.
+     * @param region A region from allocate(), `oldBytes` long.
+     * @return `region`, or nullptr if it is not the most recent region or
+     * there is no room; nothing changes then, and no failure is counted.
+     */
+    uint8_t *grow(uint8_t *region, size_t oldBytes, size_t bytes);
+
+    /**
+     * @brief Releases every region at once. Pointers handed out before are invalid afterwards.
+     */
+    void reset();
+
+    /**
+     * @brief Releases every region allocated since `used()` returned `mark`.
+     * Pointers into those regions are invalid afterwards.
+     */
+    void rewind(size_t mark);
+
+    size_t capacity() const;
+    size_t used() const;
+    size_t highWaterMark() const;       ///< Largest `used()` seen since boot.
+    uint16_t failedAllocations() const; ///< Allocations refused because the arena was full.
+
+private:
+    alignas(4) uint8_t storage_[EFFECT_ARENA_SIZE];
+    size_t used_;
+    size_t highWater_;
+    uint16_t failed_;
+};
+
+#endif // EFFECT_ARENA_H
@@ -0,0 +1,140 @@
+/**
+ * @file EffectBench.cpp
+ * @brief Implementation of the serial effect benchmark.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "EffectBench.h"
+#include "globals.h"
+#include "EffectLookup.h"
+#include "RenderEngine.h"
+#include <ArduinoJson.h>
+
+namespace
+{
+    struct Timing
+    {
+        uint32_t totalUs = 0;
+        uint32_t maxUs = 0;
+
+        void add(uint32_t us)
+        {
+            totalUs += us;
+            if (us > maxUs)
+                maxUs = us;
+        }
+    };
+
+    void writeTiming(JsonDocument &doc, const Timing &t, uint16_t frames)
+    {
+        doc["avg_us"] = frames ? t.totalUs / frames : 0;
+        doc["max_us"] = t.maxUs;
+    }
+}
+
+void runEffectBench(PixelStrip &strip, uint16_t frames, const uint16_t *lengths, uint8_t lengthCount, Print &out)
+{
+    RenderEngine &engine = RenderEngine::getInstance();
+    engine.pause();
+
+    uint32_t deltaMs = 1000 / strip.getTargetFps();
+    EffectArena &arena = strip.getArena();
+    size_t arenaMark = arena.used();
+
+    StaticJsonDocument<256> doc;
+    doc["frames"] = frames;
+    doc["led_count"] = strip.getLedCount();
+    doc["outputs"] = strip.getOutputCount();
+    doc["frame_budget_us"] = strip.getFrameBudgetUs();
+    out.print("{\"bench\":");
+    serializeJson(doc, out);
+    out.print(",\"effects\":[");
+
+    // Effects run one row at a time on a segment of their own, outside the
+    // strip's segment list, so the user's configuration is never touched
+    bool first = true;
+    for (uint8_t l = 0; l < lengthCount; ++l)
+    {
+        uint16_t length = min(lengths[l], strip.getLedCount());
+        if (length == 0)
+            continue;
+        PixelStrip::Segment *bench = new PixelStrip::Segment(strip, 0, length - 1, "bench", 0xFF); // No id in use
+        for (uint8_t id = 0; id < EFFECT_COUNT; ++id)
+        {
+            bench->setEffect(id);
+            bench->update(deltaMs); // Warm-up: scratch allocation and the first full draw
+
+            // Effects positioned by show time only draw when it moves
+            uint32_t showMs = strip.getShowTimeMs();
+
+            Timing t;
+            uint16_t drawn = 0;
+            for (uint16_t f = 0; f < frames; ++f)
+            {
+                showMs += deltaMs;
+                strip.setShowTimeMs(showMs);
+                uint32_t startUs = micros();
+                bool changed = bench->update(deltaMs);
+                t.add(micros() - startUs);
+                drawn += changed;
+            }
+
+            doc.clear();
+            doc["effect"] = EFFECT_REGISTRY[id].name;
+            doc["length"] = length;
+            writeTiming(doc, t, frames);
+            doc["drawn"] = drawn;
+            if (!first)
+                out.print(",");
+            serializeJson(doc, out);
+            first = false;
+
+            bench->clearEffect();
+            bench->releaseScratch();
+            arena.rewind(arenaMark);
+        }
+        delete bench;
+    }
+    out.print("],\"show\":");
+
+    Timing showTiming;
+    for (uint16_t f = 0; f < frames; ++f)
+    {
+        uint32_t startUs = micros();
+        strip.show();
+        showTiming.add(micros() - startUs);
+    }
+    doc.clear();
+    doc["length"] = strip.getLedCount();
+    writeTiming(doc, showTiming, frames);
+    serializeJson(doc, out);
+    out.print(",\"audio\":");
+
+    // A fixed pseudo-random block; both backends take the same time for any input
+    static int16_t block[SAMPLES];
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < SAMPLES; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        block[i] = (int16_t)(seed >> 16);
+    }
+    float bands[AUDIO_BAND_COUNT];
+    Timing audioTiming;
+    for (uint16_t f = 0; f < frames; ++f)
+    {
+        uint32_t startUs = micros();
+        audioTrigger.analyseOnly(block, bands);
+        audioTiming.add(micros() - startUs);
+    }
+    doc.clear();
+    doc["backend"] = AUDIO_USE_FFT_BACKEND ? "fft" : "goertzel";
+    doc["samples"] = SAMPLES;
+    writeTiming(doc, audioTiming, frames);
+    serializeJson(doc, out);
+    out.println("}");
+
+    // The benchmark drew over the back buffer
+    strip.markAllDirty();
+    engine.resume();
+}
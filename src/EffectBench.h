@@ -0,0 +1,40 @@
+/**
+ * @file EffectBench.h
+ * @brief On-device timing of every effect, of show() and of the audio analysis.
+ *
+ * @details The serial `bench` command runs every effect in EFFECT_LIST on a
+ * scratch segment at each requested length, then times PixelStrip::show() on
+ * the live strip and the band analysis behind AudioTrigger::update(). Results
+ * are printed as one JSON object, which PythonTests/BenchCapeConfig.py
+ * compares against a stored baseline:
+ *
+ *     {"bench":{"frames":N,"led_count":..,"outputs":..,"frame_budget_us":..},
+ *      "effects":[{"effect":"Fire","length":30,"avg_us":..,"max_us":..,"drawn":..}, ...],
+ *      "show":{"length":..,"avg_us":..,"max_us":..},
+ *      "audio":{"backend":"goertzel","samples":256,"avg_us":..,"max_us":..}}
+ *
+ * "drawn" counts the frames in which the effect reported new pixels. Back to
+ * back, show() waits for the previous transfer, so its time is the larger of
+ * the mapping work and the time the longest output takes on the wire.
+ *
+ * The render core is paused for the whole run, so the LEDs show the
+ * benchmark frames; every segment redraws once it resumes. BLE and audio are
+ * not serviced meanwhile either.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef EFFECT_BENCH_H
+#define EFFECT_BENCH_H
+
+#include <Arduino.h>
+#include "PixelStrip.h"
+
+/**
+ * @brief Runs the benchmark and prints its JSON to `out`.
+ * @param frames  Timed frames per measurement, after one untimed warm-up frame.
+ * @param lengths Segment lengths to run the effects at; clipped to the strip.
+ */
+void runEffectBench(PixelStrip &strip, uint16_t frames, const uint16_t *lengths, uint8_t lengthCount, Print &out);
+
+#endif // EFFECT_BENCH_H
@@ -0,0 +1,97 @@
+/**
+ * @file EffectCatalog.cpp
+ * @brief Serialization of the effect catalog at boot.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "EffectCatalog.h"
+#include "Crc32.h"
+#include "Log.h"
+#include <ArduinoJson.h>
+
+namespace
+{
+    // What itemWithSeq() adds: the widest "seq" field, less the brace it replaces
+    constexpr size_t SEQ_PREFIX_MAX = sizeof("{\"seq\":65535,") - 1 - 1;
+
+    void describeEffect(uint8_t id, const EffectDescriptor &desc, JsonDocument &doc)
+    {
+        doc["id"] = id; // The byte CMD_SET_EFFECT and segment configs accept
+        doc["effect"] = desc.name;
+        JsonArray params = doc.createNestedArray("params");
+        for (int i = 0; i < desc.paramCount; ++i)
+        {
+            const EffectParameter *p = &desc.params[i];
+            JsonObject p_obj = params.createNestedObject();
+            p_obj["name"] = p->name;
+            switch (p->type)
+            {
+            case ParamType::INTEGER:
+                p_obj["type"] = "integer";
+                p_obj["value"] = p->value.intValue;
+                break;
+            case ParamType::FLOAT:
+                p_obj["type"] = "float";
+                p_obj["value"] = p->value.floatValue;
+                break;
+            case ParamType::COLOR:
+                p_obj["type"] = "color";
+                p_obj["value"] = p->value.colorValue;
+                break;
+            case ParamType::BOOLEAN:
+                p_obj["type"] = "boolean";
+                p_obj["value"] = p->value.boolValue;
+                break;
+            }
+            p_obj["min_val"] = p->min_val;
+            p_obj["max_val"] = p->max_val;
+        }
+    }
+}
+
+void EffectCatalog::begin()
+{
+    size_t used = 0;
+    for (uint8_t id = 0; id < EFFECT_COUNT; ++id)
+    {
+        offsets_[id] = used;
+        StaticJsonDocument<512> doc;
+        describeEffect(id, EFFECT_REGISTRY[id].descriptor(), doc);
+        size_t len = measureJson(doc);
+        if (doc.overflowed() || len + SEQ_PREFIX_MAX > EFFECT_CATALOG_ITEM_MAX ||
+            used + len >= sizeof(buffer_)) // serializeJson() also writes a terminator
+        {
+            LOG_ERROR("ERR: Effect catalog entry for %s does not fit; raise EFFECT_CATALOG_SIZE or EFFECT_CATALOG_ITEM_MAX.", EFFECT_REGISTRY[id].name);
+            continue;
+        }
+        used += serializeJson(doc, buffer_ + used, sizeof(buffer_) - used);
+    }
+    offsets_[EFFECT_COUNT] = used;
+    hash_ = crc32((const uint8_t *)buffer_, used);
+    LOG_INFO("OK: Effect catalog: %u effects, %u bytes, hash %08lx.", (unsigned)EFFECT_COUNT, (unsigned)used,
+             (unsigned long)hash_);
+}
+
+const char *EffectCatalog::item(uint8_t id, size_t &len) const
+{
+    if (id >= EFFECT_COUNT || offsets_[id + 1] == offsets_[id])
+        return nullptr;
+    len = offsets_[id + 1] - offsets_[id];
+    return buffer_ + offsets_[id];
+}
+
+size_t EffectCatalog::itemWithSeq(uint8_t id, uint16_t seq, char *out, size_t outSize) const
+{
+    size_t len;
+    const char *entry = item(id, len);
+    if (!entry)
+        return 0;
+
+    // {"seq":N, then the entry without its opening brace
+    int prefix = snprintf(out, outSize, "{\"seq\":%u,", (unsigned)seq);
+    if (prefix < 0 || (size_t)prefix + len - 1 > outSize)
+        return 0;
+    memcpy(out + prefix, entry + 1, len - 1);
+    return prefix + len - 1;
+}
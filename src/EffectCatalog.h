@@ -0,0 +1,68 @@
+/**
+ * @file EffectCatalog.h
+ * @brief The effect list the app downloads, serialized once at boot.
+ *
+ * @details The catalog is fixed for a firmware build: one JSON object per
+ * effect in EFFECT_REGISTRY, with its id, name and parameter defaults and
+ * ranges. begin() serializes every entry back to back into one buffer, so
+ * CMD_GET_ALL_EFFECTS sends ready-made bytes instead of building a JSON
+ * document per item for every request.
+ *
+ * hash() is a CRC-32 of the whole catalog. The app reads it with
+ * CMD_GET_EFFECT_CATALOG_HASH, [command, hash (4 bytes), count (2 bytes)]
+ * big-endian, and can skip the download on reconnect when it matches the
+ * catalog it already holds.
+ *
+ * Windowed transfers number their items with a leading "seq" field, which
+ * itemWithSeq() splices in while copying; the hash does not cover it.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef EFFECT_CATALOG_H
+#define EFFECT_CATALOG_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "EffectLookup.h"
+
+class EffectCatalog
+{
+public:
+    static EffectCatalog &getInstance()
+    {
+        static EffectCatalog instance;
+        return instance;
+    }
+
+    /// Serializes every effect's entry. Call once at boot, before BLE starts.
+    void begin();
+
+    /**
+     * @brief Entry `id` as one JSON object.
+     * @param len Set to the entry's length; it is not null-terminated.
+     * @return nullptr if `id` is not an effect, or its entry did not fit.
+     */
+    const char *item(uint8_t id, size_t &len) const;
+
+    /**
+     * @brief Copies entry `id` into `out` with "seq" as its first field.
+     * @return The length written, or 0 if there is no entry or `out` is too small.
+     */
+    size_t itemWithSeq(uint8_t id, uint16_t seq, char *out, size_t outSize) const;
+
+    uint32_t hash() const { return hash_; }
+    uint8_t count() const { return EFFECT_COUNT; }
+    size_t size() const { return offsets_[EFFECT_COUNT]; } ///< Bytes of all entries together
+
+private:
+    EffectCatalog() = default;
+    EffectCatalog(const EffectCatalog &) = delete;
+    EffectCatalog &operator=(const EffectCatalog &) = delete;
+
+    char buffer_[EFFECT_CATALOG_SIZE];
+    uint16_t offsets_[EFFECT_COUNT + 1] = {}; ///< Entry i is [offsets_[i], offsets_[i + 1]); empty if it did not fit
+    uint32_t hash_ = 0;
+};
+
+#endif // EFFECT_CATALOG_H
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Arduino.h>
+#include <new>
+#include <ArduinoJson.h>
 #include "Config.h" // <-- ADD THIS INCLUDE
 #include "effects/Effects.h"
 #include "PixelStrip.h"
@@ -24,36 +26,107 @@ static const char *EFFECT_NAMES[] = {
 static constexpr uint8_t EFFECT_COUNT =
     sizeof(EFFECT_NAMES) / sizeof(EFFECT_NAMES[0]);
 
-// --- Forward-declare the global buffer from main.cpp ---
-extern uint8_t effectScratchpad[];
+// --- Every effect is placement-constructed into its segment's storage ---
+#define ASSERT_EFFECT_FITS(effectName, className)                                   \
+    static_assert(sizeof(className) <= EFFECT_STORAGE_SIZE,                         \
+                  #className " does not fit in EFFECT_STORAGE_SIZE (see Config.h)"); \
+    static_assert(alignof(className) <= 8, #className " needs stronger alignment than the segment storage");
+EFFECT_LIST(ASSERT_EFFECT_FITS)
+#undef ASSERT_EFFECT_FITS
+
+// --- Compile-time effect registry, indexed by EffectType ---
+// Maps an effect ID straight to its factory and static parameter schema, so
+// selecting an effect by ID is a table lookup. Names are only resolved (once)
+// on the paths that still receive strings.
+typedef BaseEffect *(*EffectFactory)(void *storage, PixelStrip::Segment *seg);
+typedef const EffectDescriptor &(*EffectDescriptorFn)();
+
+struct EffectRegistryEntry
+{
+    const char *name;
+    EffectFactory construct; ///< Placement-constructs the effect into `storage`.
+    EffectDescriptorFn descriptor;
+};
+
+template <typename T>
+BaseEffect *constructEffectInPlace(void *storage, PixelStrip::Segment *seg)
+{
+    return new (storage) T(seg);
+}
+
+#define REGISTRY_ENTRY(name, className) {#name, &constructEffectInPlace<className>, &className::descriptor},
+static constexpr EffectRegistryEntry EFFECT_REGISTRY[] = {
+    EFFECT_LIST(REGISTRY_ENTRY)
+};
+#undef REGISTRY_ENTRY
+
+static_assert(sizeof(EFFECT_REGISTRY) / sizeof(EFFECT_REGISTRY[0]) == EFFECT_COUNT,
+              "EFFECT_REGISTRY must have one entry per EffectType");
+static_assert(EFFECT_COUNT < PixelStrip::Segment::NO_EFFECT, "Effect IDs must fit in one byte");
+
+// Ids are part of the protocol and of saved configs: released effects keep theirs
+static_assert((int)EffectType::RainbowChase == 0 && (int)EffectType::SolidColor == 1 &&
+                  (int)EffectType::FlashOnTrigger == 2 && (int)EffectType::RainbowCycle == 3 &&
+                  (int)EffectType::TheaterChase == 4 && (int)EffectType::AccelMeter == 5 &&
+                  (int)EffectType::KineticRipple == 6 && (int)EffectType::Fire == 7 &&
+                  (int)EffectType::Flare == 8 && (int)EffectType::ColoredFire == 9 &&
+                  (int)EffectType::AudioRainbow == 10,
+              "An effect id moved; append new effects to ADDED_EFFECT_LIST (effects/Effects.h)");
 
 /**
- * @brief Creates an effect instance based on its string name.
+ * @brief Resolves an effect name (case-insensitive) to its ID.
+ * @return The effect's index in EFFECT_REGISTRY, or EffectType::UNKNOWN.
  */
-inline BaseEffect* createEffectByName(const String& name, PixelStrip::Segment* seg) {
-    // This macro creates a check for standard effects (e.g., new SolidColor(seg))
-    #define CREATE_STANDARD_EFFECT_IF_MATCH(effectName, className) \
-        if (name.equalsIgnoreCase(#effectName)) { \
-            return new className(seg); \
-        }
-
-    // MODIFIED: This macro now uses the constant EFFECT_SCRATCHPAD_SIZE from Config.h
-    #define CREATE_BUFFERED_EFFECT_IF_MATCH(effectName, className) \
-        if (name.equalsIgnoreCase(#effectName)) { \
-            return new className(seg, effectScratchpad, EFFECT_SCRATCHPAD_SIZE); \
+inline uint8_t findEffectId(const char *name)
+{
+    for (uint8_t i = 0; i < EFFECT_COUNT; ++i)
+    {
+        if (strcasecmp(EFFECT_REGISTRY[i].name, name) == 0)
+        {
+            return i;
         }
+    }
+    return (uint8_t)EffectType::UNKNOWN;
+}
 
-    // Automatically generate the 'if-else if' chain for all standard effects
-    STANDARD_EFFECT_LIST(CREATE_STANDARD_EFFECT_IF_MATCH)
+/**
+ * @brief Resolves the "effect" field of a segment config, which may hold the
+ * effect's ID or its name. A missing field selects SolidColor.
+ */
+inline uint8_t effectIdFromJson(JsonVariantConst effect)
+{
+    if (effect.is<uint8_t>())
+    {
+        return effect.as<uint8_t>();
+    }
+    return findEffectId(effect | "SolidColor");
+}
 
-    // Automatically generate the 'if-else if' chain for all buffered effects
-    BUFFERED_EFFECT_LIST(CREATE_BUFFERED_EFFECT_IF_MATCH)
+/**
+ * @brief Replaces a segment's effect with the named one.
+ * @details Convenience wrapper for the string-based paths; see
+ * PixelStrip::Segment::setEffect. Callers that can race the render core must
+ * hold a FrameLock.
+ * @return The new effect, or nullptr (segment untouched) if the name is unknown.
+ */
+inline BaseEffect* setEffectByName(const char* name, PixelStrip::Segment* seg) {
+    return seg->setEffect(findEffectId(name));
+}
 
-    // Undefine the helper macros to keep them local to this function
-    #undef CREATE_STANDARD_EFFECT_IF_MATCH
-    #undef CREATE_BUFFERED_EFFECT_IF_MATCH
+// Helper to get an effect's static descriptor from its ID
+inline const EffectDescriptor *getEffectDescriptor(uint8_t id)
+{
+    if (id < EFFECT_COUNT)
+    {
+        return &EFFECT_REGISTRY[id].descriptor();
+    }
+    return nullptr;
+}
 
-    return nullptr; // Return null if no matching effect is found
+// Helper to get an effect's static descriptor from its name (case-insensitive)
+inline const EffectDescriptor *findEffectDescriptor(const char *name)
+{
+    return getEffectDescriptor(findEffectId(name));
 }
 
 // Helper to get effect name from enum value
@@ -61,7 +134,7 @@ inline const char *getEffectNameFromId(uint8_t id)
 {
     if (id < EFFECT_COUNT)
     {
-        return EFFECT_NAMES[id];
+        return EFFECT_REGISTRY[id].name;
     }
     return nullptr;
 }
\ No newline at end of file
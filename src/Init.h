@@ -1,17 +1,18 @@
 #pragma once
 
-#include "config.h"
+#include "Config.h"
 #include <Arduino.h>
 #include <PDM.h>
 #include <Arduino_LSM6DSOX.h>
 #include "PixelStrip.h"
 #include "Triggers.h"
+#include "AudioRing.h"
+#include "MotionSensor.h"
 #include <LittleFS_Mbed_RP2040.h>
-#include "EffectLookup.h" // For createEffectByName and EFFECT_LIST macro
+#include "EffectLookup.h" // For setEffectByName and EFFECT_LIST macro
 
 // --- Externally defined globals (from main.cpp) ---
-extern volatile int16_t sampleBuffer[];
-extern volatile int samplesRead;
+extern AudioSampleRing<AUDIO_RING_SAMPLES> audioRing;
 extern PixelStrip* strip;
 extern AudioTrigger<SAMPLES> audioTrigger;
 extern PixelStrip::Segment* seg;
@@ -32,21 +33,35 @@ inline void initIMU() {
         Serial.println("Failed to initialize IMU!");
         while (true);
     }
+    MotionSensor::getInstance().begin();
 }
 
+// PDM receive ISR: moves the new samples straight into the ring. What does not
+// fit is still read out of the PDM buffer, and counted as an overrun.
 inline void onPDMdata() {
-    int bytes = PDM.available();
-    PDM.read((void*)sampleBuffer, bytes);
-    samplesRead = bytes / 2;
-}
-
-inline void ledFlashCallback(bool active, uint8_t brightness) {
-    if(strip) strip->propagateTriggerState(active, brightness);
+    size_t samples = PDM.available() / 2;
+    while (samples > 0) {
+        int16_t* dest;
+        size_t span = audioRing.writeSpan(dest);
+        if (span == 0) break;
+        size_t n = min(span, samples);
+        PDM.read(dest, n * 2);
+        audioRing.commit(n);
+        samples -= n;
+    }
+    if (samples > 0) {
+        static int16_t discard[64];
+        audioRing.recordOverrun(samples);
+        while (samples > 0) {
+            size_t n = min(samples, sizeof(discard) / 2);
+            PDM.read(discard, n * 2);
+            samples -= n;
+        }
+    }
 }
 
 inline void initAudio() {
     PDM.onReceive(onPDMdata);
-    audioTrigger.onTrigger(ledFlashCallback);
     if (!PDM.begin(1, SAMPLING_FREQ)) {
         Serial.println("Failed to start PDM!");
         while (true);
@@ -54,14 +69,11 @@ inline void initAudio() {
 }
 
 inline void initLEDs() {
-    strip = new PixelStrip(LED_PIN, LED_COUNT, BRIGHTNESS, SEGMENT_COUNT);
+    strip = new PixelStrip(LED_OUTPUT_PINS, LED_COUNT, BRIGHTNESS, SEGMENT_COUNT);
     strip->begin();
     seg = strip->getSegments()[0];
-    if (seg->activeEffect) {
-        delete seg->activeEffect;
-    }
-    // createEffectByName is now available via EffectLookup.h
-    seg->activeEffect = createEffectByName("SolidColor", seg);
+    // setEffectByName is available via EffectLookup.h
+    setEffectByName("SolidColor", seg);
     strip->show(); // Clear the strip on startup
 }
 
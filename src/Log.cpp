@@ -0,0 +1,103 @@
+/**
+ * @file Log.cpp
+ * @brief Serial and ring-buffer sinks for the logging macros.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "Log.h"
+#include "Config.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static bool s_ringSink = false;
+static char s_ring[LOG_RING_SIZE];
+static size_t s_ringHead = 0;
+static size_t s_ringTail = 0;
+static size_t s_ringUsed = 0;
+static uint32_t s_dropped = 0;
+
+static void emitLine(const char *line, size_t len)
+{
+    if (!s_ringSink)
+    {
+        Serial.write((const uint8_t *)line, len);
+        Serial.write("\r\n", 2);
+        return;
+    }
+
+    // Whole lines only, so a drained log never shows half a line
+    if (LOG_RING_SIZE - s_ringUsed < len + 2)
+    {
+        s_dropped++;
+        return;
+    }
+    for (size_t i = 0; i < len + 2; ++i)
+    {
+        s_ring[s_ringHead] = i < len ? line[i] : (i == len ? '\r' : '\n');
+        s_ringHead = (s_ringHead + 1) % LOG_RING_SIZE;
+    }
+    s_ringUsed += len + 2;
+}
+
+void logPrintf(const char *fmt, ...)
+{
+    char line[LOG_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n < 0)
+        return;
+    emitLine(line, min((size_t)n, sizeof(line) - 1));
+}
+
+void logBytes(const char *label, const uint8_t *data, size_t len)
+{
+    char line[LOG_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "%s%u bytes - ", label, (unsigned)len);
+    size_t pos = (n < 0) ? 0 : min((size_t)n, sizeof(line) - 1);
+    for (size_t i = 0; i < min(len, (size_t)32) && pos + 7 < sizeof(line); ++i)
+    {
+        if (data[i] >= 32 && data[i] <= 126)
+            line[pos++] = (char)data[i];
+        else
+            pos += snprintf(line + pos, sizeof(line) - pos, "[0x%X]", data[i]);
+    }
+    if (len > 32 && pos + 3 < sizeof(line))
+    {
+        memcpy(line + pos, "...", 3);
+        pos += 3;
+    }
+    emitLine(line, pos);
+}
+
+void logSetRingSink(bool enabled)
+{
+    s_ringSink = enabled;
+}
+
+bool logRingSinkEnabled()
+{
+    return s_ringSink;
+}
+
+void logPoll()
+{
+    // Only what the TX buffer takes now, so this never waits on the host
+    int room = Serial.availableForWrite();
+    size_t budget = room > 0 ? min((size_t)room, (size_t)LOG_POLL_BYTES) : 0;
+    while (s_ringUsed > 0 && budget > 0)
+    {
+        size_t run = min(min(s_ringUsed, budget), LOG_RING_SIZE - s_ringTail);
+        Serial.write((const uint8_t *)s_ring + s_ringTail, run);
+        s_ringTail = (s_ringTail + run) % LOG_RING_SIZE;
+        s_ringUsed -= run;
+        budget -= run;
+    }
+}
+
+uint32_t logDroppedLines()
+{
+    return s_dropped;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file Log.h
+ * @brief Leveled diagnostic logging that compiles out below LOG_LEVEL.
+ *
+ * @details Use the LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG macros for diagnostic
+ * output; command replies meant for the user or a test script go to the
+ * command's own output (SerialCommandHandler.h). A level above LOG_LEVEL compiles to nothing: no format
+ * strings, no calls, no argument evaluation. Set it from the build, e.g.
+ * `build_flags = -DLOG_LEVEL=LOG_LEVEL_DEBUG` for packet dumps, or
+ * `-DLOG_LEVEL=LOG_LEVEL_WARN` for a show build.
+ *
+ * Output goes to Serial by default. The ring sink instead buffers lines and
+ * logPoll() drains them a little at a time from loop(), so a burst of
+ * logging never blocks on USB. When the ring is full, new lines are dropped
+ * and counted. Logging is meant for core 0; the sink is not locked.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/** @brief Formats one line (printf-style, no trailing newline) and sends it to the sink. */
+void logPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/** @brief Logs `label` and the first 32 bytes of `data`: printable bytes as text, others as [0xNN]. */
+void logBytes(const char *label, const uint8_t *data, size_t len);
+
+/** @brief Switches between the Serial sink (false) and the ring sink (true). */
+void logSetRingSink(bool enabled);
+bool logRingSinkEnabled();
+
+/**
+ * @brief Writes up to LOG_POLL_BYTES of buffered ring output to Serial, and
+ * never more than Serial.availableForWrite(), so it does not block. Call from loop().
+ */
+void logPoll();
+
+/** @brief Lines the ring sink has dropped because it was full. */
+uint32_t logDroppedLines();
+
+// Disabled levels keep their arguments type-checked (and variables that only
+// feed a log line "used") but compile to nothing: the branch is never taken.
+#define LOG_DISCARD(...) do { if (false) logPrintf(__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logPrintf(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logPrintf(__VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logPrintf(__VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logPrintf(__VA_ARGS__)
+#define LOG_DEBUG_BYTES(label, data, len) logBytes(label, data, len)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(__VA_ARGS__)
+#define LOG_DEBUG_BYTES(label, data, len) do { if (false) logBytes(label, data, len); } while (0)
+#endif
+
+#endif // LOG_H
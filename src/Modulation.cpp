@@ -0,0 +1,304 @@
+/**
+ * @file Modulation.cpp
+ * @brief Modulation sources and their application to effect parameters.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "Modulation.h"
+#include "PixelStrip.h"
+#include <math.h>
+
+namespace
+{
+    // Indexed by ModSource
+    const char *const MOD_SOURCE_NAMES[] = {
+        "sine", "triangle", "saw", "square", "beat", "onset",
+        "bass", "lowmid", "highmid", "treble", "rms",
+        "accelx", "accely", "accelz", "motion"};
+    static_assert(sizeof(MOD_SOURCE_NAMES) / sizeof(MOD_SOURCE_NAMES[0]) == (size_t)ModSource::Count,
+                  "MOD_SOURCE_NAMES must name every ModSource");
+
+    PixelStrip::Segment *segmentById(PixelStrip &strip, uint8_t id)
+    {
+        const std::vector<PixelStrip::Segment *> &segments = strip.getSegments();
+        if (id < segments.size() && segments[id]->getId() == id)
+            return segments[id];
+        for (auto *s : segments)
+        {
+            if (s->getId() == id)
+                return s;
+        }
+        return nullptr;
+    }
+
+    bool modulatable(const EffectParameter &p)
+    {
+        if (p.type == ParamType::BOOLEAN)
+            return true;
+        return p.type != ParamType::COLOR && p.max_val != p.min_val;
+    }
+
+    // Maps -range..+range onto the full level range
+    uint16_t bipolarLevel(float value, float range)
+    {
+        float f = (value / range + 1.0f) * 0.5f;
+        return f <= 0.0f ? 0 : f >= 1.0f ? 65535 : (uint16_t)(f * 65535.0f);
+    }
+}
+
+const char *modSourceName(ModSource source)
+{
+    return source < ModSource::Count ? MOD_SOURCE_NAMES[(uint8_t)source] : "unknown";
+}
+
+bool parseModSource(const char *name, ModSource &source)
+{
+    for (uint8_t i = 0; name && i < (uint8_t)ModSource::Count; ++i)
+    {
+        if (strcasecmp(name, MOD_SOURCE_NAMES[i]) == 0)
+        {
+            source = (ModSource)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+ModulationEngine::ModulationEngine()
+{
+    // Built once, like the gamma table; LFOs then need no floating point
+    for (uint16_t i = 0; i <= SINE_TABLE_SIZE; ++i)
+    {
+        float c = cosf(i * (2.0f * (float)PI / SINE_TABLE_SIZE));
+        sineTable_[i] = (uint16_t)((1.0f - c) * 0.5f * 65535.0f + 0.5f);
+    }
+}
+
+int ModulationEngine::find(uint8_t segmentId, uint8_t paramIndex) const
+{
+    for (uint8_t i = 0; i < count_; ++i)
+    {
+        if (slots_[i].binding.segmentId == segmentId && slots_[i].binding.paramIndex == paramIndex)
+            return i;
+    }
+    return -1;
+}
+
+bool ModulationEngine::isModulated(uint8_t segmentId, uint8_t paramIndex, uint8_t effectId) const
+{
+    int i = find(segmentId, paramIndex);
+    return i >= 0 && slots_[i].effectId == effectId;
+}
+
+ModBindStatus ModulationEngine::check(PixelStrip &strip, const ModBinding &binding) const
+{
+    if (binding.source >= ModSource::Count)
+        return ModBindStatus::BadSource;
+    PixelStrip::Segment *seg = segmentById(strip, binding.segmentId);
+    if (!seg || !seg->activeEffect)
+        return ModBindStatus::NoSegment;
+    EffectParameter *p = seg->activeEffect->getParameter(binding.paramIndex);
+    if (!p)
+        return ModBindStatus::NoParameter;
+    if (!modulatable(*p))
+        return ModBindStatus::NotModulatable;
+    return ModBindStatus::Ok;
+}
+
+ModBindStatus ModulationEngine::bind(PixelStrip &strip, const ModBinding &binding)
+{
+    ModBindStatus status = check(strip, binding);
+    if (status != ModBindStatus::Ok)
+        return status;
+    PixelStrip::Segment *seg = segmentById(strip, binding.segmentId);
+
+    int i = find(binding.segmentId, binding.paramIndex);
+    if (i < 0)
+    {
+        if (count_ >= MOD_MAX_BINDINGS)
+            return ModBindStatus::Full;
+        i = count_++;
+    }
+    Slot &slot = slots_[i];
+    slot.binding = binding;
+    slot.effectId = seg->getEffectId();
+    slot.level = 0;
+    // Envelopes fire on the next event, not on one that has already happened
+    const AudioFeatures &audio = strip.getAudio();
+    slot.lastEvent = binding.source == ModSource::ENV_BEAT ? audio.beatCount : audio.onsetCount;
+    return ModBindStatus::Ok;
+}
+
+bool ModulationEngine::unbind(uint8_t segmentId, uint8_t paramIndex)
+{
+    int i = find(segmentId, paramIndex);
+    if (i < 0)
+        return false;
+    slots_[i] = slots_[--count_];
+    return true;
+}
+
+void ModulationEngine::clear(uint8_t segmentId)
+{
+    for (uint8_t i = 0; i < count_;)
+    {
+        if (segmentId == 0xFF || slots_[i].binding.segmentId == segmentId)
+            slots_[i] = slots_[--count_];
+        else
+            ++i;
+    }
+}
+
+uint16_t ModulationEngine::sourceLevel(Slot &slot, const PixelStrip &strip, uint32_t deltaMs)
+{
+    const ModBinding &b = slot.binding;
+    const AudioFeatures &audio = strip.getAudio();
+    const MotionState &motion = strip.getMotion();
+    uint16_t target;
+
+    switch (b.source)
+    {
+    case ModSource::LFO_SINE:
+    case ModSource::LFO_TRIANGLE:
+    case ModSource::LFO_SAW:
+    case ModSource::LFO_SQUARE:
+    {
+        // Phase from show time, so LFOs with the same period line up within
+        // a segment, across segments and across devices sharing a show clock
+        uint32_t period = b.timeMs ? b.timeMs : 1;
+        uint32_t phaseMs = strip.getShowTimeMs() % period;
+        uint16_t t = (uint16_t)(((uint64_t)phaseMs << 16) / period); // Fraction of the period, 0.16
+        switch (b.source)
+        {
+        case ModSource::LFO_SINE:
+        {
+            // Linear interpolation between table entries
+            uint8_t idx = t >> 8;
+            uint16_t a = sineTable_[idx], c = sineTable_[idx + 1];
+            return a + (int16_t)(((int32_t)(c - a) * (t & 0xFF)) >> 8);
+        }
+        case ModSource::LFO_TRIANGLE:
+            return t < 0x8000 ? t * 2 : (0xFFFF - t) * 2;
+        case ModSource::LFO_SAW:
+            return t;
+        default:
+            return t < 0x8000 ? 0xFFFF : 0;
+        }
+    }
+
+    case ModSource::ENV_BEAT:
+    case ModSource::ENV_ONSET:
+    {
+        uint32_t events = b.source == ModSource::ENV_BEAT ? audio.beatCount : audio.onsetCount;
+        if (events != slot.lastEvent)
+        {
+            slot.lastEvent = events;
+            return 0xFFFF;
+        }
+        uint32_t fall = b.timeMs ? (uint32_t)0xFFFF * deltaMs / b.timeMs : 0xFFFF;
+        return slot.level > fall ? slot.level - fall : 0;
+    }
+
+    case ModSource::AUDIO_BASS:
+    case ModSource::AUDIO_LOW_MID:
+    case ModSource::AUDIO_HIGH_MID:
+    case ModSource::AUDIO_TREBLE:
+        target = audio.bandLevel[(uint8_t)b.source - (uint8_t)ModSource::AUDIO_BASS] * 257;
+        break;
+    case ModSource::AUDIO_RMS:
+        target = audio.rmsLevel * 257;
+        break;
+    case ModSource::ACCEL_X:
+        target = bipolarLevel(motion.accelX, MOD_ACCEL_RANGE_G);
+        break;
+    case ModSource::ACCEL_Y:
+        target = bipolarLevel(motion.accelY, MOD_ACCEL_RANGE_G);
+        break;
+    case ModSource::ACCEL_Z:
+        target = bipolarLevel(motion.accelZ, MOD_ACCEL_RANGE_G);
+        break;
+    case ModSource::ACCEL_MOTION:
+    {
+        float f = fabsf(motion.magnitude - 1.0f) / MOD_ACCEL_RANGE_G;
+        target = f >= 1.0f ? 65535 : (uint16_t)(f * 65535.0f);
+        break;
+    }
+    default:
+        return 0;
+    }
+
+    // One-pole smoothing with time constant timeMs
+    if (!b.timeMs)
+        return target;
+    int32_t diff = (int32_t)target - slot.level;
+    return (uint16_t)(slot.level + diff * (int32_t)deltaMs / (int32_t)(b.timeMs + deltaMs));
+}
+
+void ModulationEngine::apply(PixelStrip &strip, uint32_t deltaMs)
+{
+    for (uint8_t i = 0; i < count_; ++i)
+    {
+        Slot &slot = slots_[i];
+        const ModBinding &b = slot.binding;
+        PixelStrip::Segment *seg = segmentById(strip, b.segmentId);
+        if (!seg || !seg->activeEffect || seg->getEffectId() != slot.effectId)
+            continue; // Another effect, or none: the index no longer means the same parameter
+        EffectParameter *p = seg->activeEffect->getParameter(b.paramIndex);
+        if (!p)
+            continue;
+
+        slot.level = sourceLevel(slot, strip, deltaMs);
+
+        // Position within the binding's window of the parameter range, 0.16
+        int32_t window = (int32_t)b.low * 257 + ((int32_t)b.high - b.low) * slot.level / 255;
+        bool changed = false;
+        switch (p->type)
+        {
+        case ParamType::INTEGER:
+        {
+            int v = (int)lroundf(p->min_val + (p->max_val - p->min_val) * (window / 65535.0f));
+            changed = v != p->value.intValue;
+            p->value.intValue = v;
+            break;
+        }
+        case ParamType::FLOAT:
+        {
+            float v = p->min_val + (p->max_val - p->min_val) * (window / 65535.0f);
+            changed = v != p->value.floatValue;
+            p->value.floatValue = v;
+            break;
+        }
+        case ParamType::BOOLEAN:
+        {
+            bool v = window >= 0x8000;
+            changed = v != p->value.boolValue;
+            p->value.boolValue = v;
+            break;
+        }
+        case ParamType::COLOR:
+            break;
+        }
+        if (changed)
+            seg->activeEffect->markDirty();
+    }
+}
+
+const char *ModulationEngine::statusMessage(ModBindStatus status)
+{
+    switch (status)
+    {
+    case ModBindStatus::Ok:
+        return "OK";
+    case ModBindStatus::NoSegment:
+        return "No effect on that segment";
+    case ModBindStatus::NoParameter:
+        return "Invalid parameter index";
+    case ModBindStatus::NotModulatable:
+        return "Parameter cannot be modulated";
+    case ModBindStatus::BadSource:
+        return "Unknown source";
+    default:
+        return "Too many bindings";
+    }
+}
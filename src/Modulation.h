@@ -0,0 +1,156 @@
+/**
+ * @file Modulation.h
+ * @brief On-device parameter modulation: LFOs, envelopes, audio and motion
+ * sources bound to effect parameters.
+ *
+ * @details A binding drives one effect parameter, addressed by segment id and
+ * parameter index as in CMD_SET_EFFECT_PARAMETER, from one source. The render
+ * core evaluates every binding once per frame, after the audio and motion
+ * snapshots are latched and before any Segment::update(), so a modulated
+ * parameter costs no radio traffic at all once it is bound.
+ *
+ * Every source produces a level from 0 to 65535. The level is mapped onto the
+ * part of the parameter's [min_val, max_val] range chosen by the binding's
+ * `low` and `high` (0 = min_val, 255 = max_val; low above high inverts), so a
+ * modulated value never leaves the range the effect declares. BOOLEAN
+ * parameters are on in the upper half of that window. COLOR parameters and
+ * parameters without a range cannot be bound.
+ *
+ * The binding's `timeMs` means, per source:
+ *
+ *     LFO_*      : the period; the phase comes from show time (ShowClock.h)
+ *     ENV_*      : the decay from full level back to zero
+ *     audio, IMU : a smoothing time constant (0 follows the source directly)
+ *
+ * A binding remembers the effect it was made for; while its segment runs a
+ * different effect it is skipped, so a parameter index is never applied to
+ * the wrong schema. A parameter is only marked dirty when its value moves.
+ *
+ * Bindings are changed from core 0 under a FrameLock and read by the render
+ * core under the same lock. They are not persisted.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef MODULATION_H
+#define MODULATION_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+class PixelStrip;
+
+enum class ModSource : uint8_t
+{
+    LFO_SINE = 0,
+    LFO_TRIANGLE,
+    LFO_SAW,    ///< Rising ramp
+    LFO_SQUARE,
+    ENV_BEAT,   ///< Jumps to full on every beat, then decays
+    ENV_ONSET,  ///< Likewise on every onset
+    AUDIO_BASS, ///< AudioFeatures::bandLevel, one source per band
+    AUDIO_LOW_MID,
+    AUDIO_HIGH_MID,
+    AUDIO_TREBLE,
+    AUDIO_RMS,  ///< AudioFeatures::rmsLevel
+    ACCEL_X,    ///< -MOD_ACCEL_RANGE_G to +MOD_ACCEL_RANGE_G across the full level range
+    ACCEL_Y,
+    ACCEL_Z,
+    ACCEL_MOTION, ///< Departure of |a| from 1 g, up to MOD_ACCEL_RANGE_G
+    Count
+};
+
+const char *modSourceName(ModSource source);
+bool parseModSource(const char *name, ModSource &source); // Case-insensitive; false if unknown
+
+struct ModBinding
+{
+    uint8_t segmentId;
+    uint8_t paramIndex;
+    ModSource source;
+    uint8_t low;     ///< Level 0 maps here: 0 = the parameter's min_val, 255 = its max_val
+    uint8_t high;    ///< Level 65535 maps here
+    uint16_t timeMs; ///< Period, decay or smoothing; see the file comment
+};
+
+/// Why bind() refused a binding.
+enum class ModBindStatus : uint8_t
+{
+    Ok,
+    NoSegment,   ///< No segment with that id, or it has no effect
+    NoParameter, ///< The effect has no parameter at that index
+    NotModulatable, ///< COLOR, or no min_val/max_val range
+    BadSource,
+    Full         ///< MOD_MAX_BINDINGS are in use
+};
+
+class ModulationEngine
+{
+public:
+    static ModulationEngine &getInstance()
+    {
+        static ModulationEngine instance;
+        return instance;
+    }
+
+    /**
+     * @brief Binds a parameter of the segment's current effect to a source.
+     * @details Replaces any binding already on that parameter. Hold a FrameLock.
+     */
+    ModBindStatus bind(PixelStrip &strip, const ModBinding &binding);
+
+    /**
+     * @brief What bind() would say about the binding, short of running out of room.
+     * @details Changes nothing; for commands that check every binding before applying any.
+     */
+    ModBindStatus check(PixelStrip &strip, const ModBinding &binding) const;
+
+    /// Removes the binding on one parameter. False if there was none. Hold a FrameLock.
+    bool unbind(uint8_t segmentId, uint8_t paramIndex);
+
+    /// Removes every binding on the segment, or all of them for 0xFF. Hold a FrameLock.
+    void clear(uint8_t segmentId = 0xFF);
+
+    /**
+     * @brief True if a binding currently writes this parameter: one is on it
+     * and was made for `effectId`, the effect the segment runs.
+     * @details A value written to such a parameter would be replaced on the
+     * next frame, so setters refuse it.
+     */
+    bool isModulated(uint8_t segmentId, uint8_t paramIndex, uint8_t effectId) const;
+
+    uint8_t count() const { return count_; }
+    const ModBinding &binding(uint8_t i) const { return slots_[i].binding; }
+
+    /**
+     * @brief Advances every source by `deltaMs` and writes the bound parameters.
+     * @details Called by PixelStrip::renderSegments on the render core.
+     */
+    void apply(PixelStrip &strip, uint32_t deltaMs);
+
+    static const char *statusMessage(ModBindStatus status);
+
+private:
+    ModulationEngine();
+    ModulationEngine(const ModulationEngine &) = delete;
+    ModulationEngine &operator=(const ModulationEngine &) = delete;
+
+    struct Slot
+    {
+        ModBinding binding;
+        uint8_t effectId;   ///< The effect the parameter index belongs to
+        uint16_t level;     ///< Last level, for envelopes and smoothing
+        uint32_t lastEvent; ///< Beat or onset count the envelope last fired on
+    };
+
+    uint16_t sourceLevel(Slot &slot, const PixelStrip &strip, uint32_t deltaMs);
+    int find(uint8_t segmentId, uint8_t paramIndex) const;
+
+    static constexpr uint16_t SINE_TABLE_SIZE = 256;
+    uint16_t sineTable_[SINE_TABLE_SIZE + 1]; ///< One period of (1 - cos) / 2, plus the wrap-around entry
+
+    Slot slots_[MOD_MAX_BINDINGS];
+    uint8_t count_ = 0;
+};
+
+#endif // MODULATION_H
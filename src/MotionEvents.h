@@ -0,0 +1,66 @@
+/**
+ * @file MotionEvents.h
+ * @brief Motion events and the per-frame accelerometer snapshot shared by effects.
+ *
+ * @details MotionSensor reads the IMU in batches on core 0, detects steps and
+ * impacts, and publishes a MotionState through the MotionBus. As with audio,
+ * PixelStrip::renderSegments latches one copy per frame and effects read it
+ * through PixelStrip::getMotion().
+ *
+ * Events are published as the latest event plus a running count. An effect
+ * remembers the count it last acted on, so every segment sees every event
+ * exactly once, however the sensor and render rates line up.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef MOTION_EVENTS_H
+#define MOTION_EVENTS_H
+
+#include <Arduino.h>
+#include "SeqLock.h"
+
+enum class MotionEventType : uint8_t
+{
+    NONE = 0,
+    STEP,   ///< Acceleration magnitude rose past STEP_THRESHOLD
+    IMPACT  ///< ...and past IMU_IMPACT_THRESHOLD
+};
+
+struct MotionEvent
+{
+    MotionEventType type = MotionEventType::NONE;
+    uint32_t timestampMs = 0; ///< millis() of the sample that crossed the threshold
+    float peakG = 0;          ///< Largest magnitude seen before the event ended
+};
+
+struct MotionState
+{
+    uint32_t sequence = 0;    ///< Sample batches processed since boot
+    uint32_t timestampMs = 0; ///< millis() of the newest sample
+    float accelX = 0, accelY = 0, accelZ = 0; ///< Newest sample, in g
+    float magnitude = 0;      ///< |a| of the newest sample, in g
+    uint32_t eventCount = 0;  ///< Events detected since boot
+    MotionEvent lastEvent;
+};
+
+/**
+ * @class MotionBus
+ * @brief Single-writer, lock-free publication of the latest MotionState.
+ */
+class MotionBus : public SeqLock<MotionState>
+{
+public:
+    static MotionBus &getInstance()
+    {
+        static MotionBus instance;
+        return instance;
+    }
+
+private:
+    MotionBus() = default;
+    MotionBus(const MotionBus &) = delete;
+    MotionBus &operator=(const MotionBus &) = delete;
+};
+
+#endif // MOTION_EVENTS_H
@@ -0,0 +1,171 @@
+/**
+ * @file MotionSensor.cpp
+ * @brief LSM6DSOX FIFO reads and the step/impact detector.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "MotionSensor.h"
+#include "Config.h"
+#include "Log.h"
+#include <Arduino_LSM6DSOX.h>
+#include <Wire.h>
+#include <math.h>
+
+// LSM6DSOX registers (datasheet DS12140)
+namespace
+{
+    constexpr uint8_t LSM6DSOX_ADDRESS = 0x6A; // As used by Arduino_LSM6DSOX on the Nano RP2040 Connect
+    constexpr uint8_t REG_FIFO_CTRL3 = 0x09;   // BDR_GY[7:4], BDR_XL[3:0]
+    constexpr uint8_t REG_FIFO_CTRL4 = 0x0A;   // FIFO_MODE[2:0]
+    constexpr uint8_t REG_FIFO_STATUS1 = 0x3A; // DIFF_FIFO[7:0]
+    constexpr uint8_t REG_FIFO_DATA_OUT_TAG = 0x78;
+
+    constexpr uint8_t BDR_XL_104HZ = 0x04;
+    constexpr uint8_t FIFO_MODE_CONTINUOUS = 0x06;
+    constexpr uint8_t FIFO_STATUS2_OVR = 0x40;
+    constexpr uint8_t FIFO_TAG_ACCEL = 0x02;
+    constexpr size_t FIFO_WORD_SIZE = 7; // Tag byte + three little-endian int16 axes
+
+    constexpr float G_PER_LSB = 4.0f / 32768.0f; // ±4 g, as Arduino_LSM6DSOX sets CTRL1_XL
+    constexpr uint32_t SAMPLE_INTERVAL_US = 1000000UL / IMU_SAMPLE_RATE_HZ;
+}
+
+bool MotionSensor::begin()
+{
+    // Accelerometer only; the gyroscope is not batched
+    fifo_ = writeRegister(REG_FIFO_CTRL3, BDR_XL_104HZ) &&
+            writeRegister(REG_FIFO_CTRL4, FIFO_MODE_CONTINUOUS);
+    if (fifo_)
+        LOG_INFO("OK: IMU FIFO batching at %u Hz", IMU_SAMPLE_RATE_HZ);
+    else
+        LOG_WARN("IMU FIFO setup failed; polling the latest sample instead");
+    lastPollMs_ = millis();
+    return fifo_;
+}
+
+void MotionSensor::update()
+{
+    uint32_t now = millis();
+    if (now - lastPollMs_ < IMU_POLL_INTERVAL_MS)
+        return;
+    lastPollMs_ = now;
+
+    size_t read = fifo_ ? drainFifo(now) : pollLatest(now);
+    if (read == 0)
+        return;
+
+    stats_.batches++;
+    stats_.samples += read;
+    state_.sequence++;
+    MotionBus::getInstance().publish(state_);
+}
+
+size_t MotionSensor::drainFifo(uint32_t now)
+{
+    uint8_t status[2];
+    if (!readRegisters(REG_FIFO_STATUS1, status, sizeof(status)))
+        return 0;
+    if (status[1] & FIFO_STATUS2_OVR)
+        stats_.fifoOverruns++;
+    size_t pending = ((size_t)(status[1] & 0x03) << 8) | status[0];
+
+    // Samples come out oldest first; the newest is taken as read at `now`.
+    // Anything beyond one batch waits for the next poll rather than
+    // stretching this loop iteration.
+    size_t count = pending < IMU_FIFO_BATCH_MAX ? pending : IMU_FIFO_BATCH_MAX;
+    size_t processed = 0;
+    for (; processed < count; ++processed)
+    {
+        uint8_t w[FIFO_WORD_SIZE];
+        if (!readRegisters(REG_FIFO_DATA_OUT_TAG, w, sizeof(w)))
+            break;
+        if ((w[0] >> 3) != FIFO_TAG_ACCEL)
+            continue;
+        int16_t x = (int16_t)(w[1] | (w[2] << 8));
+        int16_t y = (int16_t)(w[3] | (w[4] << 8));
+        int16_t z = (int16_t)(w[5] | (w[6] << 8));
+        size_t age = pending - 1 - processed;
+        processSample(x * G_PER_LSB, y * G_PER_LSB, z * G_PER_LSB,
+                      now - (uint32_t)(age * SAMPLE_INTERVAL_US / 1000));
+    }
+    return processed;
+}
+
+size_t MotionSensor::pollLatest(uint32_t now)
+{
+    if (!IMU.accelerationAvailable())
+        return 0;
+    float x, y, z;
+    IMU.readAcceleration(x, y, z);
+    processSample(x, y, z, now);
+    return 1;
+}
+
+void MotionSensor::processSample(float x, float y, float z, uint32_t timestampMs)
+{
+    float magnitude = sqrtf(x * x + y * y + z * z);
+    state_.accelX = x;
+    state_.accelY = y;
+    state_.accelZ = z;
+    state_.magnitude = magnitude;
+    state_.timestampMs = timestampMs;
+
+    MotionEvent &event = state_.lastEvent;
+    if (inEvent_)
+    {
+        // The event stays open until the magnitude falls back, so one jolt
+        // is one event; its peak and type keep updating until then.
+        if (magnitude > event.peakG)
+        {
+            event.peakG = magnitude;
+            if (magnitude >= IMU_IMPACT_THRESHOLD)
+                event.type = MotionEventType::IMPACT;
+        }
+        if (magnitude < STEP_THRESHOLD * IMU_RELEASE_RATIO)
+            inEvent_ = false;
+        return;
+    }
+
+    if (magnitude < STEP_THRESHOLD)
+        return;
+    if (state_.eventCount > 0 && timestampMs - event.timestampMs < STEP_COOLDOWN_MS)
+        return;
+
+    inEvent_ = true;
+    event.type = magnitude >= IMU_IMPACT_THRESHOLD ? MotionEventType::IMPACT : MotionEventType::STEP;
+    event.timestampMs = timestampMs;
+    event.peakG = magnitude;
+    state_.eventCount++;
+    LOG_DEBUG("IMU %s at %lu ms, %.2f g", event.type == MotionEventType::IMPACT ? "impact" : "step",
+              (unsigned long)timestampMs, magnitude);
+}
+
+bool MotionSensor::writeRegister(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(LSM6DSOX_ADDRESS);
+    Wire.write(reg);
+    Wire.write(value);
+    if (Wire.endTransmission() != 0)
+    {
+        stats_.i2cErrors++;
+        return false;
+    }
+    return true;
+}
+
+bool MotionSensor::readRegisters(uint8_t reg, uint8_t *out, size_t len)
+{
+    // Register addresses auto-increment (IF_INC is on by default); reading
+    // the 7 bytes at FIFO_DATA_OUT_TAG pops one FIFO word.
+    Wire.beginTransmission(LSM6DSOX_ADDRESS);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0 || Wire.requestFrom(LSM6DSOX_ADDRESS, len) != len)
+    {
+        stats_.i2cErrors++;
+        return false;
+    }
+    for (size_t i = 0; i < len; ++i)
+        out[i] = Wire.read();
+    return true;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file MotionSensor.h
+ * @brief Batched LSM6DSOX accelerometer reads with step and impact detection.
+ *
+ * @details Arduino_LSM6DSOX configures the sensor but only exposes the latest
+ * sample. After IMU.begin(), MotionSensor points the accelerometer at the
+ * chip's hardware FIFO (continuous mode, batched at the output data rate) and
+ * drains it every IMU_POLL_INTERVAL_MS, a status read plus one 7-byte read
+ * per queued sample, instead of polling IMU.accelerationAvailable() on every
+ * loop. Each sample gets a timestamp from
+ * its place in the batch and feeds the step/impact detector; the results go
+ * out through the MotionBus (MotionEvents.h).
+ *
+ * If the FIFO cannot be configured the sensor falls back to reading the
+ * latest sample at the same cadence, so events still fire.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef MOTION_SENSOR_H
+#define MOTION_SENSOR_H
+
+#include <Arduino.h>
+#include "MotionEvents.h"
+
+/// Read counters, for diagnostics.
+struct MotionSensorStats
+{
+    uint32_t batches = 0;      ///< update() calls that read samples
+    uint32_t samples = 0;      ///< Accelerometer samples processed
+    uint32_t fifoOverruns = 0; ///< Batches where the FIFO had overflowed
+    uint32_t i2cErrors = 0;
+};
+
+class MotionSensor
+{
+public:
+    static MotionSensor &getInstance()
+    {
+        static MotionSensor instance;
+        return instance;
+    }
+
+    /**
+     * @brief Switches the accelerometer to FIFO batching. Call after IMU.begin().
+     * @return True if the FIFO is in use, false if falling back to polling.
+     */
+    bool begin();
+
+    /// Drains new samples and publishes the MotionState. Call from loop().
+    void update();
+
+    bool usingFifo() const { return fifo_; }
+    const MotionState &state() const { return state_; } ///< For core 0 code; effects use PixelStrip::getMotion()
+    const MotionSensorStats &stats() const { return stats_; }
+
+private:
+    MotionSensor() = default;
+    MotionSensor(const MotionSensor &) = delete;
+    MotionSensor &operator=(const MotionSensor &) = delete;
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool readRegisters(uint8_t reg, uint8_t *out, size_t len);
+    size_t drainFifo(uint32_t now);
+    size_t pollLatest(uint32_t now);
+    void processSample(float x, float y, float z, uint32_t timestampMs);
+
+    bool fifo_ = false;
+    uint32_t lastPollMs_ = 0;
+    bool inEvent_ = false;
+    MotionState state_;
+    MotionSensorStats stats_;
+};
+
+#endif // MOTION_SENSOR_H
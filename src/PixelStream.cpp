@@ -0,0 +1,191 @@
+/**
+ * @file PixelStream.cpp
+ * @brief Pixel stream decoding straight into the output buffers.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "PixelStream.h"
+#include "ByteOrder.h"
+
+namespace
+{
+    // Stream channel (R, G, B) to its byte within a GRB bus pixel
+    constexpr uint8_t BUS_CHANNEL[3] = {1, 0, 2};
+}
+
+void PixelStreamDecoder::begin(PixelStrip &strip)
+{
+    strip_ = &strip;
+    stats_ = PixelStreamStats();
+    state_ = State::SYNC;
+    haveSequence_ = false;
+}
+
+uint8_t *PixelStreamDecoder::pixelAt(uint16_t led)
+{
+    uint8_t o = strip_->getOutputCount() - 1;
+    while (o > 0 && led < strip_->getOutputStart(o))
+        --o;
+    return strip_->getOutput(o).Pixels() + (led - strip_->getOutputStart(o)) * 3;
+}
+
+void PixelStreamDecoder::writeChannel(uint8_t value)
+{
+    if (channel_ == 0)
+        pixel_ = pixelAt(led_);
+    pixel_[BUS_CHANNEL[channel_]] = value;
+    if (++channel_ == 3)
+    {
+        channel_ = 0;
+        led_++;
+    }
+}
+
+void PixelStreamDecoder::fail()
+{
+    stats_.dropped++;
+    state_ = State::SYNC;
+}
+
+bool PixelStreamDecoder::startFrame()
+{
+    uint16_t sequence = getU16(header_);
+    showMs_ = getU32(header_ + 2);
+    uint16_t first = getU16(header_ + 6);
+    uint16_t count = getU16(header_ + 8);
+    uint8_t encoding = header_[10];
+    if ((uint32_t)first + count > strip_->getLedCount() || encoding > PIXEL_ENCODING_DELTA)
+        return false;
+
+    // Frames the host sent that never arrived; an older sequence number is
+    // a retransmission or a restart and is simply taken
+    if (haveSequence_)
+    {
+        uint16_t gap = sequence - nextSequence_;
+        if (gap < 0x8000)
+            stats_.dropped += gap;
+    }
+    haveSequence_ = true;
+    nextSequence_ = sequence + 1;
+
+    led_ = first;
+    end_ = first + count;
+    channel_ = 0;
+    state_ = encoding == PIXEL_ENCODING_RAW ? State::RAW : encoding == PIXEL_ENCODING_RLE ? State::RLE_RUN : State::DELTA_SKIP;
+    return true;
+}
+
+PixelStreamDecoder::Status PixelStreamDecoder::feed(const uint8_t *data, size_t len, size_t &used)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        uint8_t b = data[i];
+        stats_.bytes++;
+        bool complete = false;
+
+        switch (state_)
+        {
+        case State::SYNC:
+            if (b == 'P')
+                state_ = State::MARKER;
+            break;
+        case State::MARKER:
+            if (b == 'F')
+            {
+                state_ = State::HEADER;
+                headerRead_ = 0;
+            }
+            else if (b == 'E')
+            {
+                state_ = State::SYNC;
+                used = i + 1;
+                return Status::End;
+            }
+            else if (b != 'P')
+            {
+                state_ = State::SYNC;
+            }
+            break;
+        case State::HEADER:
+            header_[headerRead_++] = b;
+            if (headerRead_ < PIXEL_FRAME_HEADER_SIZE)
+                break;
+            if (!startFrame())
+                fail();
+            else
+                complete = led_ == end_; // An empty frame re-shows the last one
+            break;
+
+        case State::RAW:
+            writeChannel(b);
+            complete = led_ == end_;
+            break;
+
+        case State::RLE_RUN:
+            if (b == 0 || led_ + b > end_)
+            {
+                fail();
+                break;
+            }
+            remaining_ = b;
+            channel_ = 0;
+            state_ = State::RLE_COLOR;
+            break;
+        case State::RLE_COLOR:
+            color_[channel_++] = b;
+            if (channel_ < 3)
+                break;
+            channel_ = 0;
+            for (; remaining_ > 0; --remaining_, ++led_)
+            {
+                uint8_t *px = pixelAt(led_);
+                px[BUS_CHANNEL[0]] = color_[0];
+                px[BUS_CHANNEL[1]] = color_[1];
+                px[BUS_CHANNEL[2]] = color_[2];
+            }
+            complete = led_ == end_;
+            state_ = State::RLE_RUN;
+            break;
+
+        case State::DELTA_SKIP:
+            if (led_ + b > end_)
+            {
+                fail();
+                break;
+            }
+            led_ += b;
+            state_ = State::DELTA_COUNT;
+            break;
+        case State::DELTA_COUNT:
+            if (led_ + b > end_)
+            {
+                fail();
+                break;
+            }
+            remaining_ = b;
+            if (b == 0)
+                complete = led_ == end_;
+            state_ = b ? State::DELTA_PIXELS : State::DELTA_SKIP;
+            break;
+        case State::DELTA_PIXELS:
+            writeChannel(b);
+            if (channel_ == 0 && --remaining_ == 0)
+            {
+                complete = led_ == end_;
+                state_ = State::DELTA_SKIP;
+            }
+            break;
+        }
+
+        if (complete)
+        {
+            state_ = State::SYNC;
+            stats_.frames++;
+            used = i + 1;
+            return Status::Frame;
+        }
+    }
+    used = len;
+    return Status::NeedMore;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file PixelStream.h
+ * @brief Host-rendered frames streamed straight into the LED output buffers.
+ *
+ * @details In pixel-stream mode the segments stop rendering and a host (a
+ * laptop doing pixel mapping or video) supplies every frame. Serial enters
+ * the mode with the `pixelstream` command, BLE with CMD_PIXEL_STREAM; all
+ * bytes that follow belong to the stream until its end marker. Multi-byte
+ * fields are big-endian, like the rest of the binary protocol.
+ *
+ *     frame : ['P']['F'][sequence:2][show time ms:4][first led:2][led count:2]
+ *             [encoding:1][pixels]
+ *     end   : ['P']['E']
+ *
+ * A frame covers LEDs [first, first + count); the others keep what the
+ * previous frame gave them, so partial frames are fine. Pixels are R, G, B
+ * and are shown as sent: the host owns gamma and brightness.
+ *
+ *     PIXEL_ENCODING_RAW   : count x [r][g][b]
+ *     PIXEL_ENCODING_RLE   : [run:1, 1-255][r][g][b] until count LEDs are covered
+ *     PIXEL_ENCODING_DELTA : [skip:1][literal:1][literal x r, g, b] until count
+ *                            LEDs are covered; skipped LEDs keep the previous frame
+ *
+ * The decoder writes each pixel into the PixelBus buffers as it arrives, with
+ * no staging copy. The buses are double-buffered by NeoPixelBus: Show() hands
+ * the finished buffer to the DMA and editing goes on in the other, so a frame
+ * is only ever presented whole, after its last byte.
+ *
+ * A frame whose show time (0 = "now") has already passed on the show clock
+ * (ShowClock.h) by more than one frame budget is shown and counted as late.
+ * A gap in the sequence counts the missing frames as dropped, as does a frame
+ * that fails to decode; the decoder then scans for the next 'P','F' marker.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef PIXEL_STREAM_H
+#define PIXEL_STREAM_H
+
+#include <Arduino.h>
+#include "PixelStrip.h"
+
+constexpr uint8_t PIXEL_ENCODING_RAW = 0;
+constexpr uint8_t PIXEL_ENCODING_RLE = 1;
+constexpr uint8_t PIXEL_ENCODING_DELTA = 2;
+constexpr size_t PIXEL_FRAME_HEADER_SIZE = 11; ///< After the two marker bytes
+
+struct PixelStreamStats
+{
+    uint32_t frames = 0;  ///< Decoded whole and shown
+    uint32_t dropped = 0; ///< Missing from the sequence, or abandoned part way through
+    uint32_t late = 0;    ///< Shown after their show time
+    uint32_t bytes = 0;
+};
+
+/**
+ * @class PixelStreamDecoder
+ * @brief Incremental decoder for the stream format above.
+ *
+ * @details Feed bytes as they arrive; feed() stops after a frame's last byte
+ * so the caller can present it before decoding on into the same buffers.
+ */
+class PixelStreamDecoder
+{
+public:
+    enum class Status
+    {
+        NeedMore, ///< Everything consumed; no frame finished
+        Frame,    ///< A frame is complete: present it, then feed the rest
+        End,      ///< The end marker; bytes after it are not part of the stream
+    };
+
+    /// Starts a stream into `strip`'s outputs and clears the statistics.
+    void begin(PixelStrip &strip);
+
+    /**
+     * @brief Decodes up to `len` bytes.
+     * @param used Set to the bytes consumed, which is `len` unless a frame or
+     * the stream ended part way through.
+     */
+    Status feed(const uint8_t *data, size_t len, size_t &used);
+
+    uint32_t frameShowMs() const { return showMs_; } ///< Show time of the frame just completed
+    PixelStreamStats &stats() { return stats_; }
+
+private:
+    enum class State : uint8_t
+    {
+        SYNC,      ///< Looking for 'P'
+        MARKER,    ///< 'P' seen; 'F' or 'E' next
+        HEADER,
+        RAW,
+        RLE_RUN,
+        RLE_COLOR,
+        DELTA_SKIP,
+        DELTA_COUNT,
+        DELTA_PIXELS
+    };
+
+    bool startFrame();
+    void writeChannel(uint8_t value);
+    uint8_t *pixelAt(uint16_t led);
+    void fail();
+
+    PixelStrip *strip_ = nullptr;
+    PixelStreamStats stats_;
+    State state_ = State::SYNC;
+    uint8_t header_[PIXEL_FRAME_HEADER_SIZE];
+    uint8_t headerRead_ = 0;
+    bool haveSequence_ = false;
+    uint16_t nextSequence_ = 0;
+    uint32_t showMs_ = 0;
+
+    uint16_t led_ = 0;    ///< Next LED to write
+    uint16_t end_ = 0;    ///< One past the frame's last LED
+    uint8_t channel_ = 0; ///< Channel of led_ being written, in R, G, B order
+    uint8_t *pixel_ = nullptr;
+    uint8_t remaining_ = 0; ///< Pixels left in an RLE run or DELTA literal
+    uint8_t color_[3];
+};
+
+#endif // PIXEL_STREAM_H
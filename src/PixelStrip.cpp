@@ -1,4 +1,40 @@
 #include "PixelStrip.h"
+#include "Config.h"
+#include "EffectLookup.h" // EFFECT_REGISTRY for Segment::setEffect
+#include "Modulation.h"
+#include "ShowClock.h"
+#include <math.h>
+
+uint8_t PixelStrip::gammaTable_[256];
+uint32_t PixelStrip::hueWheel_[PixelStrip::HUE_WHEEL_SIZE];
+constexpr uint8_t PixelStrip::HUE_WHEEL_SHIFT;
+constexpr uint16_t PixelStrip::HUE_WHEEL_SIZE;
+
+namespace
+{
+    // Indexed by BlendMode
+    const char *const BLEND_MODE_NAMES[] = {"normal", "add", "multiply", "max", "alpha"};
+    static_assert(sizeof(BLEND_MODE_NAMES) / sizeof(BLEND_MODE_NAMES[0]) == (size_t)BlendMode::Count,
+                  "BLEND_MODE_NAMES must name every BlendMode");
+}
+
+const char *blendModeName(BlendMode mode)
+{
+    return mode < BlendMode::Count ? BLEND_MODE_NAMES[(uint8_t)mode] : "unknown";
+}
+
+bool parseBlendMode(const char *name, BlendMode &mode)
+{
+    for (uint8_t i = 0; name && i < (uint8_t)BlendMode::Count; ++i)
+    {
+        if (strcasecmp(name, BLEND_MODE_NAMES[i]) == 0)
+        {
+            mode = (BlendMode)i;
+            return true;
+        }
+    }
+    return false;
+}
 
 // Destructor to clean up segments
 PixelStrip::~PixelStrip()
@@ -8,6 +44,11 @@ PixelStrip::~PixelStrip()
         delete s;
     }
     segments_.clear();
+    delete[] frame_;
+    for (auto *bus : outputs_)
+    {
+        delete bus;
+    }
 }
 
 
@@ -15,11 +56,38 @@ PixelStrip::~PixelStrip()
 // PixelStrip Class Methods
 //================================================================================
 
-PixelStrip::PixelStrip(uint8_t pin, uint16_t ledCount, uint8_t brightness, uint8_t numSections)
-    : strip(ledCount, pin), ledCount_(ledCount) // Initialize ledCount_
+PixelStrip::PixelStrip(const uint8_t *pins, uint16_t ledCount, uint8_t brightness, uint8_t numSections)
+    : ledCount_(ledCount), // Initialize ledCount_
+      frame_(new uint8_t[ledCount * 3]()), target_(frame_), targetEnd_(ledCount), targetFps_(TARGET_FPS)
 {
+    // Each output takes its LEDS_PER_OUTPUT count in turn, as far as ledCount
+    // goes; the last one takes whatever is left
+    uint16_t start = 0;
+    for (uint8_t o = 0; o < LED_OUTPUT_COUNT; ++o)
+    {
+        outputStart_[o] = start;
+        uint16_t left = ledCount - start;
+        start += (o == LED_OUTPUT_COUNT - 1 || LEDS_PER_OUTPUT[o] > left) ? left : LEDS_PER_OUTPUT[o];
+    }
+    outputStart_[LED_OUTPUT_COUNT] = ledCount;
+    for (uint8_t o = 0; o < LED_OUTPUT_COUNT; ++o)
+    {
+        outputs_[o] = new PixelBus(outputStart_[o + 1] - outputStart_[o], pins[o]);
+    }
+
+    // Built once, at start-up; brightness tables are derived from it
+    for (int i = 0; i < 256; ++i)
+    {
+        gammaTable_[i] = (uint8_t)(powf(i / 255.0f, OUTPUT_GAMMA) * 255.0f + 0.5f);
+    }
+    for (uint16_t i = 0; i < HUE_WHEEL_SIZE; ++i)
+    {
+        hueWheel_[i] = ColorHSV(i << HUE_WHEEL_SHIFT);
+    }
+
     segments_.push_back(new Segment(*this, 0, ledCount - 1, "all", 0));
     segments_[0]->setBrightness(brightness);
+    rebuildDrawOrder();
 
     if (numSections > 0)
     {
@@ -28,7 +96,9 @@ PixelStrip::PixelStrip(uint8_t pin, uint16_t ledCount, uint8_t brightness, uint8
         {
             uint16_t start = s * per;
             uint16_t end = (s == numSections - 1) ? (ledCount - 1) : (start + per - 1);
-            addSection(start, end, "seg" + String(s + 1));
+            char name[8];
+            snprintf(name, sizeof(name), "seg%u", (unsigned)(s + 1));
+            addSection(start, end, name);
         }
     }
 }
@@ -37,10 +107,11 @@ uint16_t PixelStrip::getLedCount() const
     return ledCount_;
 }
 
-void PixelStrip::addSection(uint16_t start, uint16_t end, const String &name)
+void PixelStrip::addSection(uint16_t start, uint16_t end, const char *name)
 {
     uint8_t newId = segments_.size();
     segments_.push_back(new Segment(*this, start, end, name, newId));
+    rebuildDrawOrder();
 }
 
 void PixelStrip::clearUserSegments()
@@ -50,50 +121,253 @@ void PixelStrip::clearUserSegments()
         delete segments_[i];
     }
     segments_.resize(1);
+    segments_[0]->markDirty(); // Repaint what the deleted segments covered
+    rebuildDrawOrder();
+
+    // The deleted segments' regions go back to the arena; the "all" segment
+    // re-acquires a fresh one on its next update.
+    segments_[0]->releaseScratch();
+    arena_.reset();
+}
+
+void PixelStrip::begin()
+{
+    for (auto *bus : outputs_)
+    {
+        bus->Begin();
+    }
+}
+
+namespace
+{
+    // Maps `bytes` layer bytes through `lut` and blends them over `dst`
+    void blendRun(uint8_t *dst, const uint8_t *src, size_t bytes, const uint8_t *lut, BlendMode mode, uint8_t opacity)
+    {
+        switch (mode)
+        {
+        case BlendMode::Add:
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                uint16_t v = dst[i] + lut[src[i]];
+                dst[i] = v > 255 ? 255 : v;
+            }
+            break;
+        case BlendMode::Multiply:
+            for (size_t i = 0; i < bytes; ++i)
+                dst[i] = PixelStrip::scaleChannel(dst[i], lut[src[i]]);
+            break;
+        case BlendMode::Max:
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                uint8_t v = lut[src[i]];
+                if (v > dst[i])
+                    dst[i] = v;
+            }
+            break;
+        case BlendMode::Alpha:
+            for (size_t i = 0; i < bytes; ++i)
+                dst[i] = PixelStrip::scaleChannel(lut[src[i]], opacity) + PixelStrip::scaleChannel(dst[i], 255 - opacity);
+            break;
+        default:
+            for (size_t i = 0; i < bytes; ++i)
+                dst[i] = lut[src[i]];
+            break;
+        }
+    }
 }
 
-void PixelStrip::begin() { strip.Begin(); }
 void PixelStrip::show()
 {
-    if (strip.CanShow())
+    compose();
+    present();
+}
+
+// The finished frame goes through each segment's output table into the bus
+// buffers in one go, so the LEDs never see a partially rendered frame.
+// Segments are composited bottom layer first: Normal ones overwrite what is
+// below, as they did when rendering; layered ones blend their layer over it.
+// A segment that runs across outputs is split at the boundary.
+void PixelStrip::compose()
+{
+    const std::vector<Segment *> &order = getDrawOrder();
+    Segment *bottom = order[0];
+    if (bottom->layerBytes() || bottom->startIndex() != 0 || bottom->length() != ledCount_)
+    {
+        for (auto *bus : outputs_)
+            memset(bus->Pixels(), 0, bus->PixelsSize()); // LEDs outside every segment stay dark
+    }
+
+    for (auto *s : order)
+    {
+        const uint8_t *lut = s->outputTable();
+        const uint8_t *layer = s->layerBytes();
+        BlendMode mode = layer ? s->getBlend() : BlendMode::Normal;
+        uint16_t first = s->startIndex();
+        uint16_t led = first;
+        uint16_t end = led + s->length();
+        for (uint8_t o = 0; o < LED_OUTPUT_COUNT && led < end; ++o)
+        {
+            if (led >= outputStart_[o + 1])
+                continue;
+            uint16_t stop = min(end, outputStart_[o + 1]);
+            const uint8_t *src = layer ? layer + (led - first) * 3 : frame_ + led * 3;
+            uint8_t *dst = outputs_[o]->Pixels() + (led - outputStart_[o]) * 3;
+            blendRun(dst, src, (stop - led) * 3, lut, mode, s->getOpacity());
+            led = stop;
+        }
+    }
+}
+
+// Every output is filled before any is started, then all are started back to
+// back and send in parallel; Show() waits only for that output's previous transfer.
+void PixelStrip::present()
+{
+    for (auto *bus : outputs_)
     {
-        strip.Show();
+        bus->Dirty();
+        bus->Show();
     }
+    frameStats_.framesShown++;
 }
-void PixelStrip::clear() { strip.ClearTo(RgbColor(0)); }
+
+void PixelStrip::clear() { memset(frame_, 0, ledCount_ * 3); }
 
 uint32_t PixelStrip::Color(uint8_t r, uint8_t g, uint8_t b)
 {
     return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
 }
 
+// Six 60-degree sectors, each a linear ramp of one channel, as HsbColor
+// computes them but in 8-bit integer steps (within 2 of the float result)
 uint32_t PixelStrip::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val)
 {
-    HsbColor hsb(hue / 65535.0f, sat / 255.0f, val / 255.0f);
-    RgbColor rgb = hsb;
-    return Color(rgb.R, rgb.G, rgb.B);
+    uint32_t h = (uint32_t)hue * 6;
+    uint8_t sector = h >> 16;
+    uint8_t f = (h >> 8) & 0xFF; // Position within the sector
+    uint8_t p = scaleChannel(val, 255 - sat);
+    uint8_t q = scaleChannel(val, 255 - scaleChannel(sat, f));
+    uint8_t t = scaleChannel(val, 255 - scaleChannel(sat, 255 - f));
+    switch (sector)
+    {
+    case 0:
+        return Color(val, t, p);
+    case 1:
+        return Color(q, val, p);
+    case 2:
+        return Color(p, val, t);
+    case 3:
+        return Color(p, q, val);
+    case 4:
+        return Color(t, p, val);
+    default:
+        return Color(val, p, q);
+    }
 }
 
 uint32_t PixelStrip::scaleColor(uint32_t color, uint8_t brightness)
 {
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
-    r = (uint16_t(r) * brightness) / 255;
-    g = (uint16_t(g) * brightness) / 255;
-    b = (uint16_t(b) * brightness) / 255;
+    uint8_t r = scaleChannel((color >> 16) & 0xFF, brightness);
+    uint8_t g = scaleChannel((color >> 8) & 0xFF, brightness);
+    uint8_t b = scaleChannel(color & 0xFF, brightness);
     return (uint32_t(r) << 16) | (uint32_t(g) << 8) | b;
 }
 
+// Pixels are written into the back buffer in GRB order to match NeoGrbFeature.
 void PixelStrip::setPixel(uint16_t i, uint32_t col)
 {
-    RgbColor color((col >> 16) & 0xFF, (col >> 8) & 0xFF, col & 0xFF);
-    strip.SetPixelColor(i, color);
+    uint16_t offset = i - targetFirst_; // Wraps below the target, so one compare clips both ends
+    if (offset >= targetEnd_ - targetFirst_)
+        return;
+    uint8_t *p = target_ + offset * 3;
+    p[0] = (col >> 8) & 0xFF;
+    p[1] = (col >> 16) & 0xFF;
+    p[2] = col & 0xFF;
+}
+
+void PixelStrip::setPixel(uint16_t i, const RgbColor &color)
+{
+    uint16_t offset = i - targetFirst_;
+    if (offset >= targetEnd_ - targetFirst_)
+        return;
+    uint8_t *p = target_ + offset * 3;
+    p[0] = color.G;
+    p[1] = color.R;
+    p[2] = color.B;
 }
 
 void PixelStrip::clearPixel(uint16_t i)
 {
-    strip.SetPixelColor(i, RgbColor(0));
+    uint16_t offset = i - targetFirst_;
+    if (offset >= targetEnd_ - targetFirst_)
+        return;
+    memset(target_ + offset * 3, 0, 3);
+}
+
+uint8_t *PixelStrip::targetPixels(uint16_t first, uint16_t &count)
+{
+    if (first < targetFirst_ || first >= targetEnd_)
+        return nullptr;
+    if (count > targetEnd_ - first)
+        count = targetEnd_ - first;
+    return target_ + (first - targetFirst_) * 3;
+}
+
+void PixelStrip::setDrawTarget(uint8_t *base, uint16_t first, uint16_t count)
+{
+    target_ = base;
+    targetFirst_ = first;
+    targetEnd_ = first + count;
+}
+
+void PixelStrip::fillPixels(uint16_t first, uint16_t count, uint32_t color)
+{
+    uint8_t *p = targetPixels(first, count);
+    if (!p)
+        return;
+    uint8_t r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, b = color & 0xFF;
+    if (r == g && g == b)
+    {
+        memset(p, r, count * 3); // Black, white and greys
+        return;
+    }
+    for (uint8_t *end = p + count * 3; p < end; p += 3)
+        storeGrb(p, r, g, b);
+}
+
+void PixelStrip::copyPixels(uint16_t first, const uint32_t *colors, uint16_t count)
+{
+    uint8_t *p = targetPixels(first, count);
+    if (!p)
+        return;
+    for (uint16_t i = 0; i < count; ++i, p += 3)
+    {
+        uint32_t c = colors[i];
+        storeGrb(p, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF);
+    }
+}
+
+void PixelStrip::scalePixels(uint16_t first, const uint32_t *colors, uint16_t count, uint8_t brightness)
+{
+    if (brightness == 255)
+    {
+        copyPixels(first, colors, count);
+        return;
+    }
+    uint8_t *p = targetPixels(first, count);
+    if (!p)
+        return;
+    for (uint16_t i = 0; i < count; ++i, p += 3)
+    {
+        uint32_t c = colors[i];
+        storeGrb(p, scaleChannel((c >> 16) & 0xFF, brightness), scaleChannel((c >> 8) & 0xFF, brightness),
+                 scaleChannel(c & 0xFF, brightness));
+    }
+}
+
+uint8_t *PixelStrip::pixelBytes(uint16_t idx)
+{
+    uint16_t count = 1;
+    return targetPixels(idx, count);
 }
 
 const std::vector<PixelStrip::Segment *> &PixelStrip::getSegments() const
@@ -101,60 +375,378 @@ const std::vector<PixelStrip::Segment *> &PixelStrip::getSegments() const
     return segments_;
 }
 
-PixelBus &PixelStrip::getStrip()
+uint8_t PixelStrip::getOutputCount() const { return LED_OUTPUT_COUNT; }
+PixelBus &PixelStrip::getOutput(uint8_t index) { return *outputs_[index]; }
+uint16_t PixelStrip::getOutputStart(uint8_t index) const { return outputStart_[index]; }
+uint16_t PixelStrip::getOutputLength(uint8_t index) const { return outputStart_[index + 1] - outputStart_[index]; }
+
+const EffectArena &PixelStrip::getArena() const
+{
+    return arena_;
+}
+
+EffectArena &PixelStrip::getArena()
+{
+    return arena_;
+}
+
+//================================================================================
+// Frame Scheduler
+//================================================================================
+
+void PixelStrip::setTargetFps(uint8_t fps)
+{
+    targetFps_ = constrain(fps, 1, 240);
+    frameClockStarted_ = false; // Restart the cadence at the new rate
+}
+
+uint8_t PixelStrip::getTargetFps() const { return targetFps_; }
+
+uint32_t PixelStrip::getFrameBudgetUs() const { return 1000000UL / targetFps_; }
+
+// Frames run on a fixed cadence. If the render core falls a whole interval or
+// more behind, the cadence is re-anchored to now instead of bursting frames to
+// catch up, and the effects simply see a larger delta. The cadence is pulled
+// gently onto a grid of show time, so devices sharing a show clock also show
+// their frames at the same moments.
+bool PixelStrip::beginFrame(uint32_t nowUs)
+{
+    uint32_t interval = getFrameBudgetUs();
+    if (!frameClockStarted_)
+    {
+        frameClockStarted_ = true;
+        lastFrameUs_ = nowUs;
+        nextFrameUs_ = nowUs;
+        deltaRemainderUs_ = 0;
+    }
+
+    if ((int32_t)(nowUs - nextFrameUs_) < 0)
+        return false;
+
+    if (nowUs - nextFrameUs_ >= interval)
+    {
+        frameStats_.lateFrames++;
+        nextFrameUs_ = nowUs + interval;
+    }
+    else
+    {
+        nextFrameUs_ += interval;
+    }
+    const ShowClock &clock = ShowClock::getInstance();
+    uint32_t phase = clock.showUs(nextFrameUs_) % interval;
+    int32_t gridError = phase <= interval / 2 ? -(int32_t)phase : (int32_t)(interval - phase);
+    nextFrameUs_ += gridError / 8; // An eighth per frame: no visible jitter when the clock steps
+    frameShowMs_ = clock.showMs(nowUs);
+
+    // Hand effects whole milliseconds, carrying the remainder so slow
+    // animations do not drift at frame rates that are not a divisor of 1000.
+    uint32_t elapsedUs = nowUs - lastFrameUs_ + deltaRemainderUs_;
+    lastFrameUs_ = nowUs;
+    frameDeltaMs_ = elapsedUs / 1000;
+    deltaRemainderUs_ = elapsedUs % 1000;
+    return true;
+}
+
+uint32_t PixelStrip::usUntilNextFrame(uint32_t nowUs) const
+{
+    int32_t remaining = (int32_t)(nextFrameUs_ - nowUs);
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+bool PixelStrip::renderSegments()
+{
+    uint32_t startUs = micros();
+    bool changed = false;
+    // One copy per frame: every segment reacts to the same sensor data
+    AudioFeatureBus::getInstance().read(audio_);
+    MotionBus::getInstance().read(motion_);
+    if (arenaRepack_)
+        repackArena(); // Before any segment takes its region for this frame
+    // Bound parameters move before any effect reads them
+    ModulationEngine::getInstance().apply(*this, frameDeltaMs_);
+    const std::vector<Segment *> &order = getDrawOrder();
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        // Normal segments draw in order into the same back buffer, so one
+        // that an earlier one just drew over must draw again to stay on top.
+        // Layered segments keep their pixels to themselves.
+        Segment *s = order[i];
+        for (size_t j = 0; j < i && !s->layerBytes(); ++j)
+        {
+            if (!order[j]->layerBytes() && order[j]->drewLastUpdate() && s->overlaps(*order[j]))
+            {
+                s->markDirty();
+                break;
+            }
+        }
+        changed |= s->update(frameDeltaMs_);
+    }
+    if (outputChanged_)
+    {
+        outputChanged_ = false;
+        changed = true; // Same pixels, new brightness
+    }
+
+    uint32_t renderUs = micros() - startUs;
+    frameStats_.framesRendered++;
+    frameStats_.lastRenderUs = renderUs;
+    if (renderUs > frameStats_.maxRenderUs)
+        frameStats_.maxRenderUs = renderUs;
+    if (renderUs > getFrameBudgetUs())
+        frameStats_.overBudgetFrames++;
+    return changed;
+}
+
+uint8_t *PixelStrip::resizeRegion(uint8_t *region, size_t oldBytes, size_t bytes)
+{
+    uint8_t *grown = region ? arena_.grow(region, oldBytes, bytes) : nullptr;
+    if (grown)
+        return grown;
+    // A region left behind stays allocated until the arena is repacked
+    uint8_t *fresh = arena_.allocate(bytes);
+    if (!fresh)
+        arenaRepack_ = true;
+    return fresh;
+}
+
+void PixelStrip::repackArena()
+{
+    arenaRepack_ = false;
+    size_t live = 0;
+    for (auto *s : segments_)
+        live += s->arenaBytes();
+    if (live >= arena_.used())
+        return; // Nothing abandoned: the arena is simply too small
+
+    // Buffered effects re-fetch their scratch every update, and a new layer
+    // marks its segment dirty, so every segment recovers on this frame
+    for (auto *s : segments_)
+        s->releaseScratch();
+    arena_.reset();
+}
+
+void PixelStrip::markAllDirty()
+{
+    for (auto *s : segments_)
+        s->markDirty();
+}
+
+const std::vector<PixelStrip::Segment *> &PixelStrip::getDrawOrder() const
+{
+    return drawOrder_;
+}
+
+void PixelStrip::rebuildDrawOrder()
+{
+    // Insertion sort: stable, so equal layers keep segment order, and
+    // there are only ever a handful of segments
+    drawOrder_ = segments_;
+    for (size_t i = 1; i < drawOrder_.size(); ++i)
+    {
+        Segment *s = drawOrder_[i];
+        size_t j = i;
+        for (; j > 0 && drawOrder_[j - 1]->getZOrder() > s->getZOrder(); --j)
+            drawOrder_[j] = drawOrder_[j - 1];
+        drawOrder_[j] = s;
+    }
+}
+
+uint32_t PixelStrip::getFrameDeltaMs() const { return frameDeltaMs_; }
+
+uint32_t PixelStrip::getShowTimeMs() const { return frameShowMs_; }
+
+void PixelStrip::setShowTimeMs(uint32_t ms) { frameShowMs_ = ms; }
+
+const AudioFeatures &PixelStrip::getAudio() const { return audio_; }
+
+const MotionState &PixelStrip::getMotion() const { return motion_; }
+
+const FrameStats &PixelStrip::getFrameStats() const { return frameStats_; }
+
+void PixelStrip::setGlobalBrightness(uint8_t b)
 {
-    return strip;
+    globalBrightness_ = b;
+    outputChanged_ = true;
 }
 
-void PixelStrip::propagateTriggerState(bool isActive, uint8_t brightness)
+uint8_t PixelStrip::getGlobalBrightness() const { return globalBrightness_; }
+
+void PixelStrip::resetFrameStats()
 {
+    frameStats_ = FrameStats();
     for (auto *s : segments_)
     {
-        s->triggerIsActive = isActive;
-        s->triggerBrightness = brightness;
+        s->resetRenderStats();
     }
 }
 
+//================================================================================
+// RenderStats
+//================================================================================
+
+void RenderStats::record(uint32_t us)
+{
+    uint8_t bucket = 0;
+    while (bucket < RENDER_HIST_BUCKETS - 1 && us >= bucketLimitUs(bucket))
+    {
+        ++bucket;
+    }
+    histogram[bucket]++;
+    samples++;
+    totalUs += us;
+    lastUs = us;
+    if (us > maxUs)
+        maxUs = us;
+}
+
+void RenderStats::reset() { *this = RenderStats(); }
+
+uint32_t RenderStats::averageUs() const { return samples ? totalUs / samples : 0; }
+
+uint32_t RenderStats::bucketLimitUs(uint8_t bucket) { return RENDER_HIST_FIRST_LIMIT_US << bucket; }
+
 //================================================================================
 // PixelStrip::Segment Class Methods
 //================================================================================
 
 // MODIFIED: Constructor now uses strncpy for safe copying and no longer initializes `name` in the member initializer list.
-PixelStrip::Segment::Segment(PixelStrip &p, uint16_t s, uint16_t e, const String &n, uint8_t i)
+PixelStrip::Segment::Segment(PixelStrip &p, uint16_t s, uint16_t e, const char *n, uint8_t i)
     : parent(p), startIdx(s), endIdx(e), id(i)
 {
     // Safely copy the incoming name into the fixed-size char array
-    strncpy(name, n.c_str(), sizeof(name) - 1);
+    strncpy(name, n, sizeof(name) - 1);
     // Ensure the array is always null-terminated, even if the source string was too long
     name[sizeof(name) - 1] = '\0';
 }
 
 PixelStrip::Segment::~Segment()
 {
-    if (activeEffect)
-    {
-        delete activeEffect;
-    }
+    clearEffect();
 }
 
-void PixelStrip::Segment::update()
+bool PixelStrip::Segment::update(uint32_t deltaMs)
 {
+    uint32_t startUs = micros();
+    uint8_t *layer = blend_ != BlendMode::Normal ? acquireLayer() : nullptr;
+    if (layer)
+        parent.setDrawTarget(layer, startIdx, length());
+    bool dirty = dirty_;
+    dirty_ = false;
+    bool changed = dirty;
     if (activeEffect)
     {
-        activeEffect->update();
+        if (dirty)
+            activeEffect->markDirty();
+        changed = activeEffect->update(deltaMs);
     }
-    else
+    else if (dirty)
     {
-        allOff();
+        allOff(); // Once; the dark pixels stay in the back buffer
     }
+    if (layer)
+        parent.setDrawTarget(parent.frame_, 0, parent.ledCount_);
+    drewLastUpdate_ = changed;
+    renderStats.record(micros() - startUs);
+    return changed;
 }
 
-void PixelStrip::Segment::allOff()
+void PixelStrip::Segment::markDirty() { dirty_ = true; }
+bool PixelStrip::Segment::drewLastUpdate() const { return drewLastUpdate_; }
+
+bool PixelStrip::Segment::overlaps(const Segment &other) const
 {
-    for (uint16_t i = startIdx; i <= endIdx; ++i)
+    return startIdx <= other.endIdx && other.startIdx <= endIdx;
+}
+
+void PixelStrip::Segment::setBlend(BlendMode mode, uint8_t opacity)
+{
+    if (mode >= BlendMode::Count)
+        return;
+    if (mode != blend_)
     {
-        parent.getStrip().SetPixelColor(i, RgbColor(0));
+        // Pixels move between the back buffer and the layer: everything
+        // under the segment and the layer itself must be drawn again.
+        // The layer is kept for reuse if the segment goes back to Normal.
+        blend_ = mode;
+        parent.markAllDirty();
     }
+    opacity_ = opacity;
+    parent.outputChanged_ = true;
+}
+
+BlendMode PixelStrip::Segment::getBlend() const { return blend_; }
+uint8_t PixelStrip::Segment::getOpacity() const { return opacity_; }
+
+void PixelStrip::Segment::setZOrder(int8_t z)
+{
+    if (z == zOrder_)
+        return;
+    zOrder_ = z;
+    parent.rebuildDrawOrder();
+    parent.markAllDirty();
+}
+
+int8_t PixelStrip::Segment::getZOrder() const { return zOrder_; }
+
+const uint8_t *PixelStrip::Segment::layerBytes() const
+{
+    return blend_ != BlendMode::Normal ? layer_ : nullptr;
+}
+
+uint8_t *PixelStrip::Segment::acquireLayer()
+{
+    size_t bytes = length() * 3;
+    if (layer_ && layerSize_ >= bytes)
+        return layer_;
+    layer_ = bytes ? parent.resizeRegion(layer_, layerSize_, bytes) : nullptr;
+    layerSize_ = layer_ ? bytes : 0;
+    dirty_ = true; // A new layer starts black
+    return layer_;
+}
+
+void PixelStrip::Segment::allOff()
+{
+    parent.fillPixels(startIdx, length(), 0);
+}
+
+uint16_t PixelStrip::Segment::length() const
+{
+    uint16_t ledCount = parent.getLedCount();
+    if (startIdx >= ledCount)
+        return 0;
+    uint16_t last = endIdx < ledCount ? endIdx : ledCount - 1;
+    return last - startIdx + 1;
+}
+
+uint8_t *PixelStrip::Segment::pixelBytes()
+{
+    return parent.pixelBytes(startIdx);
+}
+
+void PixelStrip::Segment::fill(uint32_t color)
+{
+    parent.fillPixels(startIdx, length(), color);
+}
+
+void PixelStrip::Segment::fillScaled(uint32_t color, uint8_t level)
+{
+    parent.fillPixels(startIdx, length(), scaleColor(color, level));
+}
+
+void PixelStrip::Segment::copy(const uint32_t *colors, uint16_t count, uint16_t offset)
+{
+    uint16_t len = length();
+    if (offset >= len)
+        return;
+    parent.copyPixels(startIdx + offset, colors, count < len - offset ? count : len - offset);
+}
+
+void PixelStrip::Segment::writeScaled(const uint32_t *colors, uint16_t count, uint8_t level, uint16_t offset)
+{
+    uint16_t len = length();
+    if (offset >= len)
+        return;
+    parent.scalePixels(startIdx + offset, colors, count < len - offset ? count : len - offset, level);
 }
 
 void PixelStrip::Segment::setRange(uint16_t newStart, uint16_t newEnd)
@@ -163,6 +755,8 @@ void PixelStrip::Segment::setRange(uint16_t newStart, uint16_t newEnd)
     {
         startIdx = newStart;
         endIdx = newEnd;
+        // Pixels this segment leaves behind belong to the segments below it again
+        parent.markAllDirty();
     }
 }
 
@@ -179,5 +773,75 @@ const char* PixelStrip::Segment::getName() const { return name; }
 
 uint8_t PixelStrip::Segment::getId() const { return id; }
 PixelStrip &PixelStrip::Segment::getParent() { return parent; }
-void PixelStrip::Segment::setBrightness(uint8_t b) { brightness = b; }
+void PixelStrip::Segment::setBrightness(uint8_t b)
+{
+    brightness = b;
+    parent.outputChanged_ = true;
+}
 uint8_t PixelStrip::Segment::getBrightness() const { return brightness; }
+
+const uint8_t *PixelStrip::Segment::outputTable()
+{
+    uint8_t level = scaleChannel(brightness, parent.globalBrightness_);
+    if (level != outputLevel_)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            outputTable_[i] = scaleChannel(gammaTable_[i], level);
+        }
+        outputLevel_ = level;
+    }
+    return outputTable_;
+}
+const RenderStats &PixelStrip::Segment::getRenderStats() const { return renderStats; }
+void PixelStrip::Segment::resetRenderStats() { renderStats.reset(); }
+
+uint8_t *PixelStrip::Segment::scratch(size_t bytes)
+{
+    if (scratch_ && scratchSize_ >= bytes)
+    {
+        return scratch_;
+    }
+    scratch_ = parent.resizeRegion(scratch_, scratchSize_, bytes);
+    scratchSize_ = scratch_ ? bytes : 0;
+    return scratch_;
+}
+
+size_t PixelStrip::Segment::arenaBytes() const
+{
+    // Rounded as EffectArena rounds them
+    return ((scratchSize_ + 3) & ~(size_t)3) + ((layerSize_ + 3) & ~(size_t)3);
+}
+
+void PixelStrip::Segment::releaseScratch()
+{
+    scratch_ = nullptr;
+    scratchSize_ = 0;
+    layer_ = nullptr;
+    layerSize_ = 0;
+}
+
+BaseEffect *PixelStrip::Segment::setEffect(uint8_t effectId)
+{
+    if (effectId >= EFFECT_COUNT)
+    {
+        return nullptr;
+    }
+    clearEffect();
+    activeEffect = EFFECT_REGISTRY[effectId].construct(effectStorage_, this);
+    effectId_ = effectId;
+    return activeEffect;
+}
+
+void PixelStrip::Segment::clearEffect()
+{
+    if (activeEffect)
+    {
+        activeEffect->~BaseEffect();
+        activeEffect = nullptr;
+    }
+    effectId_ = NO_EFFECT;
+    dirty_ = true;
+}
+
+uint8_t PixelStrip::Segment::getEffectId() const { return effectId_; }
@@ -5,8 +5,67 @@
 #include <NeoPixelBus.h>
 #include <vector>
 #include "effects/BaseEffect.h" // Use the BaseEffect abstract class
+#include "EffectArena.h"
+#include "AudioFeatures.h"
+#include "MotionEvents.h"
+#include "Config.h"
 
+// On the RP2040 each bus is a PIO state machine fed by DMA: Show() starts the
+// transfer and returns, waiting only if that bus is still sending its last frame.
+#if defined(ARDUINO_ARCH_RP2040)
+using PixelBus = NeoPixelBus<NeoGrbFeature, Rp2040x4Pio1Ws2812xMethod>;
+#else
 using PixelBus = NeoPixelBus<NeoGrbFeature, Neo800KbpsMethod>;
+#endif
+
+// Render-time histogram buckets. Bucket 0 counts updates under
+// RENDER_HIST_FIRST_LIMIT_US, each following bucket doubles the limit and the
+// last bucket collects everything above the largest limit.
+constexpr uint8_t  RENDER_HIST_BUCKETS = 8;
+constexpr uint32_t RENDER_HIST_FIRST_LIMIT_US = 125;
+
+// Per-segment timing of Segment::update(), in microseconds.
+struct RenderStats
+{
+    uint32_t histogram[RENDER_HIST_BUCKETS] = {0};
+    uint32_t samples = 0;
+    uint32_t totalUs = 0;
+    uint32_t lastUs = 0;
+    uint32_t maxUs = 0;
+
+    void record(uint32_t us);
+    void reset();
+    uint32_t averageUs() const;
+    static uint32_t bucketLimitUs(uint8_t bucket);
+};
+
+// Strip-wide frame scheduler counters.
+struct FrameStats
+{
+    uint32_t framesRendered = 0; // Frames whose segments were updated
+    uint32_t framesShown = 0;    // Frames actually pushed to the bus
+    uint32_t lateFrames = 0;     // Frames that started a whole interval or more behind schedule
+    uint32_t lastRenderUs = 0;   // Time spent updating all segments in the last frame
+    uint32_t maxRenderUs = 0;
+    uint32_t overBudgetFrames = 0; // Frames whose segment updates alone exceeded the frame budget
+};
+
+// How a segment is composited over the segments below it (lower layer, or
+// the same layer and earlier in the list). Normal segments draw straight into
+// the shared back buffer and cover what is below; the others render into a
+// layer of their own and are blended in at output time.
+enum class BlendMode : uint8_t
+{
+    Normal = 0,
+    Add,      // Sum, clipped at full
+    Multiply, // Darkens what is below by the layer
+    Max,      // The brighter of the two, per channel
+    Alpha,    // Mixed by the segment's opacity
+    Count
+};
+
+const char *blendModeName(BlendMode mode);
+bool parseBlendMode(const char *name, BlendMode &mode); // Case-insensitive; false if unknown
 
 class PixelStrip
 {
@@ -15,52 +74,168 @@ public:
     ~PixelStrip(); // Destructor to clean up segments
     uint16_t getLedCount() const;
 
-    PixelStrip(uint8_t pin, uint16_t ledCount, uint8_t brightness = 50, uint8_t numSections = 0);
+    // `pins` holds LED_OUTPUT_COUNT GPIOs; ledCount is split across them as
+    // described in Config.h
+    PixelStrip(const uint8_t *pins, uint16_t ledCount, uint8_t brightness = 50, uint8_t numSections = 0);
     void begin();
-    void show();
+    void show(); // compose() then present()
+    void compose(); // Output stage: brightness, gamma and blending into the output buffers
+    void present(); // Starts every output's transfer
     void clear();
-    void addSection(uint16_t start, uint16_t end, const String &name);
+    void addSection(uint16_t start, uint16_t end, const char *name);
     void clearUserSegments();
-    void propagateTriggerState(bool isActive, uint8_t brightness);
+
+    // --- Frame Scheduler ---
+    void setTargetFps(uint8_t fps);
+    uint8_t getTargetFps() const;
+    uint32_t getFrameBudgetUs() const;
+    bool beginFrame(uint32_t nowUs);           // True when the next frame is due; latches its delta
+    uint32_t usUntilNextFrame(uint32_t nowUs) const;
+    bool renderSegments();                     // Updates every segment; true if any wrote pixels
+    void markAllDirty();                       // Every segment redraws next frame, e.g. after a layout change
+    const std::vector<Segment *> &getDrawOrder() const; // Segments bottom layer first; rendering and compose() follow it
+    uint32_t getFrameDeltaMs() const;
+    uint32_t getShowTimeMs() const;            // Show time (ShowClock.h) latched for the frame; periodic effects take their phase from it
+    void setShowTimeMs(uint32_t ms);           // For code that drives frames itself while the render engine is paused
+    const AudioFeatures &getAudio() const;     // Audio snapshot latched for the frame being rendered
+    const MotionState &getMotion() const;      // Motion snapshot, likewise
+    const FrameStats &getFrameStats() const;
+    void resetFrameStats();
+
+    // --- Output Stage ---
+    // Effects render at full scale. show() maps every byte through its
+    // segment's table: gamma, then segment brightness times global brightness.
+    void setGlobalBrightness(uint8_t b);
+    uint8_t getGlobalBrightness() const;
 
     uint32_t Color(uint8_t r, uint8_t g, uint8_t b);
+    // Integer HSV; a full turn of hue is 65536
     uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+    // Fully saturated, full-value colour for `hue` from a table built once at
+    // start-up, in HUE_WHEEL_SIZE steps. For rainbows that set every pixel.
+    static inline uint32_t hueWheel(uint16_t hue) { return hueWheel_[hue >> HUE_WHEEL_SHIFT]; }
     static uint32_t scaleColor(uint32_t color, uint8_t brightness);
 
+    // c * brightness / 255, rounded down, without a division
+    static inline uint8_t scaleChannel(uint8_t c, uint8_t brightness)
+    {
+        uint16_t v = (uint16_t)c * brightness;
+        return (uint8_t)((v + 1 + (v >> 8)) >> 8);
+    }
+
+    // Stores one pixel at `px` in the back buffer's GRB byte order
+    static inline void storeGrb(uint8_t *px, uint8_t r, uint8_t g, uint8_t b)
+    {
+        px[0] = g;
+        px[1] = r;
+        px[2] = b;
+    }
+    static inline void storeGrb(uint8_t *px, uint32_t color)
+    {
+        storeGrb(px, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    }
+
     void setPixel(uint16_t idx, uint32_t color);
+    void setPixel(uint16_t idx, const RgbColor &color);
     void clearPixel(uint16_t idx);
-    
+
+    // --- Bulk Pixel Access ---
+    // These write the back buffer at full scale; the output stage applies
+    // brightness. Ranges run from LED `first` for `count` LEDs and are clipped to the
+    // strip. Colours are packed 0xRRGGBB, as for setPixel(). While a layered
+    // segment updates, they and setPixel() write its layer instead, clipped
+    // to the segment.
+    void fillPixels(uint16_t first, uint16_t count, uint32_t color);
+    void copyPixels(uint16_t first, const uint32_t *colors, uint16_t count);
+    void scalePixels(uint16_t first, const uint32_t *colors, uint16_t count, uint8_t brightness);
+    // The back buffer from LED `idx` on: 3 bytes per LED in GRB order (see
+    // storeGrb), up to the end of the strip (or of the layer being drawn).
+    // nullptr past the end.
+    uint8_t *pixelBytes(uint16_t idx);
+
     const std::vector<Segment *> &getSegments() const;
-    PixelBus &getStrip();
+
+    // --- Outputs ---
+    // Each output is one bus driving a contiguous run of the logical strip.
+    uint8_t getOutputCount() const;
+    PixelBus &getOutput(uint8_t index);
+    uint16_t getOutputStart(uint8_t index) const; // First logical LED on the output
+    uint16_t getOutputLength(uint8_t index) const;
+    const EffectArena &getArena() const;
+    EffectArena &getArena();
 
     class Segment
     {
     public:
-        Segment(PixelStrip &parent, uint16_t startIdx, uint16_t endIdx, const String &name, uint8_t id);
+        Segment(PixelStrip &parent, uint16_t startIdx, uint16_t endIdx, const char *name, uint8_t id);
         ~Segment();
 
         // --- Core Methods ---
-        void update();
+        bool update(uint32_t deltaMs); // Returns true if the segment wrote new pixels
         void allOff();
         void setRange(uint16_t newStart, uint16_t newEnd);
 
+        // --- Compositing ---
+        // A segment with a blend mode other than Normal gets a layer of its
+        // own from the EffectArena, length() * 3 bytes, which its effect
+        // draws into. If the arena is full it draws as Normal.
+        void setBlend(BlendMode mode, uint8_t opacity = 255);
+        BlendMode getBlend() const;
+        uint8_t getOpacity() const;     // Alpha's mix: 255 covers what is below
+        void setZOrder(int8_t z);       // Higher layers composite later; ties keep segment order
+        int8_t getZOrder() const;
+        const uint8_t *layerBytes() const; // The segment's layer, or nullptr when it draws into the back buffer
+
+        // --- Change Tracking ---
+        // A dirty segment redraws on its next update even if its effect has
+        // nothing new; a clean one may leave its pixels as they are.
+        void markDirty();
+        bool drewLastUpdate() const;            // What the latest update() returned
+        bool overlaps(const Segment &other) const;
+
+        // --- Bulk Pixel Access ---
+        // Offsets are relative to the segment's first LED; everything is
+        // clipped to the segment and to the strip.
+        uint16_t length() const;    // LEDs of the segment that exist on the strip
+        uint8_t *pixelBytes();      // GRB bytes of the first LED, length() * 3 of them; nullptr if empty
+        void fill(uint32_t color);  // Every LED, as given
+        void fillScaled(uint32_t color, uint8_t level); // Every LED, colour scaled by level / 255
+        void copy(const uint32_t *colors, uint16_t count, uint16_t offset = 0);
+        void writeScaled(const uint32_t *colors, uint16_t count, uint8_t level, uint16_t offset = 0);
+
         // --- Getters & Setters ---
         uint16_t startIndex() const;
         uint16_t endIndex() const;
         const char* getName() const; // MODIFIED: Return type is now const char*
         uint8_t getId() const;
         PixelStrip &getParent();
-        void setBrightness(uint8_t b);
+        void setBrightness(uint8_t b); // Applied by the output stage, not by effects
         uint8_t getBrightness() const;
+        const uint8_t *outputTable();  // Gamma and brightness for show(); rebuilt when a brightness changed
         void setColor(uint8_t r, uint8_t g, uint8_t b);
+        const RenderStats &getRenderStats() const;
+        void resetRenderStats();
+
+        // Scratch memory for buffered effects, owned by this segment and taken
+        // from the strip's EffectArena. A larger request grows the region in
+        // place when it is the arena's last, and replaces it otherwise; new
+        // bytes are zeroed. Returns nullptr when the arena is full; the next
+        // frame then repacks the arena if abandoned regions can be reclaimed.
+        uint8_t *scratch(size_t bytes);
+        void releaseScratch(); // Forgets the scratch region and the layer, e.g. before the arena is reset
+        size_t arenaBytes() const; // Arena bytes the scratch region and the layer hold
+
+        // Effects are placement-constructed into storage inside the segment,
+        // so swapping them never touches the heap. IDs index EFFECT_REGISTRY
+        // (EffectLookup.h).
+        static constexpr uint8_t NO_EFFECT = 0xFF;
+        BaseEffect *setEffect(uint8_t effectId); // Returns nullptr (segment untouched) for an unknown ID
+        void clearEffect();                      // Destroys the active effect in place
+        uint8_t getEffectId() const;             // NO_EFFECT when no effect is set
 
         // --- State Variables ---
-        BaseEffect* activeEffect = nullptr; // Pointer to the current effect object
+        BaseEffect* activeEffect = nullptr; // Points into the segment's effect storage; never delete it
         uint32_t baseColor = 0;
-        
-        // State for Trigger-based effects, checked by the effects themselves
-        bool triggerIsActive = false;
-        uint8_t triggerBrightness = 0;
 
     private:
         PixelStrip &parent;
@@ -68,13 +243,78 @@ public:
         char name[32]; // MODIFIED: Changed from String to fixed-size char array
         uint8_t id;
         uint8_t brightness = 255;
+        uint16_t outputLevel_ = 0x100; // Level outputTable_ was built for; 0x100 means never
+        uint8_t outputTable_[256];
+        RenderStats renderStats;
+        uint8_t *scratch_ = nullptr;
+        size_t scratchSize_ = 0;
+        uint8_t effectId_ = NO_EFFECT;
+        bool dirty_ = true; // Range or effect changed, or drawn over, since the last update
+        bool drewLastUpdate_ = false;
+        BlendMode blend_ = BlendMode::Normal;
+        uint8_t opacity_ = 255;
+        int8_t zOrder_ = 0;
+        uint8_t *layer_ = nullptr; // Only set while blend_ is not Normal
+        size_t layerSize_ = 0;
+
+        uint8_t *acquireLayer(); // Sized to length(); nullptr if the arena is full
+        alignas(8) uint8_t effectStorage_[EFFECT_STORAGE_SIZE];
     };
 
 private:
-    PixelBus strip;
+    PixelBus *outputs_[LED_OUTPUT_COUNT];
+    uint16_t outputStart_[LED_OUTPUT_COUNT + 1]; // Output i covers [outputStart_[i], outputStart_[i + 1])
     std::vector<Segment *> segments_;
+    std::vector<Segment *> drawOrder_; // segments_ sorted by z-order; the render core only reads it
+
+    // Re-sorts drawOrder_ after segments are added or removed or change layer.
+    // Runs on core 0 under the caller's FrameLock, so any allocation for the
+    // copy happens there rather than mid-frame.
+    void rebuildDrawOrder();
     uint16_t ledCount_; // Store the count internally
 
+    // Back buffer that effects render into, in the bus's GRB byte order.
+    // show() presents it to the bus (the front buffer) as one complete frame.
+    uint8_t *frame_;
+
+    // Where setPixel() and the bulk writers go: the back buffer, or the layer
+    // of the segment being updated, covering LEDs [targetFirst_, targetEnd_)
+    uint8_t *target_;
+    uint16_t targetFirst_ = 0;
+    uint16_t targetEnd_ = 0;
+    uint8_t *targetPixels(uint16_t first, uint16_t &count); // Clipped; nullptr if nothing is left
+    void setDrawTarget(uint8_t *base, uint16_t first, uint16_t count);
+
+    // Per-segment scratch regions for buffered effects
+    EffectArena arena_;
+    bool arenaRepack_ = false; // An allocation failed; repack before the next frame's updates
+    // Resizes a segment's region: in place if it is the arena's last, else a
+    // new one. nullptr (and a repack requested) if the arena is full.
+    uint8_t *resizeRegion(uint8_t *region, size_t oldBytes, size_t bytes);
+    // Drops every segment's region and resets the arena, if that frees any
+    // bytes; each segment takes a fresh region on its next update.
+    void repackArena();
+
+    // Frame scheduler state
+    uint8_t targetFps_;
+    bool frameClockStarted_ = false;
+    uint32_t nextFrameUs_ = 0;
+    uint32_t lastFrameUs_ = 0;
+    uint32_t deltaRemainderUs_ = 0;
+    uint32_t frameDeltaMs_ = 0;
+    uint32_t frameShowMs_ = 0;
+    AudioFeatures audio_;
+    MotionState motion_;
+    FrameStats frameStats_;
+
+    // Output stage
+    uint8_t globalBrightness_ = GLOBAL_BRIGHTNESS;
+    volatile bool outputChanged_ = false; // A brightness changed; the next frame must be shown
+    static uint8_t gammaTable_[256];
+
+    static constexpr uint8_t HUE_WHEEL_SHIFT = 8;
+    static constexpr uint16_t HUE_WHEEL_SIZE = 65536 >> HUE_WHEEL_SHIFT;
+    static uint32_t hueWheel_[HUE_WHEEL_SIZE];
 };
 
 #endif // PIXELSTRIP_H
\ No newline at end of file
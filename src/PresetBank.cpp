@@ -0,0 +1,261 @@
+/**
+ * @file PresetBank.cpp
+ * @brief Preset files, their RAM copies and one-frame activation.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "PresetBank.h"
+#include "ByteOrder.h"
+#include "Crc32.h"
+#include "EffectLookup.h"
+#include "RenderEngine.h"
+#include "ShowClock.h"
+#include "ConfigManager.h"
+#include "StateFile.h"
+#include "Log.h"
+#include <stdio.h>
+
+extern const char *PRESET_FILE_FORMAT;
+extern const char *PRESET_TMP_FILE;
+
+namespace
+{
+    const uint8_t PRESET_MAGIC[4] = {'R', 'C', 'P', 'R'};
+    constexpr size_t PRESET_HEADER_SIZE = 10 + PRESET_NAME_MAX + 1;
+
+    void presetPath(uint8_t slot, char *path, size_t size)
+    {
+        snprintf(path, size, PRESET_FILE_FORMAT, slot);
+    }
+}
+
+void PresetBank::begin()
+{
+    uint8_t loaded = 0;
+    for (uint8_t slot = 0; slot < PRESET_SLOTS; ++slot)
+    {
+        if (load(slot))
+            loaded++;
+    }
+    LOG_INFO("Presets: %u of %u slots in use.", loaded, PRESET_SLOTS);
+}
+
+bool PresetBank::load(uint8_t slot)
+{
+    Preset &preset = presets_[slot];
+    preset = Preset();
+
+    char path[40];
+    presetPath(slot, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[PRESET_HEADER_SIZE];
+    static uint8_t table[STATE_EFFECT_TABLE_SIZE];
+    uint8_t trailer[4];
+    bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+              memcmp(header, PRESET_MAGIC, sizeof(PRESET_MAGIC)) == 0 && header[4] == PRESET_FORMAT_VERSION;
+    uint16_t recordCount = ok ? getU16(header + 6) : 0;
+    uint16_t dataLength = ok ? getU16(header + 8) : 0;
+    ok = ok && dataLength <= (size_t)recordCount * SEGMENT_RECORD_MAX_SIZE &&
+         fread(table, 1, sizeof(table), file) == sizeof(table);
+    if (ok)
+    {
+        preset.records.resize(dataLength);
+        ok = fread(preset.records.data(), 1, dataLength, file) == dataLength &&
+             fread(trailer, 1, sizeof(trailer), file) == sizeof(trailer);
+    }
+    fclose(file);
+
+    if (ok)
+    {
+        uint32_t crc = crc32Update(0, header, sizeof(header));
+        crc = crc32Update(crc, table, sizeof(table));
+        crc = crc32Update(crc, preset.records.data(), dataLength);
+        ok = crc == getU32(trailer);
+    }
+    if (!ok)
+    {
+        LOG_WARN("WARN: Preset file %s is damaged; slot %u left empty.", path, slot);
+        preset = Preset();
+        return false;
+    }
+
+    // Check every record now, so activation cannot fail half-way, and move
+    // the effect ids onto this build's
+    static uint8_t effectMap[256];
+    effectMapFromTable(table, sizeof(table), effectMap);
+    SegmentRecord rec;
+    size_t pos = 0;
+    uint16_t count = 0;
+    while (pos + 2 <= dataLength)
+    {
+        size_t bodyLen = getU16(&preset.records[pos]);
+        uint8_t *body = &preset.records[pos + 2];
+        if (pos + 2 + bodyLen > dataLength || !decodeSegmentRecordBody(body, bodyLen, rec))
+            break;
+        if (rec.effectId != PixelStrip::Segment::NO_EFFECT)
+            body[SEGMENT_RECORD_EFFECT_OFFSET] = effectMap[rec.effectId];
+        pos += 2 + bodyLen;
+        count++;
+    }
+    if (pos != dataLength || count != recordCount)
+    {
+        LOG_WARN("WARN: Preset file %s has malformed records; slot %u left empty.", path, slot);
+        preset = Preset();
+        return false;
+    }
+
+    memcpy(preset.name, header + 10, PRESET_NAME_MAX);
+    preset.name[PRESET_NAME_MAX] = '\0';
+    preset.recordCount = recordCount;
+    preset.used = true;
+    return true;
+}
+
+bool PresetBank::save(uint8_t slot, const char *name, PixelStrip &strip)
+{
+    if (slot >= PRESET_SLOTS)
+        return false;
+
+    static uint8_t table[STATE_EFFECT_TABLE_SIZE];
+    if (!buildEffectTable(table))
+    {
+        LOG_ERROR("ERR: Effect names exceed STATE_EFFECT_TABLE_SIZE.");
+        return false;
+    }
+
+    // Encode every segment in one go so the preset is one consistent look
+    std::vector<uint8_t> records;
+    uint16_t recordCount;
+    {
+        FrameLock frameLock;
+        const auto &segments = strip.getSegments();
+        recordCount = (uint16_t)segments.size();
+        records.resize(segments.size() * SEGMENT_RECORD_MAX_SIZE);
+        size_t used = 0;
+        for (auto *s : segments)
+            used += encodeSegmentRecord(*s, records.data() + used, records.size() - used);
+        records.resize(used);
+    }
+    if (records.size() > 0xFFFF)
+    {
+        LOG_ERROR("ERR: Too many segments for one preset.");
+        return false;
+    }
+
+    uint8_t header[PRESET_HEADER_SIZE] = {0};
+    memcpy(header, PRESET_MAGIC, sizeof(PRESET_MAGIC));
+    header[4] = PRESET_FORMAT_VERSION;
+    putU16(header + 6, recordCount);
+    putU16(header + 8, (uint16_t)records.size());
+    if (name && name[0])
+        strncpy((char *)header + 10, name, PRESET_NAME_MAX);
+    else
+        snprintf((char *)header + 10, PRESET_NAME_MAX + 1, "preset%u", slot);
+
+    uint8_t trailer[4];
+    uint32_t crc = crc32Update(0, header, sizeof(header));
+    crc = crc32Update(crc, table, sizeof(table));
+    crc = crc32Update(crc, records.data(), records.size());
+    putU32(trailer, crc);
+
+    FILE *file = fopen(PRESET_TMP_FILE, "wb");
+    if (!file)
+    {
+        LOG_ERROR("ERR: Failed to open the temporary preset file for writing.");
+        return false;
+    }
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+              fwrite(table, 1, sizeof(table), file) == sizeof(table) &&
+              fwrite(records.data(), 1, records.size(), file) == records.size() &&
+              fwrite(trailer, 1, sizeof(trailer), file) == sizeof(trailer);
+    ok = (fclose(file) == 0) && ok;
+
+    char path[40];
+    presetPath(slot, path, sizeof(path));
+    if (ok && rename(PRESET_TMP_FILE, path) != 0)
+    {
+        // Not every filesystem renames over an existing file
+        ::remove(path);
+        ok = rename(PRESET_TMP_FILE, path) == 0;
+    }
+    if (!ok)
+    {
+        ::remove(PRESET_TMP_FILE);
+        LOG_ERROR("ERR: Writing preset %u failed.", slot);
+        return false;
+    }
+
+    Preset &preset = presets_[slot];
+    memcpy(preset.name, header + 10, PRESET_NAME_MAX);
+    preset.name[PRESET_NAME_MAX] = '\0';
+    preset.recordCount = recordCount;
+    preset.records.swap(records);
+    preset.used = true;
+    return true;
+}
+
+bool PresetBank::activate(uint8_t slot, PixelStrip &strip)
+{
+    if (!isUsed(slot))
+        return false;
+    const std::vector<uint8_t> &records = presets_[slot].records;
+
+    // The render core sees either the old look or the new one, never a mix
+    FrameLock frameLock;
+    strip.clearUserSegments();
+    SegmentRecord rec;
+    for (size_t pos = 0; pos + 2 <= records.size();)
+    {
+        size_t bodyLen = getU16(&records[pos]);
+        decodeSegmentRecordBody(&records[pos + 2], bodyLen, rec); // Checked by load() or save()
+        applySegmentRecord(strip, rec);
+        pos += 2 + bodyLen;
+    }
+    return true;
+}
+
+bool PresetBank::schedule(uint8_t slot, uint32_t showMs)
+{
+    if (!isUsed(slot))
+        return false;
+    scheduledSlot_ = slot;
+    scheduledShowMs_ = showMs;
+    return true;
+}
+
+void PresetBank::service(PixelStrip &strip)
+{
+    if (scheduledSlot_ == NO_SCHEDULE)
+        return;
+    // Signed, so a time just past the show clock's ms wrap still counts as due
+    if ((int32_t)(ShowClock::getInstance().showMs(micros()) - scheduledShowMs_) < 0)
+        return;
+    uint8_t slot = scheduledSlot_;
+    scheduledSlot_ = NO_SCHEDULE;
+    if (activate(slot, strip))
+    {
+        markConfigDirty();
+        LOG_INFO("OK: Scheduled preset %u (%s) active.", slot, name(slot));
+    }
+}
+
+bool PresetBank::remove(uint8_t slot)
+{
+    if (!isUsed(slot))
+        return false;
+    char path[40];
+    presetPath(slot, path, sizeof(path));
+    if (::remove(path) != 0)
+    {
+        LOG_ERROR("ERR: Deleting %s failed.", path);
+        return false;
+    }
+    presets_[slot] = Preset();
+    if (scheduledSlot_ == slot)
+        scheduledSlot_ = NO_SCHEDULE;
+    return true;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file PresetBank.h
+ * @brief Named full-strip presets, stored on LittleFS and kept in RAM ready to apply.
+ *
+ * @details Each preset is a whole segment configuration saved under a slot
+ * number and a name. Slots are loaded once at boot (begin()) and held in RAM
+ * as encoded segment records (SegmentRecord.h), already checked and with
+ * effect ids mapped onto this build, so activate() only decodes and applies
+ * them. The whole switch happens under one FrameLock, so the render core goes
+ * from the old look to the new one between two frames.
+ *
+ * One file per slot (PRESET_FILE_FORMAT):
+ *
+ *     header       : ["RCPR"][version:1][reserved:1][record count:2]
+ *                    [data length:2][name:32, zero-padded]
+ *     effect table : as in the state file (StateFile.h)
+ *     data         : the records, each with its length prefix
+ *     trailer      : [crc32 of everything before it:4]
+ *
+ * Files are written to PRESET_TMP_FILE and renamed into place, like the state
+ * file, so a power loss never leaves a half-written preset.
+ *
+ * A switch can also be scheduled for a moment of show time (ShowClock.h), so
+ * devices sharing a show clock change look together; service() makes it.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef PRESET_BANK_H
+#define PRESET_BANK_H
+
+#include <Arduino.h>
+#include <vector>
+#include "Config.h"
+#include "PixelStrip.h"
+#include "SegmentRecord.h"
+
+constexpr uint8_t PRESET_FORMAT_VERSION = 1;
+constexpr size_t PRESET_NAME_MAX = 31;
+
+class PresetBank
+{
+public:
+    static PresetBank &getInstance()
+    {
+        static PresetBank instance;
+        return instance;
+    }
+
+    /// Loads every preset file. Call once the filesystem is mounted.
+    void begin();
+
+    /**
+     * @brief Stores the strip's current segments in `slot`, replacing what was there.
+     * @param name Shown in the preset list; an empty name becomes "preset<slot>".
+     */
+    bool save(uint8_t slot, const char *name, PixelStrip &strip);
+
+    /// Replaces every segment with the preset's. False if the slot is empty.
+    bool activate(uint8_t slot, PixelStrip &strip);
+
+    /**
+     * @brief Activates the preset once the show clock reaches `showMs`; at
+     * once if that time has passed. Replaces any switch already scheduled.
+     * @return False if the slot is empty.
+     */
+    bool schedule(uint8_t slot, uint32_t showMs);
+
+    /// Makes a scheduled switch that has fallen due. Call from the main loop.
+    void service(PixelStrip &strip);
+
+    /// Deletes the preset and its file. False if the slot was empty.
+    bool remove(uint8_t slot);
+
+    bool isUsed(uint8_t slot) const { return slot < PRESET_SLOTS && presets_[slot].used; }
+    const char *name(uint8_t slot) const { return isUsed(slot) ? presets_[slot].name : ""; }
+    uint16_t segmentCount(uint8_t slot) const { return isUsed(slot) ? presets_[slot].recordCount : 0; }
+
+private:
+    PresetBank() = default;
+    PresetBank(const PresetBank &) = delete;
+    PresetBank &operator=(const PresetBank &) = delete;
+
+    struct Preset
+    {
+        bool used = false;
+        char name[PRESET_NAME_MAX + 1] = {};
+        uint16_t recordCount = 0;
+        std::vector<uint8_t> records; ///< Length-prefixed records, ids valid for this build
+    };
+
+    bool load(uint8_t slot);
+
+    static constexpr uint8_t NO_SCHEDULE = 0xFF;
+
+    Preset presets_[PRESET_SLOTS];
+    uint8_t scheduledSlot_ = NO_SCHEDULE; ///< Preset waiting for its show time
+    uint32_t scheduledShowMs_ = 0;
+};
+
+#endif // PRESET_BANK_H
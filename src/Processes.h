@@ -1,6 +1,6 @@
 #pragma once
 
-#include "config.h"
+#include "Config.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "PixelStrip.h"
@@ -13,7 +13,7 @@
 // We only need to declare functions specific to this older "Processes" architecture if any remain.
 
 // For legacy compatibility if still used elsewhere:
-BaseEffect* createEffectByName(const String& name, PixelStrip::Segment *seg);
+BaseEffect* setEffectByName(const char* name, PixelStrip::Segment *seg);
 PixelStrip::Segment* findSegmentByIndex(const String& args, String& remainingArgs);
 const char *getBLECmdName(uint8_t cmd);
 void processSerial();
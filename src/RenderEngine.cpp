@@ -0,0 +1,134 @@
+/**
+ * @file RenderEngine.cpp
+ * @brief Implementation of the second-core render loop.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "RenderEngine.h"
+#include "Config.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include "pico/multicore.h"
+#include "hardware/timer.h"
+
+// Core 1 gets its own stack; the SDK default is too small to be comfortable
+// once effects start keeping local colour arrays.
+static uint32_t core1Stack[RENDER_CORE_STACK_SIZE / sizeof(uint32_t)];
+#endif
+
+RenderEngine::RenderEngine() : strip_(nullptr),
+                               runningOnCore1_(false),
+                               frameCount_(0),
+                               presenting_(false),
+                               pauseDepth_(0)
+{
+#if defined(ARDUINO_ARCH_RP2040)
+    recursive_mutex_init(&frameMutex_);
+#endif
+}
+
+void RenderEngine::begin(PixelStrip *strip)
+{
+    strip_ = strip;
+    frameCount_ = 0;
+#if defined(ARDUINO_ARCH_RP2040)
+    if (RENDER_ON_SECOND_CORE && strip_ && !runningOnCore1_)
+    {
+        runningOnCore1_ = true;
+        multicore_launch_core1_with_stack(core1Entry, core1Stack, sizeof(core1Stack));
+        Serial.println("Render: Running on core 1.");
+        return;
+    }
+#endif
+    Serial.println("Render: Running from loop() on core 0.");
+}
+
+void RenderEngine::core1Entry()
+{
+    RenderEngine &engine = getInstance();
+    while (true)
+    {
+        engine.renderFrame();
+#if defined(ARDUINO_ARCH_RP2040)
+        // Nothing else runs on this core, so simply wait out the frame budget.
+        uint32_t waitUs = engine.strip_->usUntilNextFrame(micros());
+        if (waitUs > 0)
+        {
+            busy_wait_us_32(waitUs);
+        }
+#endif
+    }
+}
+
+void RenderEngine::renderFrame()
+{
+    if (!strip_ || !strip_->beginFrame(micros()))
+        return;
+
+    // Compositing walks the segments and their layers, so it stays under the
+    // lock with the updates.
+    lock();
+    if (pauseDepth_)
+    {
+        // Only reachable on the pausing core itself, when rendering is not
+        // on core 1: the lock is recursive, so check who owns the frame
+        unlock();
+        return;
+    }
+    bool changed = strip_->renderSegments();
+    if (changed)
+        strip_->compose();
+    presenting_ = changed; // Before unlocking, so pause() cannot miss it
+    unlock();
+
+    // Only the render core writes the output buffers, so presenting them does
+    // not need the lock and core 0 is free to queue the next change meanwhile.
+    // A frame in which no effect drew anything is not pushed to the bus.
+    if (changed)
+    {
+        strip_->present();
+        frameCount_ = frameCount_ + 1;
+        presenting_ = false;
+    }
+}
+
+bool RenderEngine::isRunningOnSecondCore() const
+{
+    return runningOnCore1_;
+}
+
+uint32_t RenderEngine::getFrameCount() const
+{
+    return frameCount_;
+}
+
+void RenderEngine::lock()
+{
+#if defined(ARDUINO_ARCH_RP2040)
+    recursive_mutex_enter_blocking(&frameMutex_);
+#endif
+}
+
+void RenderEngine::unlock()
+{
+#if defined(ARDUINO_ARCH_RP2040)
+    recursive_mutex_exit(&frameMutex_);
+#endif
+}
+
+void RenderEngine::pause()
+{
+    lock();
+    // Core 1 presents outside the lock; wait for that frame to finish
+    while (presenting_)
+    {
+    }
+    pauseDepth_ = pauseDepth_ + 1;
+}
+
+void RenderEngine::resume()
+{
+    pauseDepth_ = pauseDepth_ - 1;
+    unlock();
+}
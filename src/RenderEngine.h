@@ -0,0 +1,124 @@
+/**
+ * @file RenderEngine.h
+ * @brief Runs LED rendering on the RP2040's second core.
+ *
+ * @details Core 0 keeps BLE, serial, PDM and IMU processing. Core 1 runs every
+ * Segment::update() into the strip's back buffer, composites it into the
+ * outputs and presents them (PixelStrip::compose() and present()). Code on core 0 that changes segments, effects or
+ * parameters must hold a FrameLock while doing so; the render core holds the
+ * same lock while it updates segments, so a configuration change always lands
+ * between two frames and is never shown half-applied.
+ *
+ * This class is implemented as a singleton, like BLEManager, because there is
+ * exactly one second core to own.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef RENDER_ENGINE_H
+#define RENDER_ENGINE_H
+
+#include <Arduino.h>
+#include "PixelStrip.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include "pico/mutex.h"
+#endif
+
+/**
+ * @class RenderEngine
+ * @brief Owns the render loop and the lock that separates it from configuration changes.
+ */
+class RenderEngine
+{
+public:
+    /**
+     * @brief Get the singleton instance of the RenderEngine.
+     * @return Reference to the singleton RenderEngine instance.
+     */
+    static RenderEngine &getInstance()
+    {
+        static RenderEngine instance;
+        return instance;
+    }
+
+    /**
+     * @brief Starts rendering the given strip.
+     * @details Launches the render loop on core 1 when RENDER_ON_SECOND_CORE is
+     * set. Otherwise the caller is expected to call renderFrame() from loop().
+     * @param strip The strip to render. Must outlive the engine.
+     */
+    void begin(PixelStrip *strip);
+
+    /**
+     * @brief Renders and presents one frame on the calling core, if one is due.
+     * @details Pacing comes from the strip's frame scheduler. Segment updates
+     * and compositing run under the frame lock; the finished outputs are
+     * presented outside it so core 0 is only held off for the duration of the
+     * effect updates, not the LED transfer. Frames in which nothing changed are not shown.
+     */
+    void renderFrame();
+
+    /**
+     * @brief Checks if the render loop is running on core 1.
+     * @return True if core 1 owns rendering, false if loop() must call renderFrame().
+     */
+    bool isRunningOnSecondCore() const;
+
+    /**
+     * @brief Gets the number of frames presented since begin().
+     */
+    uint32_t getFrameCount() const;
+
+    /** @brief Blocks until no frame is being rendered, then holds new frames off. Recursive. */
+    void lock();
+    /** @brief Releases the lock taken by lock(). */
+    void unlock();
+
+    /**
+     * @brief Like lock(), and also waits for a frame still being presented.
+     * @details While paused the caller owns the back buffer and the outputs as
+     * well as the segments, and may call PixelStrip::show() itself. If
+     * rendering runs on the caller's own core, renderFrame() does nothing
+     * until resume().
+     */
+    void pause();
+    /** @brief Releases pause(). */
+    void resume();
+
+private:
+    // --- Private Constructor for Singleton Pattern ---
+    RenderEngine();
+    RenderEngine(const RenderEngine &) = delete;
+    void operator=(const RenderEngine &) = delete;
+
+    /** @brief Entry point for core 1. Never returns. */
+    static void core1Entry();
+
+    PixelStrip *strip_;             ///< The strip being rendered.
+    volatile bool runningOnCore1_;  ///< True once core 1 has been launched.
+    volatile uint32_t frameCount_;  ///< Frames presented since begin().
+    volatile bool presenting_;      ///< A present() is in flight; set under the lock.
+    volatile uint8_t pauseDepth_;   ///< Nested pause() calls; frames are skipped while non-zero.
+#if defined(ARDUINO_ARCH_RP2040)
+    recursive_mutex_t frameMutex_;  ///< Held by core 1 while updating segments, by core 0 while changing them.
+#endif
+};
+
+/**
+ * @class FrameLock
+ * @brief Scoped guard for RenderEngine::lock()/unlock().
+ *
+ * @details Put one at the top of any command handler that adds, removes or
+ * reconfigures segments, effects or parameters.
+ */
+class FrameLock
+{
+public:
+    FrameLock() { RenderEngine::getInstance().lock(); }
+    ~FrameLock() { RenderEngine::getInstance().unlock(); }
+    FrameLock(const FrameLock &) = delete;
+    void operator=(const FrameLock &) = delete;
+};
+
+#endif // RENDER_ENGINE_H
@@ -0,0 +1,68 @@
+/**
+ * @file RxQueue.cpp
+ * @brief Contiguous packet storage for the BLE receive queue.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "RxQueue.h"
+
+bool RxQueue::push(const uint8_t *data, size_t len, uint32_t arrivedUs)
+{
+    if (len == 0 || count_ == BLE_RX_QUEUE_PACKETS)
+        return false;
+
+    size_t at;
+    uint16_t oldest = entries_[first_].offset;
+    if (count_ == 0)
+    {
+        at = 0;
+        if (len > BLE_RX_QUEUE_SIZE)
+            return false;
+    }
+    else if (writePos_ > oldest)
+    {
+        // Free space runs to the end of the buffer, and again from its start
+        // up to the oldest packet
+        if (len <= BLE_RX_QUEUE_SIZE - writePos_)
+            at = writePos_;
+        else if (len <= oldest)
+            at = 0;
+        else
+            return false;
+    }
+    else
+    {
+        // Wrapped: the only free space is between the newest and the oldest
+        if (len > (size_t)(oldest - writePos_))
+            return false;
+        at = writePos_;
+    }
+
+    Entry &e = entries_[(first_ + count_) % BLE_RX_QUEUE_PACKETS];
+    e.offset = at;
+    e.len = len;
+    e.arrivedUs = arrivedUs;
+    memcpy(buffer_ + at, data, len);
+    writePos_ = at + len;
+    count_++;
+    if (count_ > peak_)
+        peak_ = count_;
+    return true;
+}
+
+void RxQueue::pop()
+{
+    first_ = (first_ + 1) % BLE_RX_QUEUE_PACKETS;
+    if (--count_ == 0)
+    {
+        first_ = 0;
+        writePos_ = 0;
+    }
+}
+
+RxQueue::Packet RxQueue::at(uint8_t i)
+{
+    const Entry &e = entries_[(first_ + i) % BLE_RX_QUEUE_PACKETS];
+    return Packet{buffer_ + e.offset, e.len, e.arrivedUs};
+}
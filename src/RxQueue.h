@@ -0,0 +1,64 @@
+/**
+ * @file RxQueue.h
+ * @brief Bounded queue of received BLE packets, drained by the main loop.
+ *
+ * @details The ArduinoBLE write callback runs inside BLE.poll(), in the middle
+ * of whatever the main loop is doing. It only copies the packet in here;
+ * BinaryCommandHandler::dispatchQueued() applies the packets later, at one
+ * fixed point of the loop pass.
+ *
+ * Packets are stored whole and contiguous, so a queued packet can be handed
+ * to the command router, or patched in place, through a plain pointer. A
+ * packet that does not fit before the end of the buffer starts again at its
+ * beginning, and the bytes left over at the end stay unused until the queue
+ * wraps past them. Producer and consumer both run on core 0.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef RX_QUEUE_H
+#define RX_QUEUE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+class RxQueue
+{
+public:
+    struct Packet
+    {
+        uint8_t *data;
+        uint16_t len;
+        uint32_t arrivedUs; ///< micros() when the packet was received
+    };
+
+    /// Copies a packet in. False if it does not fit; nothing is queued then.
+    bool push(const uint8_t *data, size_t len, uint32_t arrivedUs);
+
+    /// The oldest packet. The queue must not be empty.
+    Packet front() { return at(0); }
+    void pop();
+
+    /// The i-th oldest packet, for inspecting or patching queued packets.
+    Packet at(uint8_t i);
+
+    uint8_t count() const { return count_; }
+    uint8_t peak() const { return peak_; } ///< Most packets ever waiting
+
+private:
+    struct Entry
+    {
+        uint16_t offset;
+        uint16_t len;
+        uint32_t arrivedUs;
+    };
+
+    uint8_t buffer_[BLE_RX_QUEUE_SIZE];
+    Entry entries_[BLE_RX_QUEUE_PACKETS];
+    uint8_t first_ = 0; ///< Slot of the oldest packet
+    uint8_t count_ = 0;
+    uint8_t peak_ = 0;
+    uint16_t writePos_ = 0; ///< Where the next packet's bytes go, if they fit
+};
+
+#endif // RX_QUEUE_H
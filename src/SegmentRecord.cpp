@@ -0,0 +1,278 @@
+/**
+ * @file SegmentRecord.cpp
+ * @brief Encoder and incremental parser for the binary segment format.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "SegmentRecord.h"
+#include "ByteOrder.h"
+#include "RenderEngine.h"
+#include "Log.h"
+
+size_t encodeSegmentStreamHeader(uint16_t recordCount, uint8_t *out, size_t capacity)
+{
+    if (capacity < SEGMENT_STREAM_HEADER_SIZE)
+        return 0;
+    out[0] = SEGMENT_RECORD_VERSION;
+    putU16(out + 1, recordCount);
+    return SEGMENT_STREAM_HEADER_SIZE;
+}
+
+size_t encodeSegmentRecord(PixelStrip::Segment &segment, uint8_t *out, size_t capacity)
+{
+    BaseEffect *effect = segment.activeEffect;
+    const char *name = segment.getName();
+    size_t nameLen = strnlen(name, SEGMENT_RECORD_NAME_MAX);
+    int paramCount = effect ? effect->getParameterCount() : 0;
+    if (paramCount > SEGMENT_RECORD_MAX_PARAMS)
+        paramCount = SEGMENT_RECORD_MAX_PARAMS;
+
+    size_t bodyLen = 12 + nameLen + (size_t)paramCount * 5;
+    if (capacity < 2 + bodyLen)
+        return 0;
+
+    uint8_t *p = out;
+    putU16(p, bodyLen);
+    p += 2;
+    *p++ = segment.getId();
+    putU16(p, segment.startIndex());
+    p += 2;
+    putU16(p, segment.endIndex());
+    p += 2;
+    *p++ = segment.getBrightness();
+    *p++ = effect ? segment.getEffectId() : PixelStrip::Segment::NO_EFFECT;
+    *p++ = (uint8_t)nameLen;
+    memcpy(p, name, nameLen);
+    p += nameLen;
+    *p++ = (uint8_t)paramCount;
+    for (int i = 0; i < paramCount; ++i)
+    {
+        uint32_t raw = effect->getParameterRaw(i);
+        *p++ = (uint8_t)i;
+        p = putU32(p, raw);
+    }
+    *p++ = (uint8_t)segment.getBlend();
+    *p++ = segment.getOpacity();
+    *p++ = (uint8_t)segment.getZOrder();
+    return p - out;
+}
+
+bool decodeSegmentRecordBody(const uint8_t *body, size_t length, SegmentRecord &out)
+{
+    const uint8_t *p = body;
+    const uint8_t *const end = body + length;
+
+    if (end - p < 8)
+        return false;
+    out.id = *p++;
+    out.start = getU16(p);
+    p += 2;
+    out.end = getU16(p);
+    p += 2;
+    out.brightness = *p++;
+    // Read through the constant PresetBank patches ids with, so the two cannot drift apart
+    out.effectId = body[SEGMENT_RECORD_EFFECT_OFFSET];
+    p = body + SEGMENT_RECORD_EFFECT_OFFSET + 1;
+    uint8_t nameLen = *p++;
+    if (end - p < nameLen + 1)
+        return false;
+    size_t copyLen = nameLen < SEGMENT_RECORD_NAME_MAX ? nameLen : SEGMENT_RECORD_NAME_MAX;
+    memcpy(out.name, p, copyLen);
+    out.name[copyLen] = '\0';
+    p += nameLen;
+
+    // Parameters beyond SEGMENT_RECORD_MAX_PARAMS are dropped.
+    uint8_t paramCount = *p++;
+    out.paramCount = paramCount < SEGMENT_RECORD_MAX_PARAMS ? paramCount : SEGMENT_RECORD_MAX_PARAMS;
+    if (end - p < (ptrdiff_t)out.paramCount * 5)
+        return false;
+    for (uint8_t i = 0; i < out.paramCount; ++i)
+    {
+        out.params[i].index = p[0];
+        out.params[i].raw = getU32(p + 1);
+        p += 5;
+    }
+
+    // Blend fields, absent from records written before layers existed
+    out.blend = BlendMode::Normal;
+    out.opacity = 255;
+    out.zOrder = 0;
+    if (end - p >= 3)
+    {
+        out.blend = p[0] < (uint8_t)BlendMode::Count ? (BlendMode)p[0] : BlendMode::Normal;
+        out.opacity = p[1];
+        out.zOrder = (int8_t)p[2];
+        p += 3;
+    }
+    // Anything after that belongs to a newer format version.
+    return true;
+}
+
+bool applySegmentRecord(PixelStrip &strip, const SegmentRecord &rec)
+{
+    // Hold frames off until the whole record is applied.
+    FrameLock frameLock;
+
+    PixelStrip::Segment *targetSeg = nullptr;
+    for (auto *s : strip.getSegments())
+    {
+        if (s->getId() == rec.id)
+        {
+            targetSeg = s;
+            break;
+        }
+    }
+    if (!targetSeg)
+    {
+        strip.addSection(rec.start, rec.end, rec.name);
+        targetSeg = strip.getSegments().back();
+    }
+    targetSeg->setRange(rec.start, rec.end);
+    targetSeg->setBrightness(rec.brightness);
+    targetSeg->setBlend(rec.blend, rec.opacity);
+    targetSeg->setZOrder(rec.zOrder);
+
+    // Keep the running effect (and its state) if it is unchanged
+    bool effectKnown = true;
+    if (targetSeg->getEffectId() != rec.effectId)
+    {
+        if (rec.effectId == PixelStrip::Segment::NO_EFFECT)
+        {
+            targetSeg->clearEffect();
+        }
+        else if (!targetSeg->setEffect(rec.effectId))
+        {
+            LOG_WARN("WARN: Unknown effect id %u in segment record.", rec.effectId);
+            targetSeg->clearEffect();
+            effectKnown = false;
+        }
+    }
+
+    // Indices the effect does not have are ignored by setParameterRaw
+    if (targetSeg->activeEffect)
+    {
+        for (uint8_t i = 0; i < rec.paramCount; ++i)
+        {
+            targetSeg->activeEffect->setParameterRaw(rec.params[i].index, rec.params[i].raw);
+        }
+    }
+    return effectKnown;
+}
+
+// --- SegmentRecordParser ---
+
+SegmentRecordParser::SegmentRecordParser()
+{
+    reset();
+}
+
+void SegmentRecordParser::reset()
+{
+    state_ = State::HEADER;
+    headerRead_ = 0;
+    recordCount_ = 0;
+    recordsParsed_ = 0;
+    bodyLength_ = 0;
+    lengthRead_ = 0;
+    bodyRead_ = 0;
+    error_ = nullptr;
+}
+
+SegmentRecordParser::Status SegmentRecordParser::feed(uint8_t byte)
+{
+    switch (state_)
+    {
+    case State::HEADER:
+        header_[headerRead_++] = byte;
+        if (headerRead_ < SEGMENT_STREAM_HEADER_SIZE)
+            return Status::NeedMore;
+        if (header_[0] != SEGMENT_RECORD_VERSION)
+            return fail("Unsupported segment format version");
+        recordCount_ = getU16(header_ + 1);
+        if (recordCount_ == 0)
+        {
+            state_ = State::DONE;
+            return Status::Done;
+        }
+        state_ = State::RECORD_LENGTH;
+        return Status::NeedMore;
+
+    case State::RECORD_LENGTH:
+        bodyLength_ = (bodyLength_ << 8) | byte;
+        if (++lengthRead_ < 2)
+            return Status::NeedMore;
+        if (bodyLength_ == 0)
+            return fail("Empty segment record");
+        bodyRead_ = 0;
+        state_ = State::RECORD_BODY;
+        return Status::NeedMore;
+
+    case State::RECORD_BODY:
+        if (bodyRead_ < SEGMENT_RECORD_MAX_BODY)
+            body_[bodyRead_] = byte;
+        if (++bodyRead_ < bodyLength_)
+            return Status::NeedMore;
+        return finishRecord();
+
+    case State::DONE:
+        return fail("Data after the last segment record");
+
+    case State::FAILED:
+    default:
+        return Status::Error;
+    }
+}
+
+SegmentRecordParser::Status SegmentRecordParser::finishRecord()
+{
+    // Only the buffered prefix of an oversized body can be decoded; the
+    // fields a reader knows about always come first.
+    size_t available = bodyLength_ < SEGMENT_RECORD_MAX_BODY ? bodyLength_ : SEGMENT_RECORD_MAX_BODY;
+    if (!decodeSegmentRecordBody(body_, available, record_))
+        return fail("Truncated segment record");
+
+    recordsParsed_++;
+    bodyLength_ = 0;
+    lengthRead_ = 0;
+    state_ = (recordsParsed_ >= recordCount_) ? State::DONE : State::RECORD_LENGTH;
+    return Status::Record;
+}
+
+SegmentRecordParser::Status SegmentRecordParser::fail(const char *reason)
+{
+    state_ = State::FAILED;
+    error_ = reason;
+    return Status::Error;
+}
+
+const SegmentRecord &SegmentRecordParser::record() const
+{
+    return record_;
+}
+
+const uint8_t *SegmentRecordParser::recordBody(size_t &length) const
+{
+    length = bodyRead_ < SEGMENT_RECORD_MAX_BODY ? bodyRead_ : SEGMENT_RECORD_MAX_BODY;
+    return body_;
+}
+
+uint16_t SegmentRecordParser::recordCount() const
+{
+    return recordCount_;
+}
+
+uint16_t SegmentRecordParser::recordsParsed() const
+{
+    return recordsParsed_;
+}
+
+bool SegmentRecordParser::isDone() const
+{
+    return state_ == State::DONE;
+}
+
+const char *SegmentRecordParser::error() const
+{
+    return error_;
+}
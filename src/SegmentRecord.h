@@ -0,0 +1,155 @@
+/**
+ * @file SegmentRecord.h
+ * @brief Compact binary format for segment configurations, with an encoder
+ * and an incremental parser.
+ *
+ * @details A segment stream is a header followed by length-prefixed records.
+ * All multi-byte fields are big-endian, like the rest of the binary protocol.
+ *
+ *     header : [version:1][record count:2]
+ *     record : [body length:2][body]
+ *     body   : [id:1][start:2][end:2][brightness:1][effect id:1]
+ *              [name length:1][name bytes]
+ *              [param count:1] then per param [param index:1][value:4]
+ *              [blend mode:1][opacity:1][layer:1, signed]
+ *
+ * Effect ids index EFFECT_REGISTRY (0xFF is "no effect"). Parameter indices
+ * and values follow the effect's EffectParameter table and the wire form of
+ * BaseEffect::setParameterRaw, so the format grows with the effect schemas
+ * without changes here. A reader skips body bytes it does not understand,
+ * which lets later versions append fields to a record. The blend fields were
+ * appended that way; a record that ends after its parameters is a Normal,
+ * fully opaque segment on layer 0.
+ *
+ * The parser is fed bytes as packets arrive, from BLE or Serial alike, and
+ * hands out one record at a time; nothing waits for the whole stream.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef SEGMENT_RECORD_H
+#define SEGMENT_RECORD_H
+
+#include <Arduino.h>
+#include "PixelStrip.h"
+
+constexpr uint8_t SEGMENT_RECORD_VERSION = 1;
+constexpr size_t SEGMENT_STREAM_HEADER_SIZE = 3;
+constexpr size_t SEGMENT_RECORD_NAME_MAX = 31;   ///< Segment names are 32-byte C strings
+constexpr size_t SEGMENT_RECORD_EFFECT_OFFSET = 6; ///< Effect id within a body: after id, start, end and brightness
+constexpr uint8_t SEGMENT_RECORD_MAX_PARAMS = 16;
+constexpr size_t SEGMENT_RECORD_MAX_BODY = 12 + SEGMENT_RECORD_NAME_MAX + SEGMENT_RECORD_MAX_PARAMS * 5;
+constexpr size_t SEGMENT_RECORD_MAX_SIZE = 2 + SEGMENT_RECORD_MAX_BODY; ///< Largest encoded record, with its length prefix
+
+/**
+ * @brief One decoded segment record.
+ */
+struct SegmentRecord
+{
+    struct Param
+    {
+        uint8_t index;
+        uint32_t raw;
+    };
+
+    uint8_t id;
+    uint16_t start;
+    uint16_t end;
+    uint8_t brightness;
+    uint8_t effectId;
+    char name[SEGMENT_RECORD_NAME_MAX + 1];
+    uint8_t paramCount;
+    Param params[SEGMENT_RECORD_MAX_PARAMS];
+    BlendMode blend;
+    uint8_t opacity;
+    int8_t zOrder;
+};
+
+/**
+ * @brief Writes the stream header.
+ * @return SEGMENT_STREAM_HEADER_SIZE, or 0 if `capacity` is too small.
+ */
+size_t encodeSegmentStreamHeader(uint16_t recordCount, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Encodes a segment, its effect and every effect parameter as one record.
+ * @return The bytes written including the length prefix, or 0 if `capacity` is too small.
+ */
+size_t encodeSegmentRecord(PixelStrip::Segment &segment, uint8_t *out, size_t capacity);
+
+/**
+ * @brief Decodes one record body (without its length prefix).
+ * @details Bytes after the known fields are ignored, as the stream parser does.
+ * @return False if `length` is too short for the fields the body declares.
+ */
+bool decodeSegmentRecordBody(const uint8_t *body, size_t length, SegmentRecord &out);
+
+/**
+ * @brief Applies a record to the segment with its id, adding the segment if needed.
+ * @details Takes a FrameLock for the duration. An unchanged effect keeps
+ * running with its state; parameters the effect does not have are ignored.
+ * @return False if the record named an effect id this build does not know
+ * (the segment is then left without an effect).
+ */
+bool applySegmentRecord(PixelStrip &strip, const SegmentRecord &rec);
+
+/**
+ * @class SegmentRecordParser
+ * @brief Byte-at-a-time parser for a segment stream.
+ *
+ * @details Feed bytes in order; `feed()` reports when a record is complete
+ * (read it with `record()` before feeding on) or when the stream is malformed.
+ * `isDone()` turns true with the last record. Record bodies are buffered up to
+ * SEGMENT_RECORD_MAX_BODY bytes; any excess is skipped unread.
+ */
+class SegmentRecordParser
+{
+public:
+    enum class Status
+    {
+        NeedMore, ///< Byte consumed; keep feeding.
+        Record,   ///< A record is complete and available from record(); isDone() tells if it was the last.
+        Done,     ///< The header announced no records. Further bytes are errors.
+        Error     ///< Malformed stream; see error(). Call reset() to start over.
+    };
+
+    SegmentRecordParser();
+
+    void reset();
+    Status feed(uint8_t byte);
+
+    const SegmentRecord &record() const;
+    /// The complete record's body as buffered (at most SEGMENT_RECORD_MAX_BODY bytes), valid until the next feed()
+    const uint8_t *recordBody(size_t &length) const;
+    uint16_t recordCount() const;     ///< Records announced by the header
+    uint16_t recordsParsed() const;
+    bool isDone() const;              ///< True once every announced record has been read
+    const char *error() const;        ///< Reason for the last Error, or nullptr
+
+private:
+    enum class State
+    {
+        HEADER,
+        RECORD_LENGTH,
+        RECORD_BODY,
+        DONE,
+        FAILED
+    };
+
+    Status fail(const char *reason);
+    Status finishRecord();
+
+    State state_;
+    uint8_t header_[SEGMENT_STREAM_HEADER_SIZE];
+    uint8_t headerRead_;
+    uint16_t recordCount_;
+    uint16_t recordsParsed_;
+    uint16_t bodyLength_;
+    uint8_t lengthRead_;
+    uint16_t bodyRead_;
+    uint8_t body_[SEGMENT_RECORD_MAX_BODY];
+    SegmentRecord record_;
+    const char *error_;
+};
+
+#endif // SEGMENT_RECORD_H
@@ -0,0 +1,57 @@
+/**
+ * @file SeqLock.h
+ * @brief Single-writer sequence lock for publishing a small snapshot across cores.
+ *
+ * @details The writer bumps the sequence to odd, copies the value in and bumps
+ * it back to even. Readers copy the value and retry if the sequence was odd or
+ * changed meanwhile, so they never block the writer and never see a torn
+ * snapshot. Meant for plain structs of a few dozen bytes published at sensor
+ * rate (AudioFeatureBus, MotionBus).
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <Arduino.h>
+
+template <typename T>
+class SeqLock
+{
+public:
+    /// Writer side. Call from one context only.
+    void publish(const T &value)
+    {
+        // __sync_synchronize() is a full compiler and hardware barrier (a DMB
+        // on the RP2040), ordering the value writes against the sequence.
+        uint32_t seq = seq_;
+        seq_ = seq + 1; // Odd: readers retry
+        __sync_synchronize();
+        value_ = value;
+        __sync_synchronize();
+        seq_ = seq + 2;
+    }
+
+    /// Copies the latest value. Safe from any core; never blocks the writer.
+    void read(T &out) const
+    {
+        while (true)
+        {
+            uint32_t before = seq_;
+            if (before & 1)
+                continue; // Publish in progress; it takes a few microseconds
+            __sync_synchronize();
+            out = value_;
+            __sync_synchronize();
+            if (seq_ == before)
+                return;
+        }
+    }
+
+private:
+    volatile uint32_t seq_ = 0; ///< Odd while a publish is in progress
+    T value_;
+};
+
+#endif // SEQ_LOCK_H
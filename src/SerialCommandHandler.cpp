@@ -5,83 +5,139 @@
 #include "BLEManager.h"
 #include <ArduinoJson.h>
 #include "BinaryCommandHandler.h"
+#include "RenderEngine.h"
+#include "PresetBank.h"
+#include "EffectBench.h"
+#include "Telemetry.h"
+#include "Modulation.h"
+#include "ShowClock.h"
+#include "CommandLine.h"
+#include "Log.h"
 #include <cstring>
 #include <cstdlib>
+#include <stdarg.h>
 
 // Forward declare the binary command handler instance
 extern BinaryCommandHandler binaryCommandHandler;
 extern BLEManager &bleManager;
 
+// --- Dispatch Table ---
+// Looked up case-insensitively. Serial-only commands switch the serial port
+// into a transfer or stream, or (bench) pause the render core for a long
+// report; over BLE the binary protocol has its own opcodes.
+const SerialCommandHandler::Command SerialCommandHandler::COMMANDS[] = {
+    {"help",                 &SerialCommandHandler::handleHelp, false},
+    {"listeffects",          &SerialCommandHandler::handleListEffects, false},
+    {"getstatus",            &SerialCommandHandler::handleGetStatus, false},
+    {"getsavedconfig",       &SerialCommandHandler::handleGetSavedConfig, false},
+    {"getcurrconfig",        &SerialCommandHandler::handleGetCurrConfig, false},
+    {"saveconfig",           &SerialCommandHandler::handleSaveConfig, false},
+    {"setledcount",          &SerialCommandHandler::handleSetLedCount, false},
+    {"getledcount",          &SerialCommandHandler::handleGetLedCount, false},
+    {"listsegments",         &SerialCommandHandler::handleListSegments, false},
+    {"clearsegments",        &SerialCommandHandler::handleClearSegments, false},
+    {"addsegment",           &SerialCommandHandler::handleAddSegment, false},
+    {"seteffect",            &SerialCommandHandler::handleSetEffect, false},
+    {"setblend",             &SerialCommandHandler::handleSetBlend, false},
+    {"setlayer",             &SerialCommandHandler::handleSetLayer, false},
+    {"geteffectinfo",        &SerialCommandHandler::handleGetEffectInfo, false},
+    {"setparameter",         &SerialCommandHandler::handleSetParameter, false},
+    {"setparam",             &SerialCommandHandler::handleSetParameter, false},
+    {"getparams",            &SerialCommandHandler::handleGetParameters, false},
+    {"batchconfig",          &SerialCommandHandler::handleBatchConfig, false},
+    {"getallsegmentconfigs", &SerialCommandHandler::handleGetAllSegmentConfigsSerial, true},
+    {"getalleffects",        &SerialCommandHandler::handleGetAllEffectsSerial, true},
+    {"setallsegmentconfigs", &SerialCommandHandler::handleSetAllSegmentConfigsSerial, true},
+    {"getsegmentsbin",       &SerialCommandHandler::handleGetSegmentsBinarySerial, true},
+    {"setsegmentsbin",       &SerialCommandHandler::handleSetSegmentsBinarySerial, true},
+    {"pixelstream",          &SerialCommandHandler::handlePixelStreamSerial, true},
+    {"setsegmentjson",       &SerialCommandHandler::handleSetSingleSegmentJson, false},
+    {"blestatus",            &SerialCommandHandler::handleBleStatus, false},
+    {"blereset",             &SerialCommandHandler::handleBleReset, true},
+    {"setfps",               &SerialCommandHandler::handleSetFps, false},
+    {"setbrightness",        &SerialCommandHandler::handleSetBrightness, false},
+    {"framestats",           &SerialCommandHandler::handleFrameStats, false},
+    {"stats",                &SerialCommandHandler::handleStats, false},
+    {"bench",                &SerialCommandHandler::handleBench, true},
+    {"audiostats",           &SerialCommandHandler::handleAudioStats, false},
+    {"listpresets",          &SerialCommandHandler::handleListPresets, false},
+    {"modbind",              &SerialCommandHandler::handleModBind, false},
+    {"modclear",             &SerialCommandHandler::handleModClear, false},
+    {"modlist",              &SerialCommandHandler::handleModList, false},
+    {"clock",                &SerialCommandHandler::handleClock, false},
+    {"clocksync",            &SerialCommandHandler::handleClockSync, false},
+    {"savepreset",           &SerialCommandHandler::handleSavePreset, false},
+    {"loadpreset",           &SerialCommandHandler::handleLoadPreset, false},
+    {"deletepreset",         &SerialCommandHandler::handleDeletePreset, false},
+    {"logsink",              &SerialCommandHandler::handleLogSink, false},
+};
+
 // --- Main Command Handling Logic ---
 
-void SerialCommandHandler::handleCommand(char *command)
+TextCommandStatus SerialCommandHandler::handleCommand(char *command, Print &out, bool viaSerial)
 {
-    char *saveptr; // For strtok_r, which is re-entrant and safer than strtok
-    char *cmd = strtok_r(command, " ", &saveptr);
+    CommandArgs words(command);
+    char *cmd = words.next();
     if (!cmd)
+        return TextCommandStatus::Empty;
+    char *args = words.rest();
+
+    // Replies go to whichever front end sent the command
+    _out = &out;
+    TextCommandStatus status = TextCommandStatus::Unknown;
+    for (const Command &c : COMMANDS)
+    {
+        if (strcasecmp(cmd, c.name) != 0)
+            continue;
+        if (c.serialOnly && !viaSerial)
+        {
+            reply("ERR: '%s' is only available on the serial console.", c.name);
+            status = TextCommandStatus::SerialOnly;
+        }
+        else
+        {
+            (this->*c.handler)(args);
+            status = TextCommandStatus::Ok;
+        }
+        break;
+    }
+    if (status == TextCommandStatus::Unknown)
+        reply("ERR: Unknown command '%s'. Type 'help' for a list of commands.", cmd);
+    _out = &Serial;
+    return status;
+}
+
+void SerialCommandHandler::reply(const char *fmt, ...)
+{
+    char line[LOG_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n < 0)
         return;
+    _out->write((const uint8_t *)line, min((size_t)n, sizeof(line) - 1));
+    _out->println();
+}
 
-    // Convert command to lowercase in-place
-    for (char *p = cmd; *p; ++p)
-        *p = tolower(*p);
-
-    // The rest of the original string is now in saveptr
-    char *args = strtok_r(NULL, "", &saveptr);
-
-    if (strcmp(cmd, "help") == 0)
-        handleHelp();
-    else if (strcmp(cmd, "listeffects") == 0)
-        handleListEffects();
-    else if (strcmp(cmd, "getstatus") == 0)
-        handleGetStatus();
-    else if (strcmp(cmd, "getsavedconfig") == 0)
-        handleGetSavedConfig();
-    else if (strcmp(cmd, "getcurrconfig") == 0)
-        handleGetCurrConfig();
-    else if (strcmp(cmd, "saveconfig") == 0)
-        handleSaveConfig();
-    else if (strcmp(cmd, "setledcount") == 0)
-        handleSetLedCount(args);
-    else if (strcmp(cmd, "getledcount") == 0)
-        handleGetLedCount();
-    else if (strcmp(cmd, "listsegments") == 0)
-        handleListSegments();
-    else if (strcmp(cmd, "clearsegments") == 0)
-        handleClearSegments();
-    else if (strcmp(cmd, "addsegment") == 0)
-        handleAddSegment(args);
-    else if (strcmp(cmd, "seteffect") == 0)
-        handleSetEffect(args);
-    else if (strcmp(cmd, "geteffectinfo") == 0)
-        handleGetEffectInfo(args);
-    else if (strcmp(cmd, "setparameter") == 0 || strcmp(cmd, "setparam") == 0)
-        handleSetParameter(args);
-    else if (strcmp(cmd, "getparams") == 0)
-        handleGetParameters(args);
-    else if (strcmp(cmd, "batchconfig") == 0)
-        handleBatchConfig(args);
-    else if (strcmp(cmd, "getallsegmentconfigs") == 0)
-        handleGetAllSegmentConfigsSerial();
-    else if (strcmp(cmd, "getalleffects") == 0)
-        handleGetAllEffectsSerial();
-    else if (strcmp(cmd, "setallsegmentconfigs") == 0)
-        handleSetAllSegmentConfigsSerial();
-    else if (strcmp(cmd, "setsegmentjson") == 0)
-        handleSetSingleSegmentJson(args);
-    else if (strcmp(cmd, "blestatus") == 0)
-        handleBleStatus();
-    else if (strcmp(cmd, "blereset") == 0)
-        handleBleReset();
-    else
+const char *SerialCommandHandler::statusMessage(TextCommandStatus status)
+{
+    switch (status)
     {
-        Serial.print("ERR: Unknown command '");
-        Serial.print(cmd);
-        Serial.println("'. Type 'help' for a list of commands.");
+    case TextCommandStatus::Ok:
+        return "OK";
+    case TextCommandStatus::Empty:
+        return "Empty command";
+    case TextCommandStatus::Unknown:
+        return "Unknown command";
+    case TextCommandStatus::SerialOnly:
+        return "Serial console only";
     }
+    return "Unknown status";
 }
 
 // --- Command Implementations using C-Strings ---
-void SerialCommandHandler::handleGetCurrConfig()
+void SerialCommandHandler::handleGetCurrConfig(char *)
 {
     StaticJsonDocument<2048> doc;
     doc["led_count"] = LED_COUNT;
@@ -97,6 +153,9 @@ void SerialCommandHandler::handleGetCurrConfig()
             segObj["startLed"] = s->startIndex();
             segObj["endLed"] = s->endIndex();
             segObj["brightness"] = s->getBrightness();
+            segObj["blend"] = blendModeName(s->getBlend());
+            segObj["opacity"] = s->getOpacity();
+            segObj["layer"] = s->getZOrder();
 
             if (s->activeEffect)
             {
@@ -130,50 +189,85 @@ void SerialCommandHandler::handleGetCurrConfig()
         }
     }
 
-    // Serialize the JSON document directly to the Serial port
-    serializeJsonPretty(doc, Serial);
-    Serial.println(); // Add a newline for clean output
-}
-
-void SerialCommandHandler::handleHelp()
-{
-    Serial.println("\n--- Serial Command Help ---");
-    Serial.println("Commands are not case-sensitive. Arguments are separated by spaces.");
-    Serial.println("\n[General Commands]");
-    Serial.println("  help                         - Shows this help message.");
-    Serial.println("  getstatus                    - Prints the current status of the device as JSON.");
-    Serial.println("  getcurrconfig                - Prints the current configuration in memory");
-    Serial.println("  getsavedconfig               - Prints the saved configuration from the filesystem.");
-    Serial.println("  saveconfig                   - Saves the current configuration to the filesystem.");
-    Serial.println("\n[LED Configuration]");
-    Serial.println("  getledcount                  - Prints the current LED count.");
-    Serial.println("  setledcount <count>          - Sets the total number of LEDs and restarts.");
-    Serial.println("\n[Segment Management]");
-    Serial.println("  listsegments                 - Lists all current segments.");
-    Serial.println("  clearsegments                - Deletes all user-defined segments.");
-    Serial.println("  addsegment <start> <end> [name]");
-    Serial.println("                               - Adds a new segment.");
-    Serial.println("  setsegmentjson <json>        - Configures a single segment using a JSON string.");
-    Serial.println("\n[Effect & Parameter Control]");
-    Serial.println("  listeffects                  - Lists all available effects.");
-    Serial.println("  seteffect <seg_id> <effect>  - Sets an effect on a specific segment.");
-    Serial.println("  geteffectinfo <seg_id> <effect>");
-    Serial.println("                               - Gets parameter info for an effect.");
-    Serial.println("  setparam <seg_id> <param> <value>");
-    Serial.println("                               - Sets a parameter for the active effect on a segment.");
-    Serial.println("  getparams <seg_id>           - Gets parameters for the active effect on a segment.");
-    Serial.println("\n[Bluetooth Commands]");
-    Serial.println("  blestatus                    - Checks the current Bluetooth connection status.");
-    Serial.println("  blereset                     - Resets the Bluetooth module.");
-    Serial.println("\n[Advanced/Batch Commands]");
-    Serial.println("  batchconfig <json>           - Applies a full configuration from a JSON string.");
-    Serial.println("  getallsegmentconfigs         - Gets the full configuration of all segments as JSON.");
-    Serial.println("  getalleffects                - Gets detailed information for all effects as JSON.");
-    Serial.println("  setallsegmentconfigs         - Initiates receiving segment configurations.");
-    Serial.println("--- End of Help ---\n");
-}
-
-void SerialCommandHandler::handleListEffects()
+    // Serialize the JSON document straight to the reply
+    serializeJsonPretty(doc, *_out);
+    _out->println(); // Add a newline for clean output
+}
+
+void SerialCommandHandler::handleHelp(char *)
+{
+    _out->println("\n--- Serial Command Help ---");
+    _out->println("Commands are not case-sensitive. Arguments are separated by spaces.");
+    _out->println("\n[General Commands]");
+    _out->println("  help                         - Shows this help message.");
+    _out->println("  getstatus                    - Prints the current status of the device as JSON.");
+    _out->println("  getcurrconfig                - Prints the current configuration in memory");
+    _out->println("  getsavedconfig               - Prints the saved configuration from the filesystem.");
+    _out->println("  saveconfig                   - Saves the current configuration to the filesystem.");
+    _out->println("\n[Rendering]");
+    _out->println("  setfps <fps>                 - Sets the frame scheduler's target frame rate.");
+    _out->println("  setbrightness <0-255>        - Sets the global brightness, applied on top of each segment's.");
+    _out->println("  framestats [reset]           - Prints frame and per-segment render timing as JSON.");
+    _out->println("  logsink [serial|ring]        - Shows or sets where log output goes; ring defers it to loop().");
+    _out->println("  stats                        - Prints loop time, FPS, audio time, BLE traffic and heap as JSON.");
+    _out->println("  bench [frames] [lengths...]  - Times every effect, show() and the audio analysis; prints JSON.");
+    _out->println("                                 Rendering, BLE and audio stop while it runs.");
+    _out->println("\n[Audio]");
+    _out->println("  audiostats [reset]           - Prints sample ring overruns, skipped frames and the latest features as JSON.");
+    _out->println("\n[LED Configuration]");
+    _out->println("  getledcount                  - Prints the current LED count.");
+    _out->println("  setledcount <count>          - Sets the total number of LEDs and restarts.");
+    _out->println("\n[Segment Management]");
+    _out->println("  listsegments                 - Lists all current segments.");
+    _out->println("  clearsegments                - Deletes all user-defined segments.");
+    _out->println("  addsegment <start> <end> [name]");
+    _out->println("                               - Adds a new segment.");
+    _out->println("  setsegmentjson <json>        - Configures a single segment using a JSON string.");
+    _out->println("  setblend <seg_id> <mode> [opacity]");
+    _out->println("                               - Blends a segment over the ones below: normal, add, multiply, max, alpha.");
+    _out->println("  setlayer <seg_id> <layer>    - Sets a segment's layer (-128 to 127); higher layers draw on top.");
+    _out->println("\n[Effect & Parameter Control]");
+    _out->println("  listeffects                  - Lists all available effects.");
+    _out->println("  seteffect <seg_id> <effect>  - Sets an effect on a specific segment.");
+    _out->println("  geteffectinfo <seg_id> <effect>");
+    _out->println("                               - Gets parameter info for an effect.");
+    _out->println("  setparam <seg_id> <param> <value>");
+    _out->println("                               - Sets a parameter (by name or index) for the active effect on a segment.");
+    _out->println("  getparams <seg_id>           - Gets parameters for the active effect on a segment.");
+    _out->println("\n[Modulation]");
+    _out->println("  modbind <seg_id> <param> <source> [low] [high] [time_ms]");
+    _out->println("                               - Drives a parameter (by name or index) from a source, within");
+    _out->println("                                 low-high (0-255 of its range). Sources: sine, triangle, saw,");
+    _out->println("                                 square, beat, onset, bass, lowmid, highmid, treble, rms,");
+    _out->println("                                 accelx, accely, accelz, motion. time_ms is the LFO period,");
+    _out->println("                                 the envelope decay or the smoothing; 'none' unbinds.");
+    _out->println("  modclear [seg_id]            - Removes the bindings on a segment, or all of them.");
+    _out->println("  modlist                      - Lists the bindings.");
+    _out->println("\n[Show Clock]");
+    _out->println("  clock                        - Prints the show time and its sync state as JSON.");
+    _out->println("  clocksync <show_ms>          - Feeds a time beacon, as CMD_SYNC_CLOCK does.");
+    _out->println("\n[Presets]");
+    _out->println("  listpresets                  - Lists the stored presets.");
+    _out->println("  savepreset <slot> [name]     - Stores the current segments as a preset.");
+    _out->println("  loadpreset <slot> [show_ms]  - Switches to a preset within one frame, or at that show time.");
+    _out->println("  deletepreset <slot>          - Deletes a preset.");
+    _out->println("\n[Bluetooth Commands]");
+    _out->println("  blestatus                    - Checks the current Bluetooth connection status.");
+    _out->println("  blereset                     - Resets the Bluetooth module.");
+    _out->println("\n[Advanced/Batch Commands]");
+    _out->println("  batchconfig <json>           - Applies a full configuration from a JSON string.");
+    _out->println("  getallsegmentconfigs [window]- Gets the full configuration of all segments as JSON.");
+    _out->println("  getalleffects [window]       - Gets detailed information for all effects as JSON.");
+    _out->println("                                 A window > 0 keeps that many items in flight (seq-numbered ACKs).");
+    _out->println("  setallsegmentconfigs         - Initiates receiving segment configurations.");
+    _out->println("  getsegmentsbin               - Writes all segments as a binary segment stream.");
+    _out->println("  setsegmentsbin               - Replaces all segments from a binary segment stream sent next.");
+    _out->println("  pixelstream                  - Pauses the segments and shows host-rendered frames sent next,");
+    _out->println("                                 until the stream's end marker (see PixelStream.h).");
+    _out->println("--- End of Help ---\n");
+}
+
+void SerialCommandHandler::handleListEffects(char *)
 {
     StaticJsonDocument<512> doc;
     JsonArray effects = doc.createNestedArray("effects");
@@ -181,15 +275,23 @@ void SerialCommandHandler::handleListEffects()
     {
         effects.add(EFFECT_NAMES[i]);
     }
-    serializeJson(doc, Serial);
-    Serial.println();
+    serializeJson(doc, *_out);
+    _out->println();
 }
 
-void SerialCommandHandler::handleGetStatus()
+void SerialCommandHandler::handleGetStatus(char *)
 {
     StaticJsonDocument<1024> doc;
     doc["led_count"] = LED_COUNT;
     doc["brightness"] = strip ? strip->getSegments()[0]->getBrightness() : 0;
+    doc["global_brightness"] = strip ? strip->getGlobalBrightness() : 0;
+
+    // LED counts per physical output, in logical strip order
+    JsonArray outputs = doc.createNestedArray("outputs");
+    for (uint8_t o = 0; strip && o < strip->getOutputCount(); ++o)
+    {
+        outputs.add(strip->getOutputLength(o));
+    }
 
     JsonArray effects = doc.createNestedArray("available_effects");
     for (int i = 0; i < EFFECT_COUNT; ++i)
@@ -208,85 +310,96 @@ void SerialCommandHandler::handleGetStatus()
             segObj["startLed"] = s->startIndex();
             segObj["endLed"] = s->endIndex();
             segObj["brightness"] = s->getBrightness();
+            segObj["blend"] = blendModeName(s->getBlend());
+            segObj["layer"] = s->getZOrder();
             segObj["effect"] = s->activeEffect ? s->activeEffect->getName() : "None";
         }
+
+        const EffectArena &arena = strip->getArena();
+        JsonObject arenaObj = doc.createNestedObject("effect_arena");
+        arenaObj["capacity"] = arena.capacity();
+        arenaObj["used"] = arena.used();
+        arenaObj["high_water"] = arena.highWaterMark();
+        arenaObj["failed"] = arena.failedAllocations();
     }
-    serializeJson(doc, Serial);
-    Serial.println();
+    serializeJson(doc, *_out);
+    _out->println();
 }
 
-void SerialCommandHandler::handleGetSavedConfig()
+void SerialCommandHandler::handleGetSavedConfig(char *)
 {
     static char configBuffer[2048];
     if (loadConfig(configBuffer, sizeof(configBuffer)) > 0)
     {
-        Serial.println(configBuffer);
+        _out->println(configBuffer);
     }
     else
     {
-        Serial.println("{}"); // Print empty JSON if no config found
+        _out->println("{}"); // Print empty JSON if no config found
     }
 }
 
-void SerialCommandHandler::handleSaveConfig()
+void SerialCommandHandler::handleSaveConfig(char *)
 {
     if (saveConfig())
     {
-        Serial.println("OK: Config saved.");
+        reply("OK: Config saved.");
     }
     else
     {
-        Serial.println("ERR: Failed to save config.");
+        reply("ERR: Failed to save config.");
     }
 }
 
-void SerialCommandHandler::handleSetLedCount(const char *args)
+void SerialCommandHandler::handleSetLedCount(char *args)
 {
     if (!args)
     {
-        Serial.println("ERR: Missing LED count.");
+        reply("ERR: Missing LED count.");
         return;
     }
     setLedCount(atoi(args));
 }
 
-void SerialCommandHandler::handleGetLedCount()
+void SerialCommandHandler::handleGetLedCount(char *)
 {
-    Serial.print("LED_COUNT: ");
-    Serial.println(LED_COUNT);
+    _out->print("LED_COUNT: ");
+    _out->println(LED_COUNT);
 }
 
-void SerialCommandHandler::handleListSegments()
+void SerialCommandHandler::handleListSegments(char *)
 {
     if (!strip)
     {
-        Serial.println("ERR: Strip not initialized.");
+        reply("ERR: Strip not initialized.");
         return;
     }
     for (const auto *s : strip->getSegments())
     {
-        Serial.print("Segment ");
-        Serial.print(s->getId());
-        Serial.print(": '");
-        Serial.print(s->getName());
-        Serial.print("' (");
-        Serial.print(s->startIndex());
-        Serial.print("-");
-        Serial.print(s->endIndex());
-        Serial.println(")");
+        _out->print("Segment ");
+        _out->print(s->getId());
+        _out->print(": '");
+        _out->print(s->getName());
+        _out->print("' (");
+        _out->print(s->startIndex());
+        _out->print("-");
+        _out->print(s->endIndex());
+        _out->println(")");
     }
 }
 
-void SerialCommandHandler::handleClearSegments()
+void SerialCommandHandler::handleClearSegments(char *)
 {
     if (strip)
     {
+        FrameLock frameLock;
         strip->clearUserSegments();
-        Serial.println("OK: User segments cleared.");
+        markConfigDirty();
+        reply("OK: User segments cleared.");
     }
     else
     {
-        Serial.println("ERR: Strip not initialized.");
+        reply("ERR: Strip not initialized.");
     }
 }
 
@@ -294,41 +407,39 @@ void SerialCommandHandler::handleAddSegment(char *args)
 {
     if (!args)
     {
-        Serial.println("ERR: Missing arguments for addsegment.");
+        reply("ERR: Missing arguments for addsegment.");
         return;
     }
 
-    char *saveptr;
-    char *startStr = strtok_r(args, " ", &saveptr);
-    char *endStr = strtok_r(NULL, " ", &saveptr);
-    char *nameStr = strtok_r(NULL, "", &saveptr);
+    CommandArgs words(args);
+    char *startStr = words.next();
+    char *endStr = words.next();
+    char *nameStr = words.rest();
 
     if (!startStr || !endStr)
     {
-        Serial.println("ERR: Invalid segment range. Use: addsegment <start> <end> [name]");
+        reply("ERR: Invalid segment range. Use: addsegment <start> <end> [name]");
         return;
     }
 
     int start = atoi(startStr);
     int end = atoi(endStr);
-    String name;
-    if (nameStr)
-    {
-        name = nameStr;
-    }
-    else
-    {
-        name = "segment" + String(strip->getSegments().size());
-    }
-
     if (strip && end >= start)
     {
-        strip->addSection(start, end, name);
-        Serial.println("OK: Segment added.");
+        char defaultName[16];
+        if (!nameStr)
+        {
+            snprintf(defaultName, sizeof(defaultName), "segment%u", (unsigned)strip->getSegments().size());
+            nameStr = defaultName;
+        }
+        FrameLock frameLock;
+        strip->addSection(start, end, nameStr);
+        markConfigDirty();
+        reply("OK: Segment added.");
     }
     else
     {
-        Serial.println("ERR: Invalid segment range or strip not initialized.");
+        reply("ERR: Invalid segment range or strip not initialized.");
     }
 }
 
@@ -336,92 +447,131 @@ void SerialCommandHandler::handleSetEffect(char *args)
 {
     if (!args)
     {
-        Serial.println("ERR: Missing arguments for seteffect.");
+        reply("ERR: Missing arguments for seteffect.");
         return;
     }
 
-    char *saveptr;
-    char *segIndexStr = strtok_r(args, " ", &saveptr);
-    char *effectName = strtok_r(NULL, "", &saveptr);
+    CommandArgs words(args);
+    char *segIndexStr = words.next();
+    char *effectName = words.rest();
 
     if (!segIndexStr || !effectName)
     {
-        Serial.println("ERR: Invalid arguments. Use: seteffect <seg_id> <EffectName>");
+        reply("ERR: Invalid arguments. Use: seteffect <seg_id> <EffectName>");
         return;
     }
 
     int segIndex = atoi(segIndexStr);
     if (!strip || segIndex < 0 || segIndex >= (int)strip->getSegments().size())
     {
-        Serial.println("ERR: Invalid segment index.");
+        reply("ERR: Invalid segment index.");
         return;
     }
 
+    FrameLock frameLock;
     PixelStrip::Segment *seg = strip->getSegments()[segIndex];
-    BaseEffect *newEffect = createEffectByName(effectName, seg);
-
-    if (newEffect)
+    if (setEffectByName(effectName, seg))
     {
-        if (seg->activeEffect)
-            delete seg->activeEffect;
-        seg->activeEffect = newEffect;
-        if (strip)
-        {
-            seg->update();
-            strip->show();
-        }
-        Serial.println("OK: Effect set.");
+        markConfigDirty();
+        reply("OK: Effect set.");
     }
     else
     {
-        Serial.print("ERR: Unknown effect '");
-        Serial.print(effectName);
-        Serial.println("'");
+        reply("ERR: Unknown effect '%s'", effectName);
     }
 }
 
-void SerialCommandHandler::handleGetEffectInfo(char *args)
+void SerialCommandHandler::handleSetBlend(char *args)
 {
-    if (!args)
+    CommandArgs words(args);
+    char *segIndexStr = words.next();
+    char *modeStr = words.next();
+    char *opacityStr = words.next();
+
+    if (!segIndexStr || !modeStr)
+    {
+        reply("ERR: Invalid arguments. Use: setblend <seg_id> <mode> [opacity]");
+        return;
+    }
+
+    int segIndex = atoi(segIndexStr);
+    if (!strip || segIndex < 0 || segIndex >= (int)strip->getSegments().size())
     {
-        Serial.println("ERR: Missing arguments for geteffectinfo.");
+        reply("ERR: Invalid segment index.");
+        return;
+    }
+    BlendMode mode;
+    if (!parseBlendMode(modeStr, mode))
+    {
+        reply("ERR: Unknown blend mode '%s'", modeStr);
         return;
     }
 
-    char *saveptr;
-    strtok_r(args, " ", &saveptr); // Skip segment index, it's a dummy
-    char *effectNameStr = strtok_r(NULL, "", &saveptr);
+    FrameLock frameLock;
+    PixelStrip::Segment *seg = strip->getSegments()[segIndex];
+    seg->setBlend(mode, opacityStr ? (uint8_t)constrain(atoi(opacityStr), 0, 255) : seg->getOpacity());
+    markConfigDirty();
+    reply("OK: Segment %d blends as %s, opacity %u.", segIndex, blendModeName(mode), seg->getOpacity());
+}
 
-    if (!effectNameStr)
+void SerialCommandHandler::handleSetLayer(char *args)
+{
+    CommandArgs words(args);
+    char *segIndexStr = words.next();
+    char *layerStr = words.next();
+
+    if (!segIndexStr || !layerStr)
     {
-        Serial.println("ERR: Missing effect name for GET_EFFECT_INFO.");
+        reply("ERR: Invalid arguments. Use: setlayer <seg_id> <layer>");
         return;
     }
 
-    if (!strip || strip->getSegments().empty())
+    int segIndex = atoi(segIndexStr);
+    if (!strip || segIndex < 0 || segIndex >= (int)strip->getSegments().size())
     {
-        Serial.println("ERR: Strip not initialized.");
+        reply("ERR: Invalid segment index.");
         return;
     }
 
-    PixelStrip::Segment *dummySegment = strip->getSegments()[0];
-    BaseEffect *tempEffect = createEffectByName(effectNameStr, dummySegment);
+    FrameLock frameLock;
+    PixelStrip::Segment *seg = strip->getSegments()[segIndex];
+    seg->setZOrder((int8_t)constrain(atoi(layerStr), -128, 127));
+    markConfigDirty();
+    reply("OK: Segment %d is on layer %d.", segIndex, seg->getZOrder());
+}
 
-    if (!tempEffect)
+void SerialCommandHandler::handleGetEffectInfo(char *args)
+{
+    if (!args)
     {
-        Serial.print("ERR: Failed to create temporary effect for '");
-        Serial.print(effectNameStr);
-        Serial.println("'.");
+        reply("ERR: Missing arguments for geteffectinfo.");
+        return;
+    }
+
+    CommandArgs words(args);
+    words.next(); // Skip segment index, it's a dummy
+    char *effectNameStr = words.rest();
+
+    if (!effectNameStr)
+    {
+        reply("ERR: Missing effect name for GET_EFFECT_INFO.");
+        return;
+    }
+
+    const EffectDescriptor *desc = findEffectDescriptor(effectNameStr);
+    if (!desc)
+    {
+        reply("ERR: Unknown effect '%s'.", effectNameStr);
         return;
     }
 
     StaticJsonDocument<512> doc;
-    doc["effect"] = tempEffect->getName();
+    doc["effect"] = desc->name;
     JsonArray params = doc.createNestedArray("params");
 
-    for (int i = 0; i < tempEffect->getParameterCount(); ++i)
+    for (int i = 0; i < desc->paramCount; ++i)
     {
-        EffectParameter *p = tempEffect->getParameter(i);
+        const EffectParameter *p = &desc->params[i];
         JsonObject p_obj = params.createNestedObject();
         p_obj["name"] = p->name;
 
@@ -447,122 +597,630 @@ void SerialCommandHandler::handleGetEffectInfo(char *args)
         // *** END of ADDED/CORRECTED CODE ***
     }
 
-    serializeJson(doc, Serial);
-    Serial.println();
-    delete tempEffect;
+    serializeJson(doc, *_out);
+    _out->println();
 }
 void SerialCommandHandler::handleSetParameter(char *args)
 {
     if (!args)
     {
-        Serial.println("ERR: Missing arguments for setparameter.");
+        reply("ERR: Missing arguments for setparameter.");
         return;
     }
 
-    char *saveptr;
-    char *segIndexStr = strtok_r(args, " ", &saveptr);
-    char *paramName = strtok_r(NULL, " ", &saveptr);
-    char *valueStr = strtok_r(NULL, "", &saveptr);
+    CommandArgs words(args);
+    char *segIndexStr = words.next();
+    char *paramName = words.next();
+    char *valueStr = words.rest();
 
     if (!segIndexStr || !paramName || !valueStr)
     {
-        Serial.println("ERR: Invalid arguments. Use: setparameter <seg_id> <param_name> <value>");
+        reply("ERR: Invalid arguments. Use: setparameter <seg_id> <param_name|param_index> <value>");
         return;
     }
 
     int segIndex = atoi(segIndexStr);
     if (!strip || segIndex < 0 || segIndex >= (int)strip->getSegments().size())
     {
-        Serial.println("ERR: Invalid segment index.");
+        reply("ERR: Invalid segment index.");
         return;
     }
 
+    FrameLock frameLock;
     PixelStrip::Segment *seg = strip->getSegments()[segIndex];
     if (!seg->activeEffect)
     {
-        Serial.println("ERR: No active effect on segment.");
+        reply("ERR: No active effect on segment.");
         return;
     }
 
+    // The parameter may be given by name or by index
     EffectParameter *p = nullptr;
-    for (int i = 0; i < seg->activeEffect->getParameterCount(); ++i)
+    int paramIndex = -1;
+    if (isdigit((unsigned char)paramName[0]))
+    {
+        paramIndex = atoi(paramName);
+        p = seg->activeEffect->getParameter(paramIndex);
+    }
+    for (int i = 0; !p && i < seg->activeEffect->getParameterCount(); ++i)
     {
         EffectParameter *currentParam = seg->activeEffect->getParameter(i);
         if (strcasecmp(paramName, currentParam->name) == 0)
         {
             p = currentParam;
-            break;
+            paramIndex = i;
         }
     }
 
     if (p == nullptr)
     {
-        Serial.println("ERR: Parameter not found on active effect.");
+        reply("ERR: Parameter not found on active effect.");
+        return;
+    }
+    // The next frame would overwrite it
+    if (ModulationEngine::getInstance().isModulated(seg->getId(), paramIndex, seg->getEffectId()))
+    {
+        reply("ERR: Parameter is modulated; unbind it first (modbind <seg_id> <param> none).");
         return;
     }
 
+    // Written through the resolved parameter; no second lookup by name
     switch (p->type)
     {
     case ParamType::INTEGER:
-        seg->activeEffect->setParameter(p->name, (int)atol(valueStr));
+        p->value.intValue = (int)atol(valueStr);
         break;
     case ParamType::FLOAT:
-        seg->activeEffect->setParameter(p->name, (float)atof(valueStr));
+        p->value.floatValue = (float)atof(valueStr);
         break;
     case ParamType::COLOR:
-        seg->activeEffect->setParameter(p->name, (uint32_t)strtoul(valueStr, NULL, 0));
+        p->value.colorValue = (uint32_t)strtoul(valueStr, NULL, 0);
         break;
     case ParamType::BOOLEAN:
-        seg->activeEffect->setParameter(p->name, (bool)(strcmp(valueStr, "true") == 0 || atoi(valueStr) != 0));
+        p->value.boolValue = strcmp(valueStr, "true") == 0 || atoi(valueStr) != 0;
         break;
     }
-    Serial.println("OK: Parameter set.");
+    seg->activeEffect->markDirty();
+    markConfigDirty();
+    reply("OK: Parameter set.");
 }
 
-void SerialCommandHandler::handleGetParameters(const char *args)
+void SerialCommandHandler::handleGetParameters(char *args)
 {
     if (!args)
     {
-        Serial.println("ERR: Missing segment ID. Usage: getparams <seg_id>");
+        reply("ERR: Missing segment ID. Usage: getparams <seg_id>");
         return;
     }
     int segIndex = atoi(args);
-    // ... rest of the function remains the same
+    if (!strip || segIndex < 0 || segIndex >= (int)strip->getSegments().size())
+    {
+        reply("ERR: Invalid segment index.");
+        return;
+    }
+
+    // Consistent with the render core's view, modulated values included
+    FrameLock frameLock;
+    PixelStrip::Segment *seg = strip->getSegments()[segIndex];
+    if (!seg->activeEffect)
+    {
+        reply("ERR: No active effect on segment.");
+        return;
+    }
+
+    StaticJsonDocument<2048> doc;
+    doc["segment"] = segIndex;
+    doc["effect"] = seg->activeEffect->getName();
+    JsonArray params = doc.createNestedArray("params");
+    for (int i = 0; i < seg->activeEffect->getParameterCount(); ++i)
+    {
+        const EffectParameter *p = seg->activeEffect->getParameter(i);
+        JsonObject p_obj = params.createNestedObject();
+        p_obj["index"] = i;
+        p_obj["name"] = p->name;
+        switch (p->type)
+        {
+        case ParamType::INTEGER:
+            p_obj["type"] = "integer";
+            p_obj["value"] = p->value.intValue;
+            break;
+        case ParamType::FLOAT:
+            p_obj["type"] = "float";
+            p_obj["value"] = p->value.floatValue;
+            break;
+        case ParamType::COLOR:
+            p_obj["type"] = "color";
+            p_obj["value"] = p->value.colorValue;
+            break;
+        case ParamType::BOOLEAN:
+            p_obj["type"] = "boolean";
+            p_obj["value"] = p->value.boolValue;
+            break;
+        }
+        p_obj["modulated"] = ModulationEngine::getInstance().isModulated(seg->getId(), i, seg->getEffectId());
+    }
+    serializeJson(doc, *_out);
+    _out->println();
 }
 
-void SerialCommandHandler::handleBatchConfig(const char *json)
+void SerialCommandHandler::handleBatchConfig(char *json)
 {
     handleBatchConfigJson(json);
 }
 
-void SerialCommandHandler::handleSetSingleSegmentJson(const char *json)
+void SerialCommandHandler::handleSetSingleSegmentJson(char *json)
 {
     binaryCommandHandler.processSingleSegmentJson(json);
 }
 
-void SerialCommandHandler::handleGetAllSegmentConfigsSerial()
+void SerialCommandHandler::handleGetAllSegmentConfigsSerial(char *args)
 {
-    binaryCommandHandler.handleGetAllSegmentConfigs(true);
+    // Optional window size; without one the transfer runs in lockstep
+    binaryCommandHandler.handleGetAllSegmentConfigs(true, args ? atoi(args) : 0);
 }
 
-void SerialCommandHandler::handleGetAllEffectsSerial()
+void SerialCommandHandler::handleGetAllEffectsSerial(char *args)
 {
-    binaryCommandHandler.handleGetAllEffectsCommand(true);
+    binaryCommandHandler.handleGetAllEffectsCommand(true, args ? atoi(args) : 0);
 }
 
-void SerialCommandHandler::handleSetAllSegmentConfigsSerial()
+void SerialCommandHandler::handleSetAllSegmentConfigsSerial(char *)
 {
     binaryCommandHandler.handleSetAllSegmentConfigsCommand(true);
 }
 
-void SerialCommandHandler::handleBleReset()
+void SerialCommandHandler::handleGetSegmentsBinarySerial(char *)
 {
-    Serial.println("Initiating BLE reset from serial command...");
+    binaryCommandHandler.handleGetAllSegmentsBinary(true);
+}
+
+void SerialCommandHandler::handleSetSegmentsBinarySerial(char *)
+{
+    // The stream bytes that follow are routed to the same parser BLE uses
+    binaryCommandHandler.handleSetAllSegmentsBinary(true, nullptr, 0);
+}
+
+void SerialCommandHandler::handlePixelStreamSerial(char *)
+{
+    // Like setsegmentsbin: the bytes that follow go to the decoder BLE uses
+    binaryCommandHandler.handleStartPixelStream(true, nullptr, 0);
+}
+
+void SerialCommandHandler::handleBleReset(char *)
+{
+    _out->println("Initiating BLE reset from serial command...");
     bleManager.reset();
 }
 
-void SerialCommandHandler::handleBleStatus()
+void SerialCommandHandler::handleBleStatus(char *)
+{
+    _out->print("BLE Status: ");
+    _out->println(bleManager.isConnected() ? "Connected" : "Disconnected");
+    _out->print("BLE Notification Size: ");
+    _out->println(bleManager.getChunkSize());
+    _out->print("BLE TX Queued: ");
+    _out->println(bleManager.getTxQueued());
+}
+
+void SerialCommandHandler::handleSetFps(char *args)
+{
+    if (!args || !strip)
+    {
+        reply("ERR: Missing FPS or strip not initialized.");
+        return;
+    }
+    int fps = atoi(args);
+    if (fps < 1 || fps > 240)
+    {
+        reply("ERR: FPS must be between 1 and 240.");
+        return;
+    }
+    FrameLock frameLock;
+    strip->setTargetFps(fps);
+    reply("OK: Target FPS set to %u", strip->getTargetFps());
+}
+
+void SerialCommandHandler::handleSetBrightness(char *args)
+{
+    if (!args || !strip)
+    {
+        reply("ERR: Missing brightness or strip not initialized.");
+        return;
+    }
+    int level = atoi(args);
+    if (level < 0 || level > 255)
+    {
+        reply("ERR: Brightness must be between 0 and 255.");
+        return;
+    }
+    FrameLock frameLock;
+    strip->setGlobalBrightness(level);
+    reply("OK: Global brightness set to %u", strip->getGlobalBrightness());
+}
+
+void SerialCommandHandler::handleLogSink(char *args)
 {
-    Serial.print("BLE Status: ");
-    Serial.println(bleManager.isConnected() ? "Connected" : "Disconnected");
-}
\ No newline at end of file
+    if (args && strcmp(args, "ring") == 0)
+        logSetRingSink(true);
+    else if (args && strcmp(args, "serial") == 0)
+        logSetRingSink(false);
+    else if (args)
+    {
+        reply("ERR: Usage: logsink [serial|ring]");
+        return;
+    }
+    _out->print("Log sink: ");
+    _out->print(logRingSinkEnabled() ? "ring" : "serial");
+    _out->print(" (");
+    _out->print(logDroppedLines());
+    _out->println(" lines dropped)");
+}
+
+void SerialCommandHandler::handleFrameStats(char *args)
+{
+    if (!strip)
+    {
+        reply("ERR: Strip not initialized.");
+        return;
+    }
+    if (args && strcasecmp(args, "reset") == 0)
+    {
+        strip->resetFrameStats();
+        reply("OK: Frame stats reset.");
+        return;
+    }
+
+    // Written one segment at a time so the output is not bounded by a
+    // single JsonDocument when there are many segments.
+    const FrameStats &fs = strip->getFrameStats();
+    StaticJsonDocument<512> doc;
+    doc["target_fps"] = strip->getTargetFps();
+    doc["frame_budget_us"] = strip->getFrameBudgetUs();
+    doc["frames_rendered"] = fs.framesRendered;
+    doc["frames_shown"] = fs.framesShown;
+    doc["shows_skipped"] = fs.framesRendered - min(fs.framesRendered, fs.framesShown);
+    doc["late_frames"] = fs.lateFrames;
+    doc["over_budget_frames"] = fs.overBudgetFrames;
+    doc["last_render_us"] = fs.lastRenderUs;
+    doc["max_render_us"] = fs.maxRenderUs;
+    doc["ble_rx_coalesced"] = binaryCommandHandler.getRxCoalesced();
+    doc["ble_rx_dropped"] = binaryCommandHandler.getRxDropped();
+    doc["ble_rx_queue_peak"] = binaryCommandHandler.getRxQueuePeak();
+    JsonArray limits = doc.createNestedArray("bucket_limits_us");
+    for (uint8_t b = 0; b < RENDER_HIST_BUCKETS - 1; ++b)
+    {
+        limits.add(RenderStats::bucketLimitUs(b));
+    }
+
+    _out->print("{\"frame\":");
+    serializeJson(doc, *_out);
+    _out->print(",\"segments\":[");
+
+    bool first = true;
+    for (auto *s : strip->getSegments())
+    {
+        const RenderStats &rs = s->getRenderStats();
+        StaticJsonDocument<384> segDoc;
+        segDoc["id"] = s->getId();
+        segDoc["name"] = s->getName();
+        segDoc["effect"] = s->activeEffect ? s->activeEffect->getName() : "None";
+        segDoc["samples"] = rs.samples;
+        segDoc["last_us"] = rs.lastUs;
+        segDoc["avg_us"] = rs.averageUs();
+        segDoc["max_us"] = rs.maxUs;
+        JsonArray hist = segDoc.createNestedArray("histogram");
+        for (uint8_t b = 0; b < RENDER_HIST_BUCKETS; ++b)
+        {
+            hist.add(rs.histogram[b]);
+        }
+        if (!first)
+            _out->print(",");
+        serializeJson(segDoc, *_out);
+        first = false;
+    }
+    _out->println("]}");
+}
+
+void SerialCommandHandler::handleStats(char *)
+{
+    // The same figures as CMD_GET_STATS, with the window the averages cover
+    TelemetrySnapshot s = Telemetry::getInstance().snapshot();
+    StaticJsonDocument<512> doc;
+    doc["window_ms"] = TELEMETRY_WINDOW_MS;
+    doc["loop_min_us"] = s.loopMinUs;
+    doc["loop_avg_us"] = s.loopAvgUs;
+    doc["loop_max_us"] = s.loopMaxUs;
+    doc["fps_rendered"] = s.renderedFpsX10 / 10.0f;
+    doc["fps_shown"] = s.shownFpsX10 / 10.0f;
+    doc["audio_avg_us"] = s.audioAvgUs;
+    doc["audio_max_us"] = s.audioMaxUs;
+    doc["pdm_overruns"] = s.pdmOverruns;
+    doc["dropped_samples"] = s.droppedSamples;
+    doc["ble_tx_queued"] = s.txQueued;
+    doc["ble_tx_queue_max"] = s.txQueueMax;
+    doc["ble_bytes_in"] = s.bleBytesIn;
+    doc["ble_bytes_out"] = s.bleBytesOut;
+    doc["free_heap"] = s.freeHeap;
+    doc["largest_free_estimate"] = s.largestFreeEstimate;
+    doc["uptime_ms"] = s.uptimeMs;
+    serializeJson(doc, *_out);
+    _out->println();
+}
+
+void SerialCommandHandler::handleBench(char *args)
+{
+    if (!strip)
+    {
+        reply("ERR: Strip not initialized.");
+        return;
+    }
+
+    uint16_t frames = BENCH_DEFAULT_FRAMES;
+    uint16_t lengths[BENCH_MAX_LENGTHS];
+    uint8_t lengthCount = 0;
+    CommandArgs words(args);
+    char *token = words.next();
+    if (token)
+    {
+        frames = atoi(token);
+        token = words.next();
+    }
+    for (; token && lengthCount < BENCH_MAX_LENGTHS; token = words.next())
+    {
+        lengths[lengthCount++] = atoi(token);
+    }
+    if (frames == 0)
+    {
+        reply("ERR: Use: bench [frames] [lengths...]");
+        return;
+    }
+    if (lengthCount == 0)
+    {
+        for (uint16_t length : BENCH_DEFAULT_LENGTHS)
+            lengths[lengthCount++] = length;
+    }
+
+    runEffectBench(*strip, frames, lengths, lengthCount, *_out);
+}
+
+void SerialCommandHandler::handleAudioStats(char *args)
+{
+    if (args && strcasecmp(args, "reset") == 0)
+    {
+        audioRing.resetStats();
+        reply("OK: Audio stats reset.");
+        return;
+    }
+
+    const AudioRingStats &rs = audioRing.stats();
+    const AudioFeatures &f = audioTrigger.features();
+    StaticJsonDocument<512> doc;
+    doc["ring_samples"] = AUDIO_RING_SAMPLES;
+    doc["hop"] = AUDIO_HOP_SIZE;
+    doc["queued"] = audioRing.available();
+    doc["max_backlog"] = rs.maxBacklog;
+    doc["overruns"] = rs.overruns;
+    doc["dropped_samples"] = rs.droppedSamples;
+    doc["skipped_frames"] = rs.skippedFrames;
+    doc["frames"] = f.sequence;
+    doc["audio_ms"] = f.timestampMs;
+    JsonArray levels = doc.createNestedArray("band_levels");
+    for (uint8_t b = 0; b < AUDIO_BAND_COUNT; ++b)
+    {
+        levels.add(f.bandLevel[b]);
+    }
+    doc["rms"] = f.rms;
+    doc["beats"] = f.beatCount;
+    doc["bpm"] = f.bpm;
+    serializeJson(doc, *_out);
+    _out->println();
+}
+
+void SerialCommandHandler::handleListPresets(char *)
+{
+    PresetBank &bank = PresetBank::getInstance();
+    _out->println("Presets:");
+    for (uint8_t slot = 0; slot < PRESET_SLOTS; ++slot)
+    {
+        if (!bank.isUsed(slot))
+            continue;
+        _out->print("  ");
+        _out->print(slot);
+        _out->print(": '");
+        _out->print(bank.name(slot));
+        _out->print("' (");
+        _out->print(bank.segmentCount(slot));
+        _out->println(" segments)");
+    }
+}
+
+void SerialCommandHandler::handleModBind(char *args)
+{
+    CommandArgs words(args);
+    char *segStr = words.next();
+    char *paramStr = words.next();
+    char *sourceStr = words.next();
+    char *lowStr = words.next();
+    char *highStr = words.next();
+    char *timeStr = words.next();
+    if (!sourceStr || !strip)
+    {
+        reply("ERR: Use: modbind <seg_id> <param> <source> [low] [high] [time_ms]");
+        return;
+    }
+
+    int segIndex = atoi(segStr);
+    if (segIndex < 0 || segIndex >= (int)strip->getSegments().size() || !strip->getSegments()[segIndex]->activeEffect)
+    {
+        reply("ERR: No effect on segment %d.", segIndex);
+        return;
+    }
+    BaseEffect *effect = strip->getSegments()[segIndex]->activeEffect;
+    int paramIndex = isdigit((unsigned char)paramStr[0]) ? atoi(paramStr) : effect->findParameter(paramStr);
+    if (paramIndex < 0)
+    {
+        reply("ERR: Unknown parameter '%s'.", paramStr);
+        return;
+    }
+
+    FrameLock frameLock;
+    ModulationEngine &mod = ModulationEngine::getInstance();
+    if (strcasecmp(sourceStr, "none") == 0)
+    {
+        if (mod.unbind(segIndex, paramIndex))
+            reply("OK: Parameter %d of segment %d unbound.", paramIndex, segIndex);
+        else
+            reply("WARN: Parameter %d of segment %d was not bound.", paramIndex, segIndex);
+        return;
+    }
+    ModSource source;
+    if (!parseModSource(sourceStr, source))
+    {
+        reply("ERR: Unknown source '%s'.", sourceStr);
+        return;
+    }
+    ModBinding binding = {(uint8_t)segIndex, (uint8_t)paramIndex, source,
+                          (uint8_t)(lowStr ? constrain(atoi(lowStr), 0, 255) : 0),
+                          (uint8_t)(highStr ? constrain(atoi(highStr), 0, 255) : 255),
+                          (uint16_t)(timeStr ? constrain(atol(timeStr), 0L, 65535L) : 1000)};
+    ModBindStatus status = mod.bind(*strip, binding);
+    if (status == ModBindStatus::Ok)
+        reply("OK: Parameter %d of segment %d follows %s.", paramIndex, segIndex, modSourceName(source));
+    else
+        reply("ERR: %s.", ModulationEngine::statusMessage(status));
+}
+
+void SerialCommandHandler::handleModClear(char *args)
+{
+    FrameLock frameLock;
+    ModulationEngine::getInstance().clear(args ? (uint8_t)atoi(args) : 0xFF);
+    reply("OK: Bindings removed.");
+}
+
+void SerialCommandHandler::handleModList(char *)
+{
+    FrameLock frameLock; // Consistent with the render core's view
+    ModulationEngine &mod = ModulationEngine::getInstance();
+    _out->print("Bindings: ");
+    _out->print(mod.count());
+    _out->print(" of ");
+    _out->println(MOD_MAX_BINDINGS);
+    for (uint8_t i = 0; i < mod.count(); ++i)
+    {
+        const ModBinding &b = mod.binding(i);
+        _out->print("  segment ");
+        _out->print(b.segmentId);
+        _out->print(" param ");
+        _out->print(b.paramIndex);
+        _out->print(" <- ");
+        _out->print(modSourceName(b.source));
+        _out->print(" (");
+        _out->print(b.low);
+        _out->print("-");
+        _out->print(b.high);
+        _out->print(", ");
+        _out->print(b.timeMs);
+        _out->println(" ms)");
+    }
+}
+
+void SerialCommandHandler::handleClock(char *)
+{
+    ShowClockStatus s = ShowClock::getInstance().status(micros());
+    StaticJsonDocument<192> doc;
+    doc["show_ms"] = s.showMs;
+    doc["local_ms"] = millis();
+    doc["synced"] = s.synced;
+    doc["ppm"] = s.ppm;
+    doc["last_error_us"] = s.lastErrorUs;
+    doc["beacons"] = s.beacons;
+    serializeJson(doc, *_out);
+    _out->println();
+}
+
+void SerialCommandHandler::handleClockSync(char *args)
+{
+    uint32_t arrivedUs = micros();
+    if (!args)
+    {
+        reply("ERR: Use: clocksync <show_ms>");
+        return;
+    }
+    ShowClock::getInstance().beacon(strtoul(args, nullptr, 10), arrivedUs);
+    reply("OK: Beacon applied; error was %ld us.", (long)ShowClock::getInstance().status(arrivedUs).lastErrorUs);
+}
+
+void SerialCommandHandler::handleSavePreset(char *args)
+{
+    CommandArgs words(args);
+    char *slotStr = words.next();
+    char *nameStr = words.rest();
+    if (!slotStr || !strip || atoi(slotStr) < 0 || atoi(slotStr) >= PRESET_SLOTS)
+    {
+        reply("ERR: Use: savepreset <slot 0-%u> [name]", PRESET_SLOTS - 1);
+        return;
+    }
+    uint8_t slot = atoi(slotStr);
+    if (PresetBank::getInstance().save(slot, nameStr, *strip))
+    {
+        reply("OK: Preset %u saved as '%s'.", slot, PresetBank::getInstance().name(slot));
+    }
+    else
+    {
+        reply("ERR: Saving preset %u failed.", slot);
+    }
+}
+
+void SerialCommandHandler::handleLoadPreset(char *args)
+{
+    if (!args || !strip)
+    {
+        reply("ERR: Use: loadpreset <slot> [show_ms]");
+        return;
+    }
+    char *timeStr;
+    unsigned long slotValue = strtoul(args, &timeStr, 10);
+    if (timeStr == args || slotValue >= PRESET_SLOTS)
+    {
+        reply("ERR: Use: loadpreset <slot 0-%u> [show_ms]", PRESET_SLOTS - 1);
+        return;
+    }
+    uint8_t slot = slotValue;
+    while (*timeStr == ' ')
+        timeStr++;
+    if (*timeStr)
+    {
+        if (PresetBank::getInstance().schedule(slot, strtoul(timeStr, nullptr, 10)))
+            reply("OK: Preset %u (%s) scheduled.", slot, PresetBank::getInstance().name(slot));
+        else
+            reply("ERR: Preset slot %u is empty.", slot);
+        return;
+    }
+    if (PresetBank::getInstance().activate(slot, *strip))
+    {
+        markConfigDirty();
+        reply("OK: Preset %u (%s) active.", slot, PresetBank::getInstance().name(slot));
+    }
+    else
+    {
+        reply("ERR: Preset slot %u is empty.", slot);
+    }
+}
+
+void SerialCommandHandler::handleDeletePreset(char *args)
+{
+    if (!args || atoi(args) < 0 || atoi(args) >= PRESET_SLOTS)
+    {
+        reply("ERR: Use: deletepreset <slot 0-%u>", PRESET_SLOTS - 1);
+        return;
+    }
+    uint8_t slot = atoi(args);
+    if (PresetBank::getInstance().remove(slot))
+    {
+        reply("OK: Preset %u deleted.", slot);
+    }
+    else
+    {
+        reply("ERR: Preset slot %u is empty.", slot);
+    }
+}
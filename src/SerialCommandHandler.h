@@ -1,6 +1,14 @@
 /**
  * @file SerialCommandHandler.h
  * @brief Defines a handler for processing text-based commands from the serial port.
+ *
+ * @details The text command core: one static dispatch table, an in-place
+ * tokenizer (CommandLine.h) and fixed error strings, so a command costs no
+ * heap. The serial console feeds it line by line, and BLE through
+ * CMD_TEXT_COMMAND. Each command writes its output, "OK:"/"ERR:" lines
+ * included, to the Print it was handed: Serial for the console, a
+ * BLETextSink (BLEManager.h) for BLE.
+ *
  * @version 0.4
  * @date 2025-07-16
  * @copyright Copyright (c) 2025
@@ -11,6 +19,15 @@
 
 #include <Arduino.h>
 
+/// What became of a text command, for CMD_TEXT_COMMAND's reply.
+enum class TextCommandStatus : uint8_t
+{
+    Ok,
+    Empty,      ///< Nothing but blanks
+    Unknown,
+    SerialOnly  ///< Switches the serial port into a transfer; refused elsewhere
+};
+
 /**
  * @class SerialCommandHandler
  * @brief Handles text-based commands from the serial port for testing and debugging.
@@ -20,36 +37,76 @@ class SerialCommandHandler
 public:
     /**
      * @brief Main entry point for processing a command string from the Serial Monitor.
-     * @param command A mutable C-style string containing the raw command.
+     * @param command A mutable C-style string containing the raw command; it is tokenized in place.
+     * @param out Where the command's output goes. A buffering sink is left for the caller to flush.
+     * @param viaSerial False when the command came from another front end, which cannot run serial-only commands.
      */
-    void handleCommand(char* command);
+    TextCommandStatus handleCommand(char* command, Print &out = Serial, bool viaSerial = true);
+
+    static const char *statusMessage(TextCommandStatus status);
 
 private:
-    // Command-specific handler methods
-    void handleListEffects();
-    void handleGetStatus();
-    void handleGetSavedConfig();
-    void handleGetCurrConfig();
-    void handleSaveConfig();
-    void handleSetLedCount(const char* args);
-    void handleGetLedCount();
-    void handleListSegments();
-    void handleClearSegments();
+    typedef void (SerialCommandHandler::*Handler)(char* args);
+    struct Command
+    {
+        const char *name;
+        Handler handler;
+        bool serialOnly;
+    };
+    static const Command COMMANDS[];
+
+    Print *_out = &Serial; ///< Output of the command being handled
+
+    /** @brief Formats one reply line (printf-style, no trailing newline) to the command's output. */
+    void reply(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    // Command-specific handler methods. Each takes the text after the command
+    // word, or nullptr if there was none.
+    void handleListEffects(char* args);
+    void handleGetStatus(char* args);
+    void handleGetSavedConfig(char* args);
+    void handleGetCurrConfig(char* args);
+    void handleSaveConfig(char* args);
+    void handleSetLedCount(char* args);
+    void handleGetLedCount(char* args);
+    void handleListSegments(char* args);
+    void handleClearSegments(char* args);
     void handleAddSegment(char* args);
     void handleSetEffect(char* args);
+    void handleSetBlend(char* args);
+    void handleSetLayer(char* args);
     void handleGetEffectInfo(char* args);
     void handleSetParameter(char* args);
-    void handleBatchConfig(const char* json);
-    void handleBleReset();
-    void handleBleStatus();
-    void handleHelp();
+    void handleBatchConfig(char* json);
+    void handleBleReset(char* args);
+    void handleBleStatus(char* args);
+    void handleSetFps(char* args);
+    void handleSetBrightness(char* args);
+    void handleFrameStats(char* args);
+    void handleBench(char* args);
+    void handleStats(char* args);
+    void handleLogSink(char* args);
+    void handleAudioStats(char* args);
+    void handleListPresets(char* args);
+    void handleSavePreset(char* args);
+    void handleLoadPreset(char* args);
+    void handleDeletePreset(char* args);
+    void handleModBind(char* args);
+    void handleModClear(char* args);
+    void handleModList(char* args);
+    void handleClock(char* args);
+    void handleClockSync(char* args);
+    void handleHelp(char* args);
 
-    void handleGetAllSegmentConfigsSerial();
-    void handleGetAllEffectsSerial();
-    void handleSetAllSegmentConfigsSerial();
+    void handleGetAllSegmentConfigsSerial(char* args);
+    void handleGetAllEffectsSerial(char* args);
+    void handleSetAllSegmentConfigsSerial(char* args);
+    void handleGetSegmentsBinarySerial(char* args);
+    void handleSetSegmentsBinarySerial(char* args);
+    void handlePixelStreamSerial(char* args);
 
-    void handleGetParameters(const char* args);
-    void handleSetSingleSegmentJson(const char* json);
+    void handleGetParameters(char* args);
+    void handleSetSingleSegmentJson(char* json);
 };
 
 #endif // SERIAL_COMMAND_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ * @file ShowClock.cpp
+ * @brief Beacon handling and the local-to-show time mapping.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "ShowClock.h"
+#include "BinaryCommandHandler.h"
+#include "ByteOrder.h"
+
+uint64_t ShowClock::project(const Mapping &m, uint32_t localUs)
+{
+    // Signed, so a time read just before a re-anchor is still right;
+    // service() keeps the distance far below 2^31 us
+    int32_t elapsed = (int32_t)(localUs - m.refLocalUs);
+    int64_t corrected = elapsed + (int64_t)elapsed * m.ppm / 1000000;
+    return m.refShowUs + corrected;
+}
+
+void ShowClock::anchor(uint32_t localUs, uint64_t showUs, int32_t ppm)
+{
+    current_.refLocalUs = localUs;
+    current_.refShowUs = showUs;
+    current_.ppm = ppm;
+    mapping_.publish(current_);
+}
+
+uint64_t ShowClock::showUs(uint32_t localUs) const
+{
+    Mapping m;
+    mapping_.read(m);
+    return project(m, localUs);
+}
+
+void ShowClock::beacon(uint32_t showMs, uint32_t localUs)
+{
+    uint64_t predicted = project(current_, localUs);
+    // Widen the 32-bit beacon around the prediction, so the 49-day wrap of
+    // the sender's ms counter is not mistaken for a jump
+    int32_t deltaMs = (int32_t)(showMs - (uint32_t)(predicted / 1000));
+    int64_t errorUs = (int64_t)deltaMs * 1000 - (int64_t)(predicted % 1000);
+    uint64_t target = predicted + errorUs;
+
+    beacons_++;
+    lastErrorUs_ = (int32_t)constrain(errorUs, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+    if (!stepped_ || errorUs > (int64_t)SHOWCLOCK_STEP_MS * 1000 || errorUs < -(int64_t)SHOWCLOCK_STEP_MS * 1000)
+    {
+        // Too far off to slew: jump, and keep the rate learned so far
+        stepped_ = true;
+        lastBeaconUs_ = localUs;
+        anchor(localUs, target, current_.ppm);
+        return;
+    }
+
+    // The error built up since the last beacon is mostly rate; trim the rate
+    // by a share of it and the phase by another share, so one late beacon
+    // moves neither much.
+    int32_t ppm = current_.ppm;
+    uint32_t sinceUs = localUs - lastBeaconUs_;
+    if (sinceUs > 0)
+    {
+        ppm += (int32_t)((errorUs * 1000000 / (int64_t)sinceUs) >> SHOWCLOCK_PHASE_SHIFT);
+        ppm = constrain(ppm, -SHOWCLOCK_MAX_PPM, SHOWCLOCK_MAX_PPM);
+    }
+    lastBeaconUs_ = localUs;
+    anchor(localUs, predicted + (errorUs >> SHOWCLOCK_PHASE_SHIFT), ppm);
+}
+
+void ShowClock::service(uint32_t localUs)
+{
+    if (localUs - current_.refLocalUs < SHOWCLOCK_REANCHOR_MS * 1000UL)
+        return;
+    anchor(localUs, project(current_, localUs), current_.ppm);
+}
+
+ShowClockStatus ShowClock::status(uint32_t localUs) const
+{
+    ShowClockStatus s;
+    s.showMs = showMs(localUs);
+    s.synced = stepped_ && (localUs - lastBeaconUs_) < SHOWCLOCK_BEACON_TIMEOUT_MS * 1000UL;
+    s.ppm = current_.ppm;
+    s.lastErrorUs = lastErrorUs_;
+    s.beacons = beacons_;
+    return s;
+}
+
+void ShowClock::encode(const ShowClockStatus &s, uint8_t *out)
+{
+    out[0] = CMD_GET_CLOCK;
+    putU32(out + 1, s.showMs);
+    out[5] = s.synced ? 1 : 0;
+    putU32(out + 6, (uint32_t)s.ppm);
+    putU32(out + 10, (uint32_t)s.lastErrorUs);
+    putU32(out + 14, s.beacons);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file ShowClock.h
+ * @brief A show time base shared by several devices, disciplined by time beacons.
+ *
+ * @details Every cape runs its own crystal, so animations started together
+ * drift apart. The show clock maps the local microsecond counter onto a
+ * common show time: the app (or a tool relaying one cape's CMD_GET_CLOCK to
+ * the others) sends each device CMD_SYNC_CLOCK beacons carrying the show time
+ * in ms, and each device corrects its offset and rate from them.
+ *
+ * A beacon that disagrees with the local estimate by more than
+ * SHOWCLOCK_STEP_MS steps the clock straight to it (the first beacon always
+ * does). Smaller errors are treated as BLE latency jitter plus drift: a
+ * fraction of the error (1 / 2^SHOWCLOCK_PHASE_SHIFT) is applied to the
+ * offset and the error per elapsed time trims the rate, within
+ * SHOWCLOCK_MAX_PPM. Between beacons the clock runs on at the learned rate,
+ * so beacons every few seconds are plenty and nothing is sent per frame.
+ * Before the first beacon the show clock is simply local time.
+ *
+ * The frame scheduler puts frames on a grid of show time, periodic effects
+ * and LFOs take their phase from it (PixelStrip::getShowTimeMs), and presets
+ * can be switched at a given show time (PresetBank::schedule).
+ *
+ * The state is published through a SeqLock: beacons and service() run on
+ * core 0, and showUs() may be called from either core.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef SHOW_CLOCK_H
+#define SHOW_CLOCK_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "SeqLock.h"
+
+constexpr size_t SHOWCLOCK_PACKET_SIZE = 18;
+
+/// What the clock knows about its sync, for CMD_GET_CLOCK and the console.
+struct ShowClockStatus
+{
+    uint32_t showMs = 0;
+    bool synced = false;        ///< A beacon arrived within SHOWCLOCK_BEACON_TIMEOUT_MS
+    int32_t ppm = 0;            ///< Rate correction applied to the local clock
+    int32_t lastErrorUs = 0;    ///< Show time minus the local estimate, at the last beacon
+    uint32_t beacons = 0;       ///< Received since boot
+};
+
+class ShowClock
+{
+public:
+    static ShowClock &getInstance()
+    {
+        static ShowClock instance;
+        return instance;
+    }
+
+    /**
+     * @brief Feeds one time beacon. Core 0 only.
+     * @param showMs The sender's show time.
+     * @param localUs micros() when the beacon arrived.
+     */
+    void beacon(uint32_t showMs, uint32_t localUs);
+
+    /**
+     * @brief Re-anchors the mapping so the local counter can wrap. Call from
+     * the main loop; does nothing most of the time. Core 0 only.
+     */
+    void service(uint32_t localUs);
+
+    /// Show time at local time `localUs`. Any core.
+    uint64_t showUs(uint32_t localUs) const;
+    uint32_t showMs(uint32_t localUs) const { return (uint32_t)(showUs(localUs) / 1000); }
+
+    ShowClockStatus status(uint32_t localUs) const;
+
+    /**
+     * @brief Writes the CMD_GET_CLOCK reply, big-endian:
+     * [0x1E][show ms:4][synced:1][ppm:4][last error us:4][beacons:4].
+     */
+    static void encode(const ShowClockStatus &s, uint8_t *out);
+
+private:
+    ShowClock() = default;
+    ShowClock(const ShowClock &) = delete;
+    ShowClock &operator=(const ShowClock &) = delete;
+
+    struct Mapping
+    {
+        uint32_t refLocalUs = 0;
+        uint64_t refShowUs = 0;
+        int32_t ppm = 0;
+    };
+
+    static uint64_t project(const Mapping &m, uint32_t localUs);
+    void anchor(uint32_t localUs, uint64_t showUs, int32_t ppm);
+
+    SeqLock<Mapping> mapping_;
+    Mapping current_;          ///< The writer's copy of what was last published
+    bool stepped_ = false;     ///< At least one beacon has set the clock
+    uint32_t lastBeaconUs_ = 0;
+    int32_t lastErrorUs_ = 0;
+    uint32_t beacons_ = 0;
+};
+
+#endif // SHOW_CLOCK_H
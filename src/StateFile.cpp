@@ -0,0 +1,475 @@
+/**
+ * @file StateFile.cpp
+ * @brief Slot-based binary state file: incremental atomic saves and a JSON-free boot path.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "StateFile.h"
+#include "Config.h"
+#include "ByteOrder.h"
+#include "Crc32.h"
+#include "EffectLookup.h"
+#include "RenderEngine.h"
+#include "Log.h"
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <vector>
+
+extern const char *STATE_BIN_FILE;
+extern const char *STATE_TMP_FILE;
+
+namespace
+{
+    const uint8_t STATE_MAGIC[4] = {'R', 'C', 'S', 'T'};
+
+    struct StateHeader
+    {
+        uint16_t ledCount;
+        uint16_t segmentCount;
+        uint16_t tableSize;
+        uint16_t slotSize;
+    };
+
+    StateSaveStats saveStats;
+
+    void encodeHeader(const StateHeader &h, uint8_t *out)
+    {
+        memset(out, 0, STATE_HEADER_SIZE);
+        memcpy(out, STATE_MAGIC, sizeof(STATE_MAGIC));
+        out[4] = STATE_FORMAT_VERSION;
+        putU16(out + 6, h.ledCount);
+        putU16(out + 8, h.segmentCount);
+        putU16(out + 10, h.tableSize);
+        putU16(out + 12, h.slotSize);
+        putU32(out + 16, crc32(out, 16));
+    }
+
+    bool readHeader(FILE *file, StateHeader &h)
+    {
+        uint8_t raw[STATE_HEADER_SIZE];
+        if (fseek(file, 0, SEEK_SET) != 0 || fread(raw, 1, sizeof(raw), file) != sizeof(raw))
+            return false;
+        if (memcmp(raw, STATE_MAGIC, sizeof(STATE_MAGIC)) != 0 || raw[4] != STATE_FORMAT_VERSION)
+            return false;
+        if (getU32(raw + 16) != crc32(raw, 16))
+        {
+            LOG_WARN("WARN: State file header failed its checksum.");
+            return false;
+        }
+        h.ledCount = getU16(raw + 6);
+        h.segmentCount = getU16(raw + 8);
+        h.tableSize = getU16(raw + 10);
+        h.slotSize = getU16(raw + 12);
+        return h.tableSize >= 5 && h.slotSize > 6;
+    }
+
+    long slotOffset(const StateHeader &h, uint16_t index)
+    {
+        return (long)STATE_HEADER_SIZE + h.tableSize + (long)index * h.slotSize;
+    }
+
+    // Maps the saved effect ids onto this build's. Identity when the tables match.
+    void loadEffectMap(FILE *file, const StateHeader &h, uint8_t *map)
+    {
+        static uint8_t saved[STATE_EFFECT_TABLE_SIZE];
+        size_t len = h.tableSize < STATE_EFFECT_TABLE_SIZE ? h.tableSize : STATE_EFFECT_TABLE_SIZE;
+        if (fseek(file, STATE_HEADER_SIZE, SEEK_SET) != 0 || fread(saved, 1, len, file) != len)
+            len = 0;
+        if (len != h.tableSize)
+            len = 0; // Larger than this build's; treat as unreadable
+        effectMapFromTable(saved, len, map);
+    }
+
+    // Reads and checks slot `index`. False if it is unreadable or fails its CRC.
+    bool readSlot(FILE *file, const StateHeader &h, uint16_t index, SegmentRecord &rec)
+    {
+        static uint8_t slot[STATE_SLOT_SIZE];
+        size_t len = h.slotSize < STATE_SLOT_SIZE ? h.slotSize : STATE_SLOT_SIZE;
+        if (fseek(file, slotOffset(h, index), SEEK_SET) != 0 || fread(slot, 1, len, file) != len)
+            return false;
+        size_t bodyLen = getU16(slot + 4);
+        if (6 + bodyLen > len || getU32(slot) != crc32(slot + 4, 2 + bodyLen))
+            return false;
+        return decodeSegmentRecordBody(slot + 6, bodyLen, rec);
+    }
+
+    // The save in progress, advanced one step at a time by stepStateSave()
+    struct SaveJob
+    {
+        bool active = false;
+        FILE *file = nullptr;
+        PixelStrip *strip = nullptr;
+        StateHeader header = {};
+        uint16_t nextSlot = 0;
+        uint32_t startUs = 0;
+    };
+    SaveJob job;
+
+    // Record CRCs as of the last completed save, so an autosave with nothing
+    // new never touches the flash
+    std::vector<uint32_t> savedCrcs;
+    std::vector<uint32_t> writtenCrcs;
+    uint16_t savedLedCount = 0;
+    bool savedCrcsValid = false;
+
+    // Fills a whole slot for segment `index` and returns the record's CRC
+    uint32_t encodeSlot(PixelStrip &strip, size_t index, uint8_t *slot)
+    {
+        memset(slot, 0, STATE_SLOT_SIZE);
+        size_t recordLen;
+        {
+            // Parameters are read while the render core is held off
+            FrameLock frameLock;
+            recordLen = encodeSegmentRecord(*strip.getSegments()[index], slot + 4, SEGMENT_RECORD_MAX_SIZE);
+        }
+        uint32_t crc = crc32(slot + 4, recordLen);
+        putU32(slot, crc);
+        return crc;
+    }
+
+    bool unchangedSinceLastSave(PixelStrip *strip, uint16_t ledCount)
+    {
+        size_t count = strip ? strip->getSegments().size() : 0;
+        if (!savedCrcsValid || ledCount != savedLedCount || count != savedCrcs.size())
+            return false;
+        static uint8_t slot[STATE_SLOT_SIZE];
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (encodeSlot(*strip, i, slot) != savedCrcs[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Writes the real header, closes the temporary file and moves it over
+    // the state file. The rename is the commit point: until it lands, boot
+    // still reads the previous state.
+    bool commitJob()
+    {
+        job.header.segmentCount = job.nextSlot;
+        uint8_t raw[STATE_HEADER_SIZE];
+        encodeHeader(job.header, raw);
+        bool ok = fseek(job.file, 0, SEEK_SET) == 0 && fwrite(raw, 1, sizeof(raw), job.file) == sizeof(raw);
+        ok = (fclose(job.file) == 0) && ok;
+        job.file = nullptr;
+        if (!ok)
+        {
+            remove(STATE_TMP_FILE);
+            return false;
+        }
+        if (rename(STATE_TMP_FILE, STATE_BIN_FILE) == 0)
+            return true;
+
+        // Not every filesystem renames over an existing file. If power fails
+        // between these two calls, boot finds the complete temporary file.
+        remove(STATE_BIN_FILE);
+        return rename(STATE_TMP_FILE, STATE_BIN_FILE) == 0;
+    }
+
+    // Opens whichever state file is valid. A temporary file with a valid
+    // header is complete and newer than the state file: its save was cut
+    // off before the rename.
+    FILE *openStateFile(StateHeader &h)
+    {
+        const char *paths[] = {STATE_TMP_FILE, STATE_BIN_FILE};
+        for (const char *path : paths)
+        {
+            FILE *file = fopen(path, "rb");
+            if (!file)
+                continue;
+            if (readHeader(file, h))
+                return file;
+            fclose(file);
+        }
+        return nullptr;
+    }
+
+    void addParameterJson(JsonObject seg, const EffectParameter &p, uint32_t raw)
+    {
+        switch (p.type)
+        {
+        case ParamType::INTEGER:
+            seg[p.name] = (int32_t)raw;
+            break;
+        case ParamType::FLOAT:
+        {
+            float f;
+            memcpy(&f, &raw, sizeof(f));
+            seg[p.name] = f;
+            break;
+        }
+        case ParamType::COLOR:
+            seg[p.name] = raw;
+            break;
+        case ParamType::BOOLEAN:
+            seg[p.name] = raw != 0;
+            break;
+        }
+    }
+}
+
+bool buildEffectTable(uint8_t *table)
+{
+    memset(table, 0, STATE_EFFECT_TABLE_SIZE);
+    size_t pos = 5;
+    table[4] = EFFECT_COUNT;
+    for (uint8_t i = 0; i < EFFECT_COUNT; ++i)
+    {
+        size_t len = strlen(EFFECT_REGISTRY[i].name);
+        if (pos + 1 + len > STATE_EFFECT_TABLE_SIZE)
+            return false;
+        table[pos++] = (uint8_t)len;
+        memcpy(table + pos, EFFECT_REGISTRY[i].name, len);
+        pos += len;
+    }
+    putU32(table, crc32(table + 4, STATE_EFFECT_TABLE_SIZE - 4));
+    return true;
+}
+
+void effectMapFromTable(const uint8_t *saved, size_t len, uint8_t *map)
+{
+    for (int i = 0; i < 256; ++i)
+        map[i] = (uint8_t)i;
+
+    static uint8_t current[STATE_EFFECT_TABLE_SIZE];
+    if (!buildEffectTable(current))
+        return;
+    if (len == STATE_EFFECT_TABLE_SIZE && memcmp(saved, current, 4) == 0)
+        return;
+    if (len < 5 || getU32(saved) != crc32(saved + 4, len - 4))
+    {
+        LOG_WARN("WARN: Saved effect table unreadable; keeping effect ids as saved.");
+        return;
+    }
+
+    LOG_INFO("Effect list changed since the last save; remapping saved effect ids by name.");
+    size_t pos = 5;
+    for (uint8_t id = 0; id < saved[4] && pos < len; ++id)
+    {
+        uint8_t nameLen = saved[pos++];
+        char name[SEGMENT_RECORD_NAME_MAX + 1];
+        size_t copyLen = nameLen < SEGMENT_RECORD_NAME_MAX ? nameLen : SEGMENT_RECORD_NAME_MAX;
+        if (pos + nameLen > len)
+            break;
+        memcpy(name, saved + pos, copyLen);
+        name[copyLen] = '\0';
+        pos += nameLen;
+        map[id] = findEffectId(name); // EffectType::UNKNOWN if this build dropped it
+    }
+}
+
+bool readSavedLedCount(uint16_t &ledCount)
+{
+    StateHeader h;
+    FILE *file = openStateFile(h);
+    if (!file)
+        return false;
+    fclose(file);
+    ledCount = h.ledCount;
+    return true;
+}
+
+int restoreSavedSegments(PixelStrip &strip)
+{
+    StateHeader h;
+    FILE *file = openStateFile(h);
+    if (!file)
+        return -1;
+
+    static uint8_t effectMap[256];
+    loadEffectMap(file, h, effectMap);
+
+    int restored = 0;
+    SegmentRecord rec;
+    for (uint16_t i = 0; i < h.segmentCount; ++i)
+    {
+        if (!readSlot(file, h, i, rec))
+        {
+            LOG_WARN("WARN: Saved segment slot %u is corrupt; skipped.", i);
+            continue;
+        }
+        if (rec.effectId != PixelStrip::Segment::NO_EFFECT)
+            rec.effectId = effectMap[rec.effectId];
+        applySegmentRecord(strip, rec);
+        restored++;
+    }
+    fclose(file);
+    return restored;
+}
+
+StateSaveStatus beginStateSave(PixelStrip *strip, uint16_t ledCount)
+{
+    abortStateSave();
+    saveStats = StateSaveStats();
+    uint32_t startUs = micros();
+
+    if (unchangedSinceLastSave(strip, ledCount))
+    {
+        saveStats.skipped = true;
+        saveStats.durationUs = micros() - startUs;
+        return StateSaveStatus::Done;
+    }
+
+    static uint8_t table[STATE_EFFECT_TABLE_SIZE];
+    if (!buildEffectTable(table))
+    {
+        LOG_ERROR("ERR: Effect names exceed STATE_EFFECT_TABLE_SIZE.");
+        return StateSaveStatus::Failed;
+    }
+
+    job.file = fopen(STATE_TMP_FILE, "w+b");
+    if (!job.file)
+    {
+        LOG_ERROR("ERR: Failed to open the temporary state file for writing.");
+        return StateSaveStatus::Failed;
+    }
+    job.active = true;
+    job.strip = strip;
+    job.header = {ledCount, 0, (uint16_t)STATE_EFFECT_TABLE_SIZE, (uint16_t)STATE_SLOT_SIZE};
+    job.nextSlot = 0;
+    job.startUs = startUs;
+    writtenCrcs.clear();
+
+    // A zeroed header until the last step, so the file is never valid half-written
+    static const uint8_t blankHeader[STATE_HEADER_SIZE] = {0};
+    bool ok = fwrite(blankHeader, 1, sizeof(blankHeader), job.file) == sizeof(blankHeader) &&
+              fwrite(table, 1, sizeof(table), job.file) == sizeof(table);
+    saveStats.steps = 1;
+    saveStats.longestStepUs = micros() - startUs;
+    if (!ok)
+    {
+        LOG_ERROR("ERR: Writing the temporary state file failed.");
+        abortStateSave();
+        return StateSaveStatus::Failed;
+    }
+    return StateSaveStatus::InProgress;
+}
+
+StateSaveStatus stepStateSave()
+{
+    if (!job.active)
+        return StateSaveStatus::Failed;
+    uint32_t stepStartUs = micros();
+
+    // Segments may have been added or removed since the last step
+    size_t segmentCount = job.strip ? job.strip->getSegments().size() : 0;
+    bool ok = true;
+    static uint8_t slot[STATE_SLOT_SIZE];
+    for (uint8_t n = 0; n < STATE_SLOTS_PER_STEP && job.nextSlot < segmentCount && ok; ++n)
+    {
+        writtenCrcs.push_back(encodeSlot(*job.strip, job.nextSlot, slot));
+        ok = fwrite(slot, 1, sizeof(slot), job.file) == sizeof(slot);
+        job.nextSlot++;
+        saveStats.slotsWritten++;
+    }
+
+    bool finished = ok && job.nextSlot >= segmentCount;
+    if (finished)
+        ok = commitJob();
+
+    uint32_t stepUs = micros() - stepStartUs;
+    saveStats.steps++;
+    if (stepUs > saveStats.longestStepUs)
+        saveStats.longestStepUs = stepUs;
+
+    if (!ok)
+    {
+        LOG_ERROR("ERR: Writing the state file failed.");
+        abortStateSave();
+        return StateSaveStatus::Failed;
+    }
+    if (!finished)
+        return StateSaveStatus::InProgress;
+
+    job.active = false;
+    saveStats.durationUs = micros() - job.startUs;
+    savedCrcs.swap(writtenCrcs);
+    savedLedCount = job.header.ledCount;
+    savedCrcsValid = true;
+    return StateSaveStatus::Done;
+}
+
+bool stateSaveInProgress()
+{
+    return job.active;
+}
+
+void abortStateSave()
+{
+    if (job.file)
+    {
+        fclose(job.file);
+        job.file = nullptr;
+        remove(STATE_TMP_FILE);
+    }
+    job.active = false;
+}
+
+bool saveState(PixelStrip *strip, uint16_t ledCount)
+{
+    StateSaveStatus status = beginStateSave(strip, ledCount);
+    while (status == StateSaveStatus::InProgress)
+        status = stepStateSave();
+    if (status != StateSaveStatus::Done)
+        return false;
+
+    if (saveStats.skipped)
+        LOG_INFO("OK: State unchanged since the last save; nothing written.");
+    else
+        LOG_INFO("OK: State saved (%u segments, %lu us).", saveStats.slotsWritten,
+                 (unsigned long)saveStats.durationUs);
+    return true;
+}
+
+const StateSaveStats &lastStateSave()
+{
+    return saveStats;
+}
+
+size_t savedStateToJson(char *buffer, size_t bufferSize)
+{
+    StateHeader h;
+    FILE *file = openStateFile(h);
+    if (!file)
+        return 0;
+
+    static uint8_t effectMap[256];
+    loadEffectMap(file, h, effectMap);
+
+    StaticJsonDocument<2048> doc;
+    doc["led_count"] = h.ledCount;
+    JsonArray segments = doc.createNestedArray("segments");
+    SegmentRecord rec;
+    for (uint16_t i = 0; i < h.segmentCount; ++i)
+    {
+        if (!readSlot(file, h, i, rec))
+            continue;
+        JsonObject seg = segments.createNestedObject();
+        seg["id"] = rec.id;
+        seg["name"] = rec.name;
+        seg["startLed"] = rec.start;
+        seg["endLed"] = rec.end;
+        seg["brightness"] = rec.brightness;
+        seg["blend"] = blendModeName(rec.blend);
+        seg["opacity"] = rec.opacity;
+        seg["layer"] = rec.zOrder;
+
+        uint8_t effectId = rec.effectId == PixelStrip::Segment::NO_EFFECT ? rec.effectId : effectMap[rec.effectId];
+        const EffectDescriptor *desc = getEffectDescriptor(effectId);
+        seg["effect"] = desc ? desc->name : "None";
+        for (uint8_t p = 0; desc && p < rec.paramCount; ++p)
+        {
+            if (rec.params[p].index < desc->paramCount)
+                addParameterJson(seg, desc->params[rec.params[p].index], rec.params[p].raw);
+        }
+    }
+    fclose(file);
+
+    if (doc.overflowed())
+        LOG_WARN("WARN: Saved state exceeds the 2 KB JSON view; some segments are missing from it.");
+    size_t len = serializeJson(doc, buffer, bufferSize);
+    if (len >= bufferSize - 1)
+        LOG_WARN("WARN: Saved state JSON truncated to %u bytes.", (unsigned)bufferSize);
+    return len;
+}
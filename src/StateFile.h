@@ -0,0 +1,124 @@
+/**
+ * @file StateFile.h
+ * @brief Binary persistence of the LED count and segment configuration.
+ *
+ * @details The state file holds one fixed-size slot per segment, and boot
+ * reads each slot straight into a SegmentRecord (SegmentRecord.h) without
+ * any JSON.
+ *
+ *     header       : ["RCST"][version:1][reserved:1][led count:2]
+ *                    [segment count:2][effect table size:2][slot size:2]
+ *                    [reserved:2][crc32 of the preceding 16 bytes:4]
+ *     effect table : [crc32 of the rest of the table:4][count:1]
+ *                    then per effect [name length:1][name], zero-padded
+ *     slot[i]      : [crc32 of the record:4][segment record, with its length
+ *                    prefix][zero padding]
+ *
+ * Multi-byte fields are big-endian, like the rest of the binary protocol.
+ * The header records the table and slot sizes, so a build with different
+ * limits still finds every slot.
+ *
+ * Records store effect ids, which are positions in EFFECT_REGISTRY and may
+ * move between builds. The effect table stores the names behind the ids at
+ * save time; when it differs from the running build, ids are remapped by
+ * name on load.
+ *
+ * A save writes a complete new file to STATE_TMP_FILE and renames it over
+ * STATE_BIN_FILE, so a power loss at any point leaves either the old state or
+ * the new one, never a mix. The header is written last and the rename only
+ * follows a clean close. The work is split into steps of a few slots each
+ * (beginStateSave()/stepStateSave()), which the autosave in ConfigManager runs
+ * from the main loop one step per pass. A save is skipped outright when every
+ * record matches what was last saved. Each slot still carries its own CRC, so
+ * a damaged slot costs only that segment. Boot falls back to the legacy JSON
+ * file (STATE_FILE) when there is no valid state file.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef STATE_FILE_H
+#define STATE_FILE_H
+
+#include <Arduino.h>
+#include "PixelStrip.h"
+#include "SegmentRecord.h"
+
+constexpr uint8_t STATE_FORMAT_VERSION = 1;
+constexpr size_t STATE_HEADER_SIZE = 20;
+constexpr size_t STATE_SLOT_SIZE = 4 + SEGMENT_RECORD_MAX_SIZE;
+
+/// What the last save wrote, and how long its steps took.
+struct StateSaveStats
+{
+    uint16_t slotsWritten = 0;
+    uint16_t steps = 0;         ///< Calls the save was spread over, counting beginStateSave()
+    uint32_t longestStepUs = 0; ///< The longest of those calls
+    uint32_t durationUs = 0;    ///< From beginStateSave() to the rename
+    bool skipped = false;       ///< Nothing had changed, so nothing was written
+};
+
+enum class StateSaveStatus : uint8_t
+{
+    InProgress, ///< Call stepStateSave() again
+    Done,
+    Failed ///< Logged; the previous state file is untouched
+};
+
+/**
+ * @brief Fills `table` (STATE_EFFECT_TABLE_SIZE bytes) with this build's
+ * effect names, in the effect-table layout above.
+ * @return False if the names do not fit.
+ */
+bool buildEffectTable(uint8_t *table);
+
+/**
+ * @brief Fills `map` (256 entries) from the effect ids behind a saved effect
+ * table to this build's ids. Identity when the table matches this build or
+ * cannot be read.
+ */
+void effectMapFromTable(const uint8_t *table, size_t length, uint8_t *map);
+
+/**
+ * @brief Reads the LED count from a valid state file. Needed before the strip exists.
+ * @return False if there is no state file or its header is invalid.
+ */
+bool readSavedLedCount(uint16_t &ledCount);
+
+/**
+ * @brief Applies every saved segment to `strip`.
+ * @return The number of segments restored, or -1 if there is no valid state file.
+ * Slots that fail their CRC are skipped and logged.
+ */
+int restoreSavedSegments(PixelStrip &strip);
+
+/**
+ * @brief Starts saving the LED count and every segment. Abandons any save
+ * already in progress.
+ * @return Done without writing anything if nothing changed since the last save.
+ */
+StateSaveStatus beginStateSave(PixelStrip *strip, uint16_t ledCount);
+
+/**
+ * @brief Writes the next STATE_SLOTS_PER_STEP slots; the final step commits the file.
+ */
+StateSaveStatus stepStateSave();
+
+bool stateSaveInProgress();
+
+/// Drops a save in progress and its temporary file.
+void abortStateSave();
+
+/**
+ * @brief Runs a whole save in one call.
+ */
+bool saveState(PixelStrip *strip, uint16_t ledCount);
+
+const StateSaveStats &lastStateSave();
+
+/**
+ * @brief Renders the saved state as JSON in the legacy state.json layout.
+ * @return The JSON length, or 0 if there is no valid state file.
+ */
+size_t savedStateToJson(char *buffer, size_t bufferSize);
+
+#endif // STATE_FILE_H
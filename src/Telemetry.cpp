@@ -0,0 +1,143 @@
+/**
+ * @file Telemetry.cpp
+ * @brief Implementation of the performance counters and their wire format.
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#include "Telemetry.h"
+#include "globals.h"
+#include "BLEManager.h"
+#include "BinaryCommandHandler.h"
+#include "ByteOrder.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <malloc.h>
+extern "C" char *sbrk(int incr);
+extern "C" char __HeapLimit; // Linker symbol: the end of the heap region
+#endif
+
+namespace
+{
+    // Never handed out by sbrk yet, plus what malloc holds free below the top
+    uint32_t freeHeapBytes()
+    {
+#if defined(ARDUINO_ARCH_RP2040)
+        struct mallinfo mi = mallinfo();
+        return (uint32_t)(&__HeapLimit - sbrk(0)) + mi.fordblks;
+#else
+        return 0;
+#endif
+    }
+
+    // The free chunk at the top of the heap (keepcost) and the sbrk headroom
+    // above it are one contiguous run, so a block that size is always
+    // available. A larger free chunk further down is not seen: mallinfo has
+    // no per-chunk figures, and probing with malloc() would churn the heap.
+    uint32_t largestFreeEstimate()
+    {
+#if defined(ARDUINO_ARCH_RP2040)
+        struct mallinfo mi = mallinfo();
+        return (uint32_t)(&__HeapLimit - sbrk(0)) + mi.keepcost;
+#else
+        return 0;
+#endif
+    }
+
+    uint16_t perSecondX10(uint32_t count, uint32_t us)
+    {
+        if (us == 0)
+            return 0;
+        uint64_t x10 = (uint64_t)count * 10000000ULL / us;
+        return x10 > 0xFFFF ? 0xFFFF : (uint16_t)x10;
+    }
+}
+
+void Telemetry::loopTick(uint32_t nowUs)
+{
+    if (started_)
+        loop_.add(nowUs - lastTickUs_);
+    else
+        windowStartUs_ = nowUs;
+    started_ = true;
+    lastTickUs_ = nowUs;
+
+    uint16_t queued = (uint16_t)BLEManager::getInstance().getTxQueued();
+    if (queued > txQueueMax_)
+        txQueueMax_ = queued;
+
+    if (nowUs - windowStartUs_ >= TELEMETRY_WINDOW_MS * 1000UL)
+        closeWindow(nowUs);
+}
+
+void Telemetry::closeWindow(uint32_t nowUs)
+{
+    uint32_t windowUs = nowUs - windowStartUs_;
+    TelemetrySnapshot &s = last_;
+    s.loopMinUs = loop_.count ? loop_.minUs : 0;
+    s.loopAvgUs = loop_.count ? loop_.totalUs / loop_.count : 0;
+    s.loopMaxUs = loop_.maxUs;
+    s.audioAvgUs = audio_.count ? audio_.totalUs / audio_.count : 0;
+    s.audioMaxUs = audio_.maxUs;
+    s.txQueueMax = txQueueMax_;
+
+    // Written by the render core; aligned words, so each read is whole. A
+    // `framestats reset` in the window just makes the counts start from zero.
+    uint32_t rendered = 0;
+    uint32_t shown = 0;
+    if (strip)
+    {
+        const FrameStats &fs = strip->getFrameStats();
+        rendered = fs.framesRendered;
+        shown = fs.framesShown;
+    }
+    s.renderedFpsX10 = perSecondX10(rendered >= framesRenderedAtStart_ ? rendered - framesRenderedAtStart_ : rendered, windowUs);
+    s.shownFpsX10 = perSecondX10(shown >= framesShownAtStart_ ? shown - framesShownAtStart_ : shown, windowUs);
+    framesRenderedAtStart_ = rendered;
+    framesShownAtStart_ = shown;
+
+    loop_ = Window();
+    audio_ = Window();
+    txQueueMax_ = 0;
+    windowStartUs_ = nowUs;
+}
+
+TelemetrySnapshot Telemetry::snapshot() const
+{
+    TelemetrySnapshot s = last_;
+    const AudioRingStats &rs = audioRing.stats();
+    s.pdmOverruns = rs.overruns;
+    s.droppedSamples = rs.droppedSamples;
+
+    BLEManager &ble = BLEManager::getInstance();
+    s.txQueued = (uint16_t)ble.getTxQueued();
+    s.bleBytesIn = ble.getRxBytes();
+    s.bleBytesOut = ble.getTxBytes();
+
+    s.freeHeap = freeHeapBytes();
+    s.largestFreeEstimate = largestFreeEstimate();
+    s.uptimeMs = millis();
+    return s;
+}
+
+void Telemetry::encode(const TelemetrySnapshot &s, uint8_t *out)
+{
+    *out++ = CMD_GET_STATS;
+    *out++ = TELEMETRY_FORMAT_VERSION;
+    out = putU32(out, s.loopMinUs);
+    out = putU32(out, s.loopAvgUs);
+    out = putU32(out, s.loopMaxUs);
+    out = putU16(out, s.renderedFpsX10);
+    out = putU16(out, s.shownFpsX10);
+    out = putU32(out, s.audioAvgUs);
+    out = putU32(out, s.audioMaxUs);
+    out = putU32(out, s.pdmOverruns);
+    out = putU32(out, s.droppedSamples);
+    out = putU16(out, s.txQueued);
+    out = putU16(out, s.txQueueMax);
+    out = putU32(out, s.bleBytesIn);
+    out = putU32(out, s.bleBytesOut);
+    out = putU32(out, s.freeHeap);
+    out = putU32(out, s.largestFreeEstimate);
+    putU32(out, s.uptimeMs);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file Telemetry.h
+ * @brief Live performance counters for the app and the serial console.
+ *
+ * @details The main loop, the audio path and BLEManager bump plain counters;
+ * nothing in those hot paths takes a lock or allocates. Counters are gathered
+ * over TELEMETRY_WINDOW_MS windows and the last complete window is what
+ * snapshot() reports, so the numbers follow the current load rather than
+ * averaging over the whole uptime. Every counter is written by core 0 only;
+ * the render core's frame counts are read as single aligned words.
+ *
+ * Binary reply to CMD_GET_STATS, big-endian:
+ *
+ *     [0x1A][version:1]
+ *     [loop min us:4][loop avg us:4][loop max us:4]
+ *     [rendered fps x10:2][shown fps x10:2]
+ *     [audio analysis avg us:4][audio analysis max us:4]
+ *     [PDM overruns:4][dropped samples:4]
+ *     [TX queue bytes:2][TX queue max bytes:2]
+ *     [BLE bytes in:4][BLE bytes out:4]
+ *     [free heap:4][largest free block, lower bound:4][uptime ms:4]
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+constexpr uint8_t TELEMETRY_FORMAT_VERSION = 1;
+constexpr size_t TELEMETRY_PACKET_SIZE = 58;
+
+/// One window's figures plus the running totals, as reported.
+struct TelemetrySnapshot
+{
+    uint32_t loopMinUs = 0;
+    uint32_t loopAvgUs = 0;
+    uint32_t loopMaxUs = 0;
+    uint16_t renderedFpsX10 = 0; ///< Frames whose segments were updated, per second, times 10
+    uint16_t shownFpsX10 = 0;    ///< Frames pushed to the outputs, likewise
+    uint32_t audioAvgUs = 0;     ///< AudioTrigger::update(), the band analysis included
+    uint32_t audioMaxUs = 0;
+    uint32_t pdmOverruns = 0;    ///< Since boot, from the sample ring
+    uint32_t droppedSamples = 0;
+    uint16_t txQueued = 0;       ///< BLE TX queue bytes right now
+    uint16_t txQueueMax = 0;     ///< Most seen at a loop pass during the window
+    uint32_t bleBytesIn = 0;     ///< Since boot
+    uint32_t bleBytesOut = 0;
+    uint32_t freeHeap = 0;
+    uint32_t largestFreeEstimate = 0; ///< Free heap at the top, in one piece: the largest block is at least this
+    uint32_t uptimeMs = 0;
+};
+
+class Telemetry
+{
+public:
+    static Telemetry &getInstance()
+    {
+        static Telemetry instance;
+        return instance;
+    }
+
+    /// Call once at the top of every loop() pass; times the previous pass.
+    void loopTick(uint32_t nowUs);
+
+    /// Time taken by one AudioTrigger::update().
+    void recordAudioFrame(uint32_t us)
+    {
+        audio_.add(us);
+    }
+
+    /**
+     * @brief The last complete window plus the current counters and heap.
+     * @details The heap figures come from mallinfo(); nothing is allocated.
+     */
+    TelemetrySnapshot snapshot() const;
+
+    /// Encodes `s` in the CMD_GET_STATS layout; `out` holds TELEMETRY_PACKET_SIZE bytes.
+    static void encode(const TelemetrySnapshot &s, uint8_t *out);
+
+private:
+    Telemetry() = default;
+    Telemetry(const Telemetry &) = delete;
+    Telemetry &operator=(const Telemetry &) = delete;
+
+    struct Window
+    {
+        uint32_t count = 0;
+        uint32_t totalUs = 0;
+        uint32_t minUs = UINT32_MAX;
+        uint32_t maxUs = 0;
+
+        void add(uint32_t us)
+        {
+            count++;
+            totalUs += us;
+            if (us < minUs)
+                minUs = us;
+            if (us > maxUs)
+                maxUs = us;
+        }
+    };
+
+    void closeWindow(uint32_t nowUs);
+
+    // Being gathered
+    Window loop_;
+    Window audio_;
+    uint16_t txQueueMax_ = 0;
+    uint32_t windowStartUs_ = 0;
+    uint32_t lastTickUs_ = 0;
+    uint32_t framesRenderedAtStart_ = 0;
+    uint32_t framesShownAtStart_ = 0;
+    bool started_ = false;
+
+    // The last complete window
+    TelemetrySnapshot last_;
+};
+
+#endif // TELEMETRY_H
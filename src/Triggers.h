@@ -2,62 +2,90 @@
 #define TRIGGERS_H
 
 #include <Arduino.h>
-#include <ArduinoFFT.h>
+#include <type_traits>
+#include "Config.h"
+#include "AudioAnalysis.h"
+#include "AudioFeatures.h"
 
 // NOTE: SAMPLES and SAMPLING_FREQUENCY are now defined in the main .cpp file.
 
-using TriggerCallback = void (*)(bool isActive, uint8_t value);
-
-// The AudioTrigger class is now a "template". This allows it to create arrays
-// of a size that is defined in your main file, which is a more stable design.
-template<size_t SAMPLES>
+// AudioTrigger is the audio analysis stage. Each block goes through the
+// Analyzer once (band magnitudes, see AudioAnalysis.h; the default follows
+// AUDIO_USE_FFT_BACKEND in Config.h), gets RMS, auto-scaled levels, onset/beat
+// detection and a tempo estimate added, and is published as an AudioFeatures
+// snapshot on the AudioFeatureBus for every effect to read.
+template<size_t SAMPLES,
+         typename Analyzer = typename std::conditional<AUDIO_USE_FFT_BACKEND,
+                                                       FftBandAnalyzer<SAMPLES>,
+                                                       GoertzelBandAnalyzer<SAMPLES>>::type>
 class AudioTrigger {
 public:
-    // The constructor is now simpler.
+    // threshold/peakMax/minBrightness shape the legacy bass trigger
     AudioTrigger(int threshold = 10000, int peakMax = 60000, int minBrightness = 20)
         : threshold_(threshold),
           peakMax_(peakMax),
           minBrightness_(minBrightness),
-          callback_(nullptr),
-          FFT() {}
-
-    // Method to register the callback function
-    void onTrigger(TriggerCallback cb) {
-        callback_ = cb;
-    }
+          levelHistory_() {}
 
-    // The update function now takes the audio buffer as an argument.
-    void update(volatile int16_t sampleBuffer[]) {
-        if (!callback_) return;
+    // Analyses one SAMPLES-long frame. Frames overlap by SAMPLES - AUDIO_HOP_SIZE;
+    // `now` is the frame's time on the audio clock (see processAudio), so beat
+    // timing follows the samples rather than when the main loop got to them.
+    void update(const int16_t sampleBuffer[], uint32_t now) {
+        AudioFeatures &f = features_;
+        f.sequence++;
+        f.timestampMs = now;
 
-        // Copy volatile PDM buffer to a local buffer for FFT processing
-        for(size_t i=0; i<SAMPLES; i++) {
-            vReal[i] = sampleBuffer[i];
-            vImag[i] = 0;
-        }
-
-        // Perform FFT analysis
-        FFT.windowing(vReal, SAMPLES, FFT_WIN_TYP_HAMMING, FFT_FORWARD);
-        FFT.compute(vReal, vImag, SAMPLES, FFT_FORWARD);
-        FFT.complexToMagnitude(vReal, vImag, SAMPLES);
-
-        // Analyze the specific frequency bins that correspond to bass.
-        double bassMagnitude = 0;
-        for (int i = 1; i < 5; i++) { // Bins 1-4 cover the typical bass range
-            bassMagnitude += vReal[i];
-        }
+        analyzer_.bandMagnitudes(sampleBuffer, f.bandMagnitude);
+        f.rms = blockRms(sampleBuffer);
 
         // Print the detected magnitude for easy tuning of the threshold
         // Serial.print("Bass Magnitude: ");
-        // Serial.println(bassMagnitude);
+        // Serial.println(f.bandMagnitude[AUDIO_BAND_BASS]);
 
-        // If bass magnitude is over the threshold, fire the callback.
-        if (bassMagnitude > threshold_) {
+        // Legacy trigger: bass over the threshold, brightness mapped up to peakMax
+        float bassMagnitude = f.bandMagnitude[AUDIO_BAND_BASS];
+        f.triggerActive = bassMagnitude > threshold_;
+        if (f.triggerActive) {
             int value = map(bassMagnitude, threshold_, peakMax_, minBrightness_, 255);
-            callback_(true, constrain(value, minBrightness_, 255));
+            f.triggerBrightness = constrain(value, minBrightness_, 255);
         } else {
-            callback_(false, 0);
+            f.triggerBrightness = 0;
         }
+
+        // Rises are measured against the last frame that did not overlap this one
+        uint8_t *previous = levelHistory_[historyIndex_];
+        uint8_t strongestRise = 0;
+        int bassRise = 0;
+        for (uint8_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+            f.bandLevel[b] = bandTrackers_[b].update(f.bandMagnitude[b], AUDIO_BAND_MIN_RANGE);
+            int rise = (int)f.bandLevel[b] - previous[b];
+            if (rise > strongestRise) strongestRise = rise;
+            if (b == AUDIO_BAND_BASS) bassRise = rise;
+            previous[b] = f.bandLevel[b];
+        }
+        historyIndex_ = (historyIndex_ + 1) % LEVEL_HISTORY;
+        f.rmsLevel = rmsTracker_.update(f.rms, AUDIO_RMS_MIN_RANGE);
+
+        // Onsets count rising edges, so a rise spread over several frames is one onset
+        bool onset = strongestRise >= AUDIO_ONSET_DELTA;
+        if (onset && !inOnset_) f.onsetCount++;
+        inOnset_ = onset;
+        f.onsetStrength = strongestRise;
+
+        if (bassRise >= AUDIO_ONSET_DELTA &&
+            (f.beatCount == 0 || now - f.lastBeatMs >= AUDIO_BEAT_MIN_INTERVAL_MS)) {
+            if (f.beatCount > 0) updateTempo(now - f.lastBeatMs);
+            f.beatCount++;
+            f.lastBeatMs = now;
+        }
+
+        AudioFeatureBus::getInstance().publish(f);
+    }
+
+    // Band analysis alone, leaving the features and trackers untouched, so the
+    // serial bench can time it. Call from the audio core, like update().
+    void analyseOnly(const int16_t sampleBuffer[], float out[AUDIO_BAND_COUNT]) {
+        analyzer_.bandMagnitudes(sampleBuffer, out);
     }
 
     // Allows the threshold to be changed on the fly from main.cpp
@@ -65,17 +93,59 @@ public:
         threshold_ = newThreshold;
     }
 
+    // The latest snapshot, for code on the audio core; effects use PixelStrip::getAudio()
+    const AudioFeatures &features() const {
+        return features_;
+    }
+
 private:
+    // Background (slow average) and decaying peak of one signal; its level is
+    // the part above the background, scaled to the recent peak.
+    struct LevelTracker {
+        float background = 0;
+        float peak = 0;
+
+        uint8_t update(float value, float minRange) {
+            background += (value - background) * AUDIO_BACKGROUND_RATE;
+            peak = max(value, peak * AUDIO_PEAK_DECAY);
+            float above = value - background;
+            if (above <= 0) return 0;
+            float range = max(peak - background, minRange);
+            return (uint8_t)min(above * 255.0f / range, 255.0f);
+        }
+    };
+
+    static float blockRms(const int16_t samples[]) {
+        uint64_t sumSquares = 0;
+        for (size_t i = 0; i < SAMPLES; i++) {
+            int32_t x = samples[i];
+            sumSquares += (uint32_t)(x * x);
+        }
+        return sqrtf((float)sumSquares / SAMPLES);
+    }
+
+    // Folds the beat interval into the AUDIO_BPM_MIN..MAX octave and smooths it
+    void updateTempo(uint32_t intervalMs) {
+        if (intervalMs > AUDIO_BEAT_TIMEOUT_MS) return; // A gap, not a tempo
+        float bpm = 60000.0f / intervalMs;
+        while (bpm < AUDIO_BPM_MIN) bpm *= 2;
+        while (bpm > AUDIO_BPM_MAX) bpm /= 2;
+        bpmEstimate_ = bpmEstimate_ == 0 ? bpm : bpmEstimate_ + (bpm - bpmEstimate_) * AUDIO_BPM_SMOOTHING;
+        features_.bpm = (uint16_t)(bpmEstimate_ + 0.5f);
+    }
+
     int threshold_;
     int peakMax_;
     int minBrightness_;
-    TriggerCallback callback_;
-
-    // FFT-related variables
-    ArduinoFFT<double> FFT;
-    // These arrays now correctly use the template parameter for their size.
-    double vReal[SAMPLES];
-    double vImag[SAMPLES];
+    Analyzer analyzer_;
+    AudioFeatures features_;
+    LevelTracker bandTrackers_[AUDIO_BAND_COUNT];
+    LevelTracker rmsTracker_;
+    static constexpr uint8_t LEVEL_HISTORY = SAMPLES / AUDIO_HOP_SIZE;
+    uint8_t levelHistory_[LEVEL_HISTORY][AUDIO_BAND_COUNT];
+    uint8_t historyIndex_ = 0;
+    bool inOnset_ = false;
+    float bpmEstimate_ = 0;
 };
 
 #endif // TRIGGERS_H
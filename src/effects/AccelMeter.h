@@ -6,79 +6,62 @@
 #include "BaseEffect.h"    // <<-- Add this line
 #include <Arduino.h>
 
-// Provided by your main.cpp (live accel data)
-extern float accelX;
-
 class AccelMeter : public BaseEffect {
 private:
     PixelStrip::Segment* segment;
     EffectParameter params[2];
+    int shownCenter = -1; // Where the bubble was drawn last
 
 public:
-    AccelMeter(PixelStrip::Segment* seg) : segment(seg) {
-        // Parameter 1: Bubble Color
-        params[0].name = "color";
-        params[0].type = ParamType::COLOR;
-        params[0].value.colorValue = 0x00FF00; // Green
-        params[0].min_val = 0.0; // Initialize for COLOR type
-        params[0].max_val = 0.0; // Initialize for COLOR type
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            colorParam("color", 0x00FF00),
+            intParam("bubble_size", 5, 1, 25),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"AccelMeter", kParams, 2};
+        return kDescriptor;
+    }
 
-        // Parameter 2: Bubble Size
-        params[1].name = "bubble_size";
-        params[1].type = ParamType::INTEGER;
-        params[1].value.intValue = 5;
-        params[1].min_val = 1;
-        params[1].max_val = 25;
+    AccelMeter(PixelStrip::Segment* seg) : segment(seg) {
+        loadParameterDefaults(params, descriptor());
     }
 
-    void update() override {
+    bool update(uint32_t deltaMs) override {
         uint32_t bubbleColorValue = params[0].value.colorValue;
         int      bubbleSize       = params[1].value.intValue;
 
         int startPixel = segment->startIndex();
         int numPixels  = segment->endIndex() - startPixel + 1;
+        float accelX = segment->getParent().getMotion().accelX;
         float mapped_position = (accelX + 1.0f) * (numPixels - bubbleSize) / 2.0f;
         int centerPixel = constrain((int)mapped_position, 0, numPixels - bubbleSize) + startPixel;
 
+        bool dirty = takeDirty();
+        if (centerPixel == shownCenter && !dirty) return false;
+        shownCenter = centerPixel;
+
         RgbColor finalBubbleColor(
             (bubbleColorValue >> 16) & 0xFF,
             (bubbleColorValue >> 8)  & 0xFF,
             bubbleColorValue         & 0xFF
         );
-        finalBubbleColor.Dim(segment->getBrightness());
 
         segment->allOff();
         for (int i = 0; i < bubbleSize; ++i) {
-            segment->getParent().getStrip().SetPixelColor(centerPixel + i, finalBubbleColor);
+            segment->getParent().setPixel(centerPixel + i, finalBubbleColor);
         }
+        return true;
     }
 
     // --- Polymorphic API ---
 
-    const char* getName() const override { return "AccelMeter"; }
-    int getParameterCount() const override { return 2; }
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter* getParameter(int index) override {
         if (index >= 0 && index < 2) return &params[index];
         return nullptr;
     }
-
-    // Optional: Allow set by name/type
-    void setParameter(const char* name, int value) override {
-        for (int i = 0; i < 2; ++i) {
-            if (strcmp(params[i].name, name) == 0 && params[i].type == ParamType::INTEGER) {
-                params[i].value.intValue = value;
-                return;
-            }
-        }
-    }
-    void setParameter(const char* name, uint32_t value) override {
-        for (int i = 0; i < 2; ++i) {
-            if (strcmp(params[i].name, name) == 0 && params[i].type == ParamType::COLOR) {
-                params[i].value.colorValue = value;
-                return;
-            }
-        }
-    }
 };
 
 #endif // ACCELMETER_H
\ No newline at end of file
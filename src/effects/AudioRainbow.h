@@ -0,0 +1,80 @@
+#ifndef AUDIORAINBOW_H
+#define AUDIORAINBOW_H
+
+#include "../PixelStrip.h"
+#include "EffectParameter.h"
+#include "BaseEffect.h"
+#include <Arduino.h>
+
+// A rainbow that scrolls faster with loudness, brightens with the bass and
+// steps its hue on every beat. Reads the strip's per-frame AudioFeatures.
+class AudioRainbow : public BaseEffect {
+private:
+    PixelStrip::Segment* segment;
+    EffectParameter params[3];
+
+    uint32_t firstPixelHue;   // 16-bit wheel hue in 16.8 fixed point, so slow speeds still move
+    uint32_t lastBeatCount;
+    uint8_t shownLevel;
+
+public:
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            intParam("speed", 20, 5, 100),         // ms per hue step when quiet, as RainbowCycle
+            intParam("floor", 40, 0, 255),         // Brightness with no bass
+            boolParam("beat_jump", true),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"AudioRainbow", kParams, 3};
+        return kDescriptor;
+    }
+
+    AudioRainbow(PixelStrip::Segment* seg) : segment(seg) {
+        loadParameterDefaults(params, descriptor());
+        firstPixelHue = 0;
+        lastBeatCount = 0;
+        shownLevel = 0;
+    }
+
+    bool update(uint32_t deltaMs) override {
+        const AudioFeatures& audio = segment->getParent().getAudio();
+        uint32_t interval = max(params[0].value.intValue, 1);
+        int floorLevel = params[1].value.intValue;
+
+        // Up to 4x the base speed at full loudness
+        uint32_t stepsQ8 = deltaMs * 256 * (255 + 3 * audio.rmsLevel) / (255 * interval);
+        firstPixelHue += stepsQ8 * 256;
+        if (params[2].value.boolValue && audio.beatCount != lastBeatCount) {
+            firstPixelHue += 8192UL << 8; // An eighth of the wheel
+        }
+        lastBeatCount = audio.beatCount;
+
+        // Attack instantly, release over about half a second
+        uint8_t target = audio.bandLevel[AUDIO_BAND_BASS];
+        uint32_t release = deltaMs / 2;
+        if (target >= shownLevel) shownLevel = target;
+        else shownLevel -= min<uint32_t>(shownLevel - target, release);
+
+        uint8_t value = floorLevel + ((255 - floorLevel) * shownLevel) / 255;
+        // One full wheel across the segment; the hue step is 16.16 fixed point
+        uint16_t length = segment->endIndex() - segment->startIndex() + 1;
+        uint32_t hueStep = (uint32_t)(0x100000000ULL / length);
+        uint32_t hueAcc = (uint32_t)(uint16_t)(firstPixelHue >> 8) << 16;
+        uint8_t* px = segment->pixelBytes();
+        for (uint16_t i = segment->length(); i > 0; --i, px += 3, hueAcc += hueStep) {
+            uint32_t c = PixelStrip::hueWheel(hueAcc >> 16);
+            PixelStrip::storeGrb(px, PixelStrip::scaleChannel(c >> 16, value), PixelStrip::scaleChannel(c >> 8, value),
+                                 PixelStrip::scaleChannel(c, value));
+        }
+        return true;
+    }
+
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
+    EffectParameter* getParameter(int index) override {
+        if (index >= 0 && index < 3) return &params[index];
+        return nullptr;
+    }
+};
+
+#endif // AUDIORAINBOW_H
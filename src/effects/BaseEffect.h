@@ -1,4 +1,5 @@
 #pragma once
+#include <string.h>
 #include "EffectParameter.h"
 
 // Abstract base class for all effects
@@ -6,8 +7,12 @@ class BaseEffect {
 public:
     virtual ~BaseEffect() {}
 
-    // Must implement effect logic
-    virtual void update() = 0;
+    // Must implement effect logic. Called once per scheduled frame with the
+    // time since the previous frame; returns true if it wrote any pixels.
+    // An effect whose output has not moved may return false without writing,
+    // leaving its previous pixels in the back buffer, unless takeDirty() says
+    // they must be drawn again.
+    virtual bool update(uint32_t deltaMs) = 0;
 
     // Must provide the effect's name
     virtual const char* getName() const = 0;
@@ -16,41 +21,84 @@ public:
     virtual int getParameterCount() const = 0;
     virtual EffectParameter* getParameter(int idx) = 0;
 
-    // Convenience: set by name (overload for type)
-    virtual void setParameter(const char* name, float value) {
+    // --- Indexed access (the fast path for live control) ---
+
+    // Returns the index of the parameter with this name, or -1. Compares the
+    // precomputed name hashes and confirms the single match with strcmp.
+    int findParameter(const char* name) {
+        uint32_t hash = paramHash(name);
         for (int i = 0; i < getParameterCount(); ++i) {
             EffectParameter* p = getParameter(i);
-            if (strcmp(p->name, name) == 0 && p->type == ParamType::FLOAT) {
-                p->value.floatValue = value;
-                return;
-            }
+            if (p->nameHash == hash && strcmp(p->name, name) == 0) return i;
         }
+        return -1;
     }
-    virtual void setParameter(const char* name, int value) {
-        for (int i = 0; i < getParameterCount(); ++i) {
-            EffectParameter* p = getParameter(i);
-            if (strcmp(p->name, name) == 0 && p->type == ParamType::INTEGER) {
-                p->value.intValue = value;
-                return;
-            }
+
+    // Writes parameter `idx` from its 32-bit wire form: INTEGER as int32,
+    // FLOAT as IEEE-754 bits, COLOR as 0x00RRGGBB, BOOLEAN as non-zero.
+    // Returns false if there is no such parameter.
+    bool setParameterRaw(int idx, uint32_t raw) {
+        EffectParameter* p = getParameter(idx);
+        if (!p) return false;
+        switch (p->type) {
+        case ParamType::INTEGER: p->value.intValue = (int32_t)raw; break;
+        case ParamType::FLOAT:   memcpy(&p->value.floatValue, &raw, sizeof(float)); break;
+        case ParamType::COLOR:   p->value.colorValue = raw; break;
+        case ParamType::BOOLEAN: p->value.boolValue = raw != 0; break;
         }
+        markDirty();
+        return true;
     }
-    virtual void setParameter(const char* name, bool value) {
-        for (int i = 0; i < getParameterCount(); ++i) {
-            EffectParameter* p = getParameter(i);
-            if (strcmp(p->name, name) == 0 && p->type == ParamType::BOOLEAN) {
-                p->value.boolValue = value;
-                return;
-            }
+
+    // Inverse of setParameterRaw. Returns 0 if there is no such parameter.
+    uint32_t getParameterRaw(int idx) {
+        EffectParameter* p = getParameter(idx);
+        if (!p) return 0;
+        uint32_t raw = 0;
+        switch (p->type) {
+        case ParamType::INTEGER: raw = (uint32_t)p->value.intValue; break;
+        case ParamType::FLOAT:   memcpy(&raw, &p->value.floatValue, sizeof(float)); break;
+        case ParamType::COLOR:   raw = p->value.colorValue; break;
+        case ParamType::BOOLEAN: raw = p->value.boolValue ? 1 : 0; break;
         }
+        return raw;
     }
-    virtual void setParameter(const char* name, uint32_t value) {
-        for (int i = 0; i < getParameterCount(); ++i) {
-            EffectParameter* p = getParameter(i);
-            if (strcmp(p->name, name) == 0 && p->type == ParamType::COLOR) {
-                p->value.colorValue = value;
-                return;
-            }
-        }
+
+    // --- Convenience: set by name (overload for type) ---
+    // Ignored if the name is unknown or the parameter has a different type.
+    void setParameter(const char* name, float value) {
+        if (EffectParameter* p = typedParameter(name, ParamType::FLOAT)) { p->value.floatValue = value; markDirty(); }
+    }
+    void setParameter(const char* name, int value) {
+        if (EffectParameter* p = typedParameter(name, ParamType::INTEGER)) { p->value.intValue = value; markDirty(); }
+    }
+    void setParameter(const char* name, bool value) {
+        if (EffectParameter* p = typedParameter(name, ParamType::BOOLEAN)) { p->value.boolValue = value; markDirty(); }
+    }
+    void setParameter(const char* name, uint32_t value) {
+        if (EffectParameter* p = typedParameter(name, ParamType::COLOR)) { p->value.colorValue = value; markDirty(); }
+    }
+
+    // --- Change tracking ---
+    // Marks the effect's pixels as stale: its parameters were written, or the
+    // segment's range changed or was drawn over. The setters above call it;
+    // anything writing EffectParameter values directly must call it too.
+    void markDirty() { dirty_ = true; }
+
+protected:
+    // Returns and clears the dirty mark. Effects that can skip a frame call it
+    // once per update() and redraw when it is set.
+    bool takeDirty() {
+        bool dirty = dirty_;
+        dirty_ = false;
+        return dirty;
+    }
+
+private:
+    volatile bool dirty_ = true; // Set from core 0, taken on the render core; a new effect draws once
+
+    EffectParameter* typedParameter(const char* name, ParamType type) {
+        EffectParameter* p = getParameter(findParameter(name));
+        return (p && p->type == type) ? p : nullptr;
     }
 };
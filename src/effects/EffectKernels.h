@@ -0,0 +1,172 @@
+/**
+ * @file EffectKernels.h
+ * @brief Per-pixel building blocks shared by the heat-map effects (Fire, Flare, ColoredFire).
+ *
+ * @details Everything here runs once per LED per frame, so it avoids what is
+ * slow on the Cortex-M0+: Arduino random() (a C library call plus a
+ * division), integer division (a library call; the core has no divide
+ * instruction) and floating point (emulated).
+ *
+ * - EffectRandom: a xorshift32 generator kept by each effect instance.
+ * - coolHeat(): the per-LED random cooling, four LEDs per 32-bit operation.
+ *   One random word supplies all four amounts.
+ * - diffuseHeat(): the upward heat drift. The divide by three is a multiply
+ *   and a shift.
+ * - sparkHeat(): occasionally heats one of the lowest LEDs.
+ * - drawHeat(): maps each heat value through a 256-entry GRB palette into
+ *   the back buffer. The classic palette, heatPalette(), is computed at
+ *   compile time; buildHeatPalette() fills one for three colours at run time.
+ *
+ * Heat maps come from Segment::scratch() and so are 4-byte aligned (EffectArena.h).
+ *
+ * @version 1.0
+ * @date 2026-10-14
+ */
+#ifndef EFFECT_KERNELS_H
+#define EFFECT_KERNELS_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "../PixelStrip.h"
+
+/// xorshift32 (Marsaglia). Period 2^32 - 1; the state is never zero.
+class EffectRandom
+{
+public:
+    /// Seeded from random(), so randomSeed() still makes a run repeatable
+    EffectRandom() : state_((uint32_t)random(1, 0x7FFFFFFF)) {}
+
+    uint32_t next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+    /// 0 .. n - 1, from the top 16 bits; a multiply instead of a modulo
+    uint16_t below(uint16_t n) { return (uint16_t)(((next() >> 16) * n) >> 16); }
+
+    /// lo .. hi - 1, like random(lo, hi)
+    uint16_t range(uint16_t lo, uint16_t hi) { return lo + below(hi - lo); }
+
+private:
+    uint32_t state_;
+};
+
+/// One GRB triplet per heat value, ready to copy into the back buffer.
+struct HeatPalette
+{
+    uint8_t grb[256][3];
+};
+
+// Black through red and yellow to white: the FastLED HeatColor ramp.
+// round(t * 191 / 255) in integers; the quotient is never exactly one half.
+constexpr HeatPalette makeHeatPalette()
+{
+    HeatPalette p{};
+    for (int t = 0; t < 256; ++t)
+    {
+        uint8_t t192 = (uint8_t)((t * 382 + 255) / 510);
+        uint8_t ramp = (uint8_t)((t192 & 0x3F) << 2);
+        uint8_t r = t192 > 0x40 ? 255 : ramp;
+        uint8_t g = t192 > 0x80 ? 255 : (t192 > 0x40 ? ramp : 0);
+        uint8_t b = t192 > 0x80 ? ramp : 0;
+        p.grb[t][0] = g;
+        p.grb[t][1] = r;
+        p.grb[t][2] = b;
+    }
+    return p;
+}
+
+inline const HeatPalette &heatPalette()
+{
+    static constexpr HeatPalette palette = makeHeatPalette();
+    return palette;
+}
+
+/// Heat 0-127 blends c1 into c2; 128-255 blends c2 into c3. Colours are 0xRRGGBB.
+inline void buildHeatPalette(HeatPalette &p, uint32_t c1, uint32_t c2, uint32_t c3)
+{
+    for (int h = 0; h < 256; ++h)
+    {
+        uint32_t from = h <= 127 ? c1 : c2;
+        uint32_t to = h <= 127 ? c2 : c3;
+        int t = h <= 127 ? h * 2 : (h - 128) * 2;
+        uint8_t rgb[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            int a = (from >> (16 - 8 * c)) & 0xFF;
+            int b = (to >> (16 - 8 * c)) & 0xFF;
+            rgb[c] = (uint8_t)(a + (b - a) * t / 255);
+        }
+        PixelStrip::storeGrb(p.grb[h], rgb[0], rgb[1], rgb[2]);
+    }
+}
+
+/// Lowers every heat value by a random 0..maxCool, stopping at 0.
+inline void coolHeat(uint8_t *heat, size_t count, uint8_t maxCool, EffectRandom &rng)
+{
+    const uint32_t H = 0x80808080u;
+    const uint32_t scale = (uint32_t)maxCool + 1; // Byte b becomes b * scale / 256
+    uint8_t *words = (uint8_t *)__builtin_assume_aligned(heat, 4);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t r = rng.next();
+        // Four amounts in 0..maxCool: even and odd bytes scaled in 16-bit lanes
+        r = ((((r & 0x00FF00FFu) * scale) >> 8) & 0x00FF00FFu) | ((((r >> 8) & 0x00FF00FFu) * scale) & 0xFF00FF00u);
+
+        uint32_t h;
+        memcpy(&h, words + i, 4);
+        // Bytewise h - r without carries between bytes, then each byte that
+        // borrowed is cleared
+        uint32_t d = ((h | H) - (r & ~H)) ^ ((h ^ ~r) & H);
+        uint32_t borrow = ((~h & r) | (~(h ^ r) & d)) & H;
+        d &= ~((borrow >> 7) * 0xFFu);
+        memcpy(words + i, &d, 4);
+    }
+    for (; i < count; ++i)
+    {
+        uint8_t amount = rng.below(scale);
+        heat[i] = heat[i] > amount ? heat[i] - amount : 0;
+    }
+}
+
+/// Each LED takes a third of the one below it and two thirds of the one two below.
+inline void diffuseHeat(uint8_t *heat, size_t count)
+{
+    if (count < 3)
+        return;
+    uint32_t below1 = heat[count - 2];
+    for (size_t k = count - 1; k >= 2; --k)
+    {
+        uint32_t below2 = heat[k - 2];
+        heat[k] = (uint8_t)(((below1 + 2 * below2) * 683) >> 11); // x / 3, exact for x <= 765
+        below1 = below2;
+    }
+}
+
+/// With probability chance / 255, raises one of the lowest seven LEDs by 160-254.
+inline void sparkHeat(uint8_t *heat, size_t count, uint8_t chance, EffectRandom &rng)
+{
+    if (count == 0 || rng.below(255) >= chance)
+        return;
+    uint16_t idx = rng.below(count < 7 ? count : 7);
+    uint16_t v = heat[idx] + rng.range(160, 255);
+    heat[idx] = v > 255 ? 255 : v;
+}
+
+/// Writes `count` LEDs of GRB bytes at `px`, one palette entry per heat value.
+inline void drawHeat(uint8_t *px, const uint8_t *heat, size_t count, const HeatPalette &palette)
+{
+    for (size_t i = 0; i < count; ++i, px += 3)
+    {
+        const uint8_t *c = palette.grb[heat[i]];
+        px[0] = c[0];
+        px[1] = c[1];
+        px[2] = c[2];
+    }
+}
+
+#endif // EFFECT_KERNELS_H
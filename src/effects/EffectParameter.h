@@ -26,17 +26,73 @@ struct EffectParameter
     ParamType type;
 
     // A union to hold the actual value.
-    union
+    union ParamValue
     {
         int intValue;
         float floatValue;
         uint32_t colorValue; // e.g., 0xFF00FF
         bool boolValue;
+
+        // constexpr constructors so parameter tables can live in flash
+        constexpr ParamValue() : intValue(0) {}
+        constexpr ParamValue(int v) : intValue(v) {}
+        constexpr ParamValue(float v) : floatValue(v) {}
+        constexpr ParamValue(uint32_t v) : colorValue(v) {}
+        constexpr ParamValue(bool v) : boolValue(v) {}
     } value;
 
     // Optional: Min/max values to give the app hints for sliders.
     float min_val;
     float max_val;
+
+    // FNV-1a hash of `name` (see paramHash), filled in at compile time by the
+    // helpers below so lookups by name compare integers, not strings.
+    uint32_t nameHash;
+};
+
+// 32-bit FNV-1a; constexpr so parameter names can be hashed at compile time.
+constexpr uint32_t paramHash(const char *s, uint32_t h = 2166136261u)
+{
+    return *s ? paramHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+// Helpers for building constexpr parameter tables. Each one picks the union
+// member explicitly, so a colour literal never lands in intValue by accident.
+constexpr EffectParameter intParam(const char *name, int def, int minVal, int maxVal)
+{
+    return EffectParameter{name, ParamType::INTEGER, EffectParameter::ParamValue(def), (float)minVal, (float)maxVal, paramHash(name)};
+}
+constexpr EffectParameter floatParam(const char *name, float def, float minVal, float maxVal)
+{
+    return EffectParameter{name, ParamType::FLOAT, EffectParameter::ParamValue(def), minVal, maxVal, paramHash(name)};
+}
+constexpr EffectParameter colorParam(const char *name, uint32_t def)
+{
+    return EffectParameter{name, ParamType::COLOR, EffectParameter::ParamValue(def), 0.0f, 0.0f, paramHash(name)};
+}
+constexpr EffectParameter boolParam(const char *name, bool def)
+{
+    return EffectParameter{name, ParamType::BOOLEAN, EffectParameter::ParamValue(def), 0.0f, 0.0f, paramHash(name)};
+}
+
+// Static metadata for one effect: its name and its parameters with their
+// defaults and ranges. Every effect class exposes one through a static
+// descriptor() function, so the catalog can be served without constructing
+// anything.
+struct EffectDescriptor
+{
+    const char *name;
+    const EffectParameter *params;
+    uint8_t paramCount;
 };
 
+// Copies an effect's default parameter values into its runtime array.
+inline void loadParameterDefaults(EffectParameter *dst, const EffectDescriptor &desc)
+{
+    for (uint8_t i = 0; i < desc.paramCount; ++i)
+    {
+        dst[i] = desc.params[i];
+    }
+}
+
 #endif // EFFECT_PARAMETER_H
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "ColoredFire.h"
 #include "AccelMeter.h"
 #include "KineticRipple.h"
+#include "AudioRainbow.h"
 
 // List of effects that DO NOT require an external memory buffer.
 // Format: X(EnumName, ClassName)
@@ -23,17 +24,25 @@
     X(AccelMeter,     AccelMeter)     \
     X(KineticRipple,  KineticRipple)
 
-// List of effects that DO require the shared "scratchpad" memory buffer.
+// List of effects that DO require a scratch buffer (taken per segment from the strip's EffectArena).
 // Format: X(EnumName, ClassName)
 #define BUFFERED_EFFECT_LIST(X) \
     X(Fire,        Fire)        \
     X(Flare,       Flare)       \
     X(ColoredFire, ColoredFire)
 
+// Effects added since. An effect's position in EFFECT_LIST is its id on the
+// wire (CMD_SET_EFFECT, segment records, numeric "effect" in JSON configs),
+// so new effects go at the end of this list and never in front of others.
+// Format: X(EnumName, ClassName)
+#define ADDED_EFFECT_LIST(X) \
+    X(AudioRainbow, AudioRainbow)
+
 // The EFFECT_LIST macro now combines both lists automatically.
 // This is used to generate the list of names for the app.
 #define EFFECT_LIST(X)          \
     STANDARD_EFFECT_LIST(X)     \
-    BUFFERED_EFFECT_LIST(X)
+    BUFFERED_EFFECT_LIST(X)     \
+    ADDED_EFFECT_LIST(X)
 
 #endif // EFFECTS_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../PixelStrip.h"
 #include "EffectParameter.h"
 #include "BaseEffect.h"
+#include "EffectKernels.h"
 #include <Arduino.h>
 
 class Fire : public BaseEffect {
@@ -12,91 +13,55 @@ private:
     EffectParameter params[2];
     byte* heat       = nullptr;
     int   heatSize   = 0;
+    EffectRandom rng;
 
-    byte qadd8(byte a, byte b) { unsigned int s = a + b; return s > 255 ? 255 : byte(s); }
-    byte qsub8(byte a, byte b) { return b > a ? 0 : a - b; }
-
-    RgbColor HeatColor(byte temperature) {
-        byte t192 = round((temperature / 255.0) * 191);
-        byte heatramp = t192 & 0x3F;
-        heatramp <<= 2;
-        if (t192 > 0x80) return RgbColor(255, 255, heatramp);
-        else if (t192 > 0x40) return RgbColor(255, heatramp, 0);
-        else return RgbColor(heatramp, 0, 0);
+public:
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            intParam("sparking", 120, 20, 200),
+            intParam("cooling", 55, 20, 85),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"Fire", kParams, 2};
+        return kDescriptor;
     }
 
-public:
-    // MODIFIED CONSTRUCTOR: Accepts an external buffer
-    Fire(PixelStrip::Segment* seg, uint8_t* externalBuffer, int bufferSize)
+    // The heat map lives in this segment's region of the strip's EffectArena
+    Fire(PixelStrip::Segment* seg)
       : segment(seg)
     {
-        params[0].name = "sparking";
-        params[0].type = ParamType::INTEGER;
-        params[0].value.intValue = 120;
-        params[0].min_val = 20;
-        params[0].max_val = 200;
-
-        params[1].name = "cooling";
-        params[1].type = ParamType::INTEGER;
-        params[1].value.intValue = 55;
-        params[1].min_val = 20;
-        params[1].max_val = 85;
+        loadParameterDefaults(params, descriptor());
 
         if (segment) {
             heatSize = segment->endIndex() - segment->startIndex() + 1;
-            // Use the provided buffer if it's large enough
-            if (heatSize <= bufferSize) {
-                heat = externalBuffer; // Point to the global buffer
-                memset(heat, 0, heatSize);
-            }
-            // NO 'new byte[]' HERE
+            heat = segment->scratch(heatSize);
+            if (heat) memset(heat, 0, heatSize); // The region may be reused from the previous effect
         }
     }
 
-    // MODIFIED DESTRUCTOR: No longer deletes the buffer
-    ~Fire() override {
-        // NO 'delete[] heat' HERE
-    }
-
-    void update() override {
-        if (!heat) return; // Important safety check
+    bool update(uint32_t deltaMs) override {
+        // Re-fetched every frame so a range change or an arena reset is picked up
+        heatSize = segment->endIndex() - segment->startIndex() + 1;
+        heat = segment->scratch(heatSize);
+        if (!heat) return false;
 
         int sparking = params[0].value.intValue;
         int cooling  = params[1].value.intValue;
-        int startPix = segment->startIndex();
 
-        for (int i = 0; i < heatSize; ++i) {
-            heat[i] = qsub8(heat[i], random(0, ((cooling * 10) / heatSize) + 2));
-        }
-        for (int k = heatSize - 1; k >= 2; --k) {
-            heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
-        }
-        if (random(255) < sparking) {
-            int idx = random(min(7, heatSize));
-            heat[idx] = qadd8(heat[idx], random(160, 255));
-        }
-        for (int i = 0; i < heatSize; ++i) {
-            RgbColor c = HeatColor(heat[i]);
-            uint32_t rawColor = segment->getParent().Color(c.R, c.G, c.B);
-            uint32_t scaledColor = PixelStrip::scaleColor(rawColor, segment->getBrightness());
-            segment->getParent().setPixel(startPix + i, scaledColor);
-        }
+        coolHeat(heat, heatSize, min((cooling * 10) / heatSize + 1, 255), rng);
+        diffuseHeat(heat, heatSize);
+        sparkHeat(heat, heatSize, sparking, rng);
+        // Straight into the back buffer; the heat map may run past the strip's end
+        drawHeat(segment->pixelBytes(), heat, min((int)segment->length(), heatSize), heatPalette());
+        return true;
     }
 
-    const char* getName() const override { return "Fire"; }
-    int getParameterCount() const override { return 2; }
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter* getParameter(int index) override {
         if (index >= 0 && index < 2) return &params[index];
         return nullptr;
     }
-    void setParameter(const char* name, int value) override {
-        for (int i = 0; i < 2; ++i) {
-            if (strcmp(params[i].name, name) == 0 && params[i].type == ParamType::INTEGER) {
-                params[i].value.intValue = value;
-                return;
-            }
-        }
-    }
 };
 
 #endif // FIRE_H
\ No newline at end of file
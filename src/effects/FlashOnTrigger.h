@@ -9,19 +9,44 @@
 class FlashOnTrigger : public BaseEffect {
 private:
     PixelStrip::Segment* segment;
-    EffectParameter params[1];
+    EffectParameter params[2];
+    uint8_t shownLevel = 0; // Level of the pixels drawn last; 0 when dark
 
 public:
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            colorParam("flash_color", 0xFFFFFF),
+            // -1: the bass trigger threshold; 0-3: follow that AudioBand's level
+            intParam("band", -1, -1, AUDIO_BAND_COUNT - 1),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"FlashOnTrigger", kParams, 2};
+        return kDescriptor;
+    }
+
     FlashOnTrigger(PixelStrip::Segment* seg) : segment(seg) {
-        params[0].name = "flash_color";
-        params[0].type = ParamType::COLOR;
-        params[0].value.colorValue = 0xFFFFFF; // Default: white
-        params[0].min_val = 0.0; // Initialize
-        params[0].max_val = 0.0; // Initialize
+        loadParameterDefaults(params, descriptor());
     }
 
-    void update() override {
-        if (segment->triggerIsActive) {
+    bool update(uint32_t deltaMs) override {
+        const AudioFeatures& audio = segment->getParent().getAudio();
+        int band = params[1].value.intValue;
+        bool active;
+        uint8_t level;
+        if (band >= 0 && band < AUDIO_BAND_COUNT) {
+            level = audio.bandLevel[band];
+            active = level > 0;
+        } else {
+            level = audio.triggerBrightness;
+            active = audio.triggerActive;
+        }
+
+        uint8_t newLevel = active ? level : 0;
+        bool dirty = takeDirty();
+        if (newLevel == shownLevel && !dirty) return false;
+        shownLevel = newLevel;
+
+        if (active) {
             uint32_t flashColorValue = params[0].value.colorValue;
 
             RgbColor finalColor(
@@ -29,8 +54,7 @@ public:
                 (flashColorValue >> 8)  & 0xFF,
                 flashColorValue         & 0xFF
             );
-            finalColor.Dim(segment->triggerBrightness);
-            finalColor.Dim(segment->getBrightness());
+            finalColor.Dim(level);
 
             uint32_t rawColor = segment->getParent().Color(finalColor.R, finalColor.G, finalColor.B);
             for (uint16_t i = segment->startIndex(); i <= segment->endIndex(); ++i) {
@@ -39,20 +63,15 @@ public:
         } else {
             segment->allOff();
         }
+        return true;
     }
 
-    const char* getName() const override { return "FlashOnTrigger"; }
-    int getParameterCount() const override { return 1; }
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter* getParameter(int index) override {
-        if (index == 0) return &params[0];
+        if (index >= 0 && index < 2) return &params[index];
         return nullptr;
     }
-
-    void setParameter(const char* name, uint32_t value) override {
-        if (strcmp(params[0].name, name) == 0 && params[0].type == ParamType::COLOR) {
-            params[0].value.colorValue = value;
-        }
-    }
 };
 
 #endif // FLASHONTRIGGER_H
\ No newline at end of file
@@ -5,10 +5,6 @@
 #include "EffectParameter.h"
 #include "BaseEffect.h"
 #include <Arduino.h>
-#include "../globals.h" // <-- ADD THIS LINE
-
-// This global variable signals when a step/movement has been detected.
-extern volatile bool triggerRipple;
 
 class KineticRipple : public BaseEffect {
 private:
@@ -16,46 +12,52 @@ private:
     EffectParameter params[3];
 
     bool rippleActive = false;
-    unsigned long rippleStartTime = 0;
+    uint32_t lastEventCount = 0;
+    uint32_t rippleElapsedMs = 0;
     RgbColor rippleColor;
 
 public:
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            colorParam("color", 0x8A2BE2),
+            floatParam("speed", 0.2f, 0.05f, 1.0f),
+            intParam("width", 3, 1, 11),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"KineticRipple", kParams, 3};
+        return kDescriptor;
+    }
+
     KineticRipple(PixelStrip::Segment* seg) : segment(seg) {
-        params[0].name = "color";
-        params[0].type = ParamType::COLOR;
-        params[0].value.colorValue = 0x8A2BE2; // BlueViolet
-        params[0].min_val = 0.0; // Initialize for COLOR type
-        params[0].max_val = 0.0; // Initialize for COLOR type
-
-        params[1].name = "speed";
-        params[1].type = ParamType::FLOAT;
-        params[1].value.floatValue = 0.2f;
-        params[1].min_val = 0.05f;
-        params[1].max_val = 1.0f;
-
-        params[2].name = "width";
-        params[2].type = ParamType::INTEGER;
-        params[2].value.intValue = 3;
-        params[2].min_val = 1;
-        params[2].max_val = 11;
+        loadParameterDefaults(params, descriptor());
+        // Only react to motion that happens after the effect starts
+        lastEventCount = seg->getParent().getMotion().eventCount;
     }
 
-    void update() override {
-        if (triggerRipple && !rippleActive) {
+    bool update(uint32_t deltaMs) override {
+        // Each segment keeps its own count, so every ripple segment fires on every step
+        const MotionState& motion = segment->getParent().getMotion();
+        bool stepped = motion.eventCount != lastEventCount;
+        lastEventCount = motion.eventCount;
+        if (stepped && !rippleActive) {
             rippleActive = true;
-            rippleStartTime = millis();
+            rippleElapsedMs = 0;
             uint32_t rippleColorValue = params[0].value.colorValue;
             rippleColor = RgbColor((rippleColorValue >> 16) & 0xFF, (rippleColorValue >> 8) & 0xFF, rippleColorValue & 0xFF);
-            triggerRipple = false; // Consume the trigger
         }
 
+        // Between ripples the segment stays dark; there is nothing new to draw
+        bool dirty = takeDirty();
+        if (!rippleActive && !dirty) return false;
+
         segment->allOff();
 
         if (rippleActive) {
             float speed = params[1].value.floatValue;
             int width   = params[2].value.intValue;
 
-            float elapsed = millis() - rippleStartTime;
+            rippleElapsedMs += deltaMs;
+            float elapsed = rippleElapsedMs;
             int radius = int(elapsed * speed);
             int s = segment->startIndex();
             int e = segment->endIndex();
@@ -68,7 +70,6 @@ public:
 
             RgbColor finalColor = rippleColor;
             finalColor.Dim(brightness_fade);
-            finalColor.Dim(segment->getBrightness());
 
             int halfWidth = width / 2;
             bool pixelsDrawn = false;
@@ -76,13 +77,13 @@ public:
             for (int i = 0; i < width; ++i) {
                 int p1 = center - radius - halfWidth + i;
                 if (p1 >= s && p1 <= e) {
-                    segment->getParent().getStrip().SetPixelColor(p1, finalColor);
+                    segment->getParent().setPixel(p1, finalColor);
                     pixelsDrawn = true;
                 }
 
                 int p2 = center + radius - halfWidth + i;
                 if (p2 != p1 && p2 >= s && p2 <= e) {
-                    segment->getParent().getStrip().SetPixelColor(p2, finalColor);
+                    segment->getParent().setPixel(p2, finalColor);
                     pixelsDrawn = true;
                 }
             }
@@ -91,30 +92,15 @@ public:
                 rippleActive = false;
             }
         }
+        return true;
     }
 
-    const char* getName() const override { return "KineticRipple"; }
-    int getParameterCount() const override { return 3; }
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter* getParameter(int index) override {
         if (index >= 0 && index < 3) return &params[index];
         return nullptr;
     }
-
-    void setParameter(const char* name, uint32_t value) override {
-        if (strcmp(params[0].name, name) == 0 && params[0].type == ParamType::COLOR) {
-            params[0].value.colorValue = value;
-        }
-    }
-    void setParameter(const char* name, float value) override {
-        if (strcmp(params[1].name, name) == 0 && params[1].type == ParamType::FLOAT) {
-            params[1].value.floatValue = value;
-        }
-    }
-    void setParameter(const char* name, int value) override {
-        if (strcmp(params[2].name, name) == 0 && params[2].type == ParamType::INTEGER) {
-            params[2].value.intValue = value;
-        }
-    }
 };
 
 #endif // KINETICRIPPLE_H
\ No newline at end of file
@@ -11,47 +11,48 @@ private:
     PixelStrip::Segment* segment;
     EffectParameter params[1];
 
-    unsigned long rainbowFirstPixelHue;
-    unsigned long lastUpdate;
+    uint32_t lastStep;
 
 public:
-    RainbowChase(PixelStrip::Segment* seg) : segment(seg) {
-        params[0].name = "speed";
-        params[0].type = ParamType::INTEGER;
-        params[0].value.intValue = 30;   // 30ms interval
-        params[0].min_val = 5;
-        params[0].max_val = 100;
-        // No COLOR or BOOLEAN params, so no min_val/max_val initialization needed here.
-        rainbowFirstPixelHue = 0;
-        lastUpdate = millis();
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            intParam("speed", 30, 5, 100),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"RainbowChase", kParams, 1};
+        return kDescriptor;
     }
 
-    void update() override {
-        int interval = params[0].value.intValue;
-        if (millis() - lastUpdate < interval) return;
-        lastUpdate = millis();
+    RainbowChase(PixelStrip::Segment* seg) : segment(seg) {
+        loadParameterDefaults(params, descriptor());
+        lastStep = 0;
+    }
 
-        for (int i = segment->startIndex(); i <= segment->endIndex(); ++i) {
-            int hue = rainbowFirstPixelHue + ((i - segment->startIndex()) * 65536L / (segment->endIndex() - segment->startIndex() + 1));
-            uint32_t rawColor = segment->getParent().ColorHSV(hue);
-            uint32_t scaledColor = PixelStrip::scaleColor(rawColor, segment->getBrightness());
-            segment->getParent().setPixel(i, scaledColor);
+    bool update(uint32_t deltaMs) override {
+        // Positioned by show time, like RainbowCycle
+        uint32_t interval = max(params[0].value.intValue, 1);
+        uint32_t step = segment->getParent().getShowTimeMs() / interval;
+        bool dirty = takeDirty();
+        if (step == lastStep && !dirty) return false;
+        lastStep = step;
+
+        // One full wheel across the segment; the hue step is 16.16 fixed point
+        uint16_t length = segment->endIndex() - segment->startIndex() + 1;
+        uint32_t hueStep = (uint32_t)(0x100000000ULL / length);
+        uint32_t hueAcc = (uint32_t)(step * 256) << 16;
+        uint8_t* px = segment->pixelBytes();
+        for (uint16_t i = segment->length(); i > 0; --i, px += 3, hueAcc += hueStep) {
+            PixelStrip::storeGrb(px, PixelStrip::hueWheel(hueAcc >> 16));
         }
-        rainbowFirstPixelHue += 256;
+        return true;
     }
 
-    const char* getName() const override { return "RainbowChase"; }
-    int getParameterCount() const override { return 1; }
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter* getParameter(int index) override {
         if (index == 0) return &params[0];
         return nullptr;
     }
-
-    void setParameter(const char* name, int value) override {
-        if (strcmp(params[0].name, name) == 0 && params[0].type == ParamType::INTEGER) {
-            params[0].value.intValue = value;
-        }
-    }
 };
 
 #endif // RAINBOWCHASE_H
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef SOLIDCOLOR_H
+#define SOLIDCOLOR_H
+
+#include "../PixelStrip.h"
+#include "EffectParameter.h"
+#include "BaseEffect.h"
+#include <Arduino.h>
+
+class SolidColor : public BaseEffect {
+private:
+    PixelStrip::Segment* segment;
+    EffectParameter params[1];
+
+public:
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor& descriptor() {
+        static constexpr EffectParameter kParams[] = {
+            colorParam("color", 0x800080),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"SolidColor", kParams, 1};
+        return kDescriptor;
+    }
+
+    SolidColor(PixelStrip::Segment* seg) : segment(seg) {
+        loadParameterDefaults(params, descriptor());
+    }
+
+    bool update(uint32_t deltaMs) override {
+        // Static: drawn once, then again only when the colour or range changes
+        if (!takeDirty()) return false;
+        segment->fill(params[0].value.colorValue);
+        return true;
+    }
+
+    const char* getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
+    EffectParameter* getParameter(int index) override {
+        if (index == 0) return &params[0];
+        return nullptr;
+    }
+};
+
+#endif // SOLIDCOLOR_H
\ No newline at end of file
@@ -12,39 +12,41 @@ private:
     PixelStrip::Segment *segment;
     EffectParameter params[2]; // Now has 2 parameters: speed and color
 
-    unsigned long lastUpdate;
-    uint8_t chaseOffset;
+    uint32_t lastStep;
 
 public:
-    TheaterChase(PixelStrip::Segment *seg) : segment(seg)
+    // Name, parameters, defaults and ranges; served to the app without constructing the effect
+    static const EffectDescriptor &descriptor()
     {
-        params[0].name = "speed";
-        params[0].type = ParamType::INTEGER;
-        params[0].value.intValue = 50; // Default to a 50ms interval
-        params[0].min_val = 10;
-        params[0].max_val = 150;
+        static constexpr EffectParameter kParams[] = {
+            intParam("speed", 50, 10, 150),
+            colorParam("color", 0xFF0000),
+        };
+        static constexpr EffectDescriptor kDescriptor = {"TheaterChase", kParams, 2};
+        return kDescriptor;
+    }
 
-        params[1].name = "color";
-        params[1].type = ParamType::COLOR;
-        params[1].value.colorValue = 0xFF0000; // Default to Red
-        params[1].min_val = 0.0;
-        params[1].max_val = 0.0;
+    TheaterChase(PixelStrip::Segment *seg) : segment(seg)
+    {
+        loadParameterDefaults(params, descriptor());
 
-        lastUpdate = millis();
-        chaseOffset = 0;
+        lastStep = 0;
     }
 
-    void update() override
+    bool update(uint32_t deltaMs) override
     {
-        int interval = params[0].value.intValue;
-        if (millis() - lastUpdate < interval)
-            return;
-        lastUpdate = millis();
+        // Positioned by show time, like RainbowCycle
+        uint32_t interval = max(params[0].value.intValue, 1);
+        uint32_t step = segment->getParent().getShowTimeMs() / interval;
+        bool dirty = takeDirty();
+        if (step == lastStep && !dirty)
+            return false;
+        lastStep = step;
+        uint8_t chaseOffset = step % 3;
 
         segment->allOff();
 
         uint32_t colorValue = params[1].value.colorValue;
-        uint32_t scaledColor = PixelStrip::scaleColor(colorValue, segment->getBrightness());
 
         uint16_t start = segment->startIndex();
         uint16_t end = segment->endIndex();
@@ -53,38 +55,20 @@ public:
         {
             if (((i - start) % 3) == chaseOffset)
             {
-                segment->getParent().setPixel(i, scaledColor);
+                segment->getParent().setPixel(i, colorValue);
             }
         }
-
-        chaseOffset = (chaseOffset + 1) % 3;
+        return true;
     }
 
-    const char *getName() const override { return "TheaterChase"; }
-    int getParameterCount() const override { return 2; }
+    const char *getName() const override { return descriptor().name; }
+    int getParameterCount() const override { return descriptor().paramCount; }
     EffectParameter *getParameter(int index) override
     {
         if (index >= 0 && index < 2)
             return &params[index];
         return nullptr;
     }
-
-    void setParameter(const char *name, int value) override
-    {
-        if (strcmp(params[0].name, name) == 0 && params[0].type == ParamType::INTEGER)
-        {
-            params[0].value.intValue = value;
-        }
-    }
-
-    void setParameter(const char *name, uint32_t value) override
-    {
-        // Add this override to handle the new color parameter
-        if (strcmp(params[1].name, name) == 0 && params[1].type == ParamType::COLOR)
-        {
-            params[1].value.colorValue = value;
-        }
-    }
 };
 
 #endif // THEATERCHASE_H
\ No newline at end of file
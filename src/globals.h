@@ -2,33 +2,31 @@
 #define GLOBALS_H
 
 #include <Arduino.h>
-#include "config.h"
+#include "Config.h"
 #include "Triggers.h"
+#include "AudioRing.h"
 #include "PixelStrip.h"
 #include <LittleFS_Mbed_RP2040.h>
 
 // Forward declarations for our main manager classes
 class BLEManager;
-class CommandHandler;
 
 // --- Global Object Instances ---
 extern BLEManager& bleManager;
-extern CommandHandler commandHandler;
 
 // --- LED Strip & Segments ---
 extern PixelStrip* strip;
 extern PixelStrip::Segment* seg;
 extern uint16_t LED_COUNT;
-extern const char* STATE_FILE;
+extern const char* STATE_FILE;     // Legacy JSON state, read when there is no binary state
+extern const char* STATE_BIN_FILE; // Binary state (StateFile.h)
+extern const char* STATE_TMP_FILE; // Written in full, then renamed over STATE_BIN_FILE
+extern const char* PRESET_FILE_FORMAT; // printf pattern taking the preset slot (PresetBank.h)
+extern const char* PRESET_TMP_FILE;
 
 // --- Audio Processing ---
 extern AudioTrigger<SAMPLES> audioTrigger;
-extern volatile int16_t sampleBuffer[SAMPLES];
-extern volatile int samplesRead;
-
-// --- Accelerometer & Motion ---
-extern float accelX, accelY, accelZ;
-extern volatile bool triggerRipple;
+extern AudioSampleRing<AUDIO_RING_SAMPLES> audioRing;
 
 // --- New global flag for serial output management ---
 extern bool reAdvertisingMessagePrinted; //
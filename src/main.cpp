@@ -3,8 +3,8 @@
  * @file main.cpp
  * @brief Main application logic for the Rave Controller.
  *
- * @version 2.7 (Timeout Integration)
- * @date 2025-07-18
+ * @version 2.8 (Second-Core Rendering)
+ * @date 2026-10-14
  */
 #include <Arduino.h>
 #include <ArduinoJson.h>
@@ -15,30 +15,37 @@
 #include "BinaryCommandHandler.h"
 #include "SerialCommandHandler.h"
 #include "ConfigManager.h"
-#include "EffectLookup.h" // Needed for createEffectByName
+#include "EffectLookup.h" // Needed for setEffectByName
+#include "RenderEngine.h"
+#include "MotionSensor.h"
+#include "StateFile.h"
+#include "PresetBank.h"
+#include "EffectCatalog.h"
+#include "Telemetry.h"
+#include "ShowClock.h"
+#include "Log.h"
 
 // --- Global Object Instances ---
 BLEManager &bleManager = BLEManager::getInstance();
+RenderEngine &renderEngine = RenderEngine::getInstance();
 BinaryCommandHandler binaryCommandHandler;
 SerialCommandHandler serialCommandHandler;
 
 // --- Global Variable Definitions ---
 PixelStrip *strip = nullptr;
 PixelStrip::Segment *seg = nullptr;
-uint16_t LED_COUNT = 585; // Default value
+uint16_t LED_COUNT = LED_COUNT_DEFAULT; // The sum of LEDS_PER_OUTPUT (Config.h)
 const char *STATE_FILE = "/littlefs/state.json";
+const char *STATE_BIN_FILE = "/littlefs/state.bin";
+const char *STATE_TMP_FILE = "/littlefs/state.tmp";
+const char *PRESET_FILE_FORMAT = "/littlefs/preset%u.bin";
+const char *PRESET_TMP_FILE = "/littlefs/preset.tmp";
 LittleFS_MBED myFS;
 
 unsigned long lastHeartbeatReceived = 0;
 
-// MODIFIED: Use the new constant from Config.h to define the array
-uint8_t effectScratchpad[EFFECT_SCRATCHPAD_SIZE];
-
 AudioTrigger<SAMPLES> audioTrigger;
-volatile int16_t sampleBuffer[SAMPLES];
-volatile int samplesRead = 0;
-float accelX, accelY, accelZ;
-volatile bool triggerRipple = false;
+AudioSampleRing<AUDIO_RING_SAMPLES> audioRing;
 
 
 bool reAdvertisingMessagePrinted = false;
@@ -47,10 +54,13 @@ bool reAdvertisingMessagePrinted = false;
 void processAudio();
 void processAccel();
 void processSerial();
+void reportArenaFailures();
+void setupFromLegacyConfig();
 
+// Runs inside BLE.poll(): only queue the packet; loop() applies it
 void onBleCommandReceived(const uint8_t *data, size_t len)
 {
-    binaryCommandHandler.handleCommand(data, len);
+    binaryCommandHandler.queueCommand(data, len);
 }
 
 void setup()
@@ -58,8 +68,43 @@ void setup()
     initSerial();
     initFS();
 
+    // --- Fast path: binary state, read straight into the segments ---
+    uint16_t savedLedCount;
+    if (readSavedLedCount(savedLedCount))
+    {
+        LED_COUNT = savedLedCount;
+        initIMU();
+        initAudio();
+        initLEDs();
+        strip->clearUserSegments();
+        int restored = restoreSavedSegments(*strip);
+        strip->show();
+        Serial.print("OK: Restored ");
+        Serial.print(restored);
+        Serial.println(" segment(s) from binary state.");
+    }
+    else
+    {
+        setupFromLegacyConfig();
+    }
+
+    PresetBank::getInstance().begin();
+    EffectCatalog::getInstance().begin(); // Ready before the app can ask for it
+    bleManager.begin("RaveCape-V1", onBleCommandReceived);
+
+    // From here on segments are rendered by the engine; command handlers
+    // take a FrameLock before touching them.
+    renderEngine.begin(strip);
+
+    Serial.println("Setup complete. Entering main loop...");
+}
+
+// Boot path for devices that only have the JSON state file; the next save
+// writes the binary state and later boots take the fast path.
+void setupFromLegacyConfig()
+{
     static char configBuffer[2048];
-    size_t configSize = loadConfig(configBuffer, sizeof(configBuffer));
+    size_t configSize = loadLegacyConfig(configBuffer, sizeof(configBuffer));
 
     // --- Robust Configuration Loading ---
     if (configSize > 0)
@@ -71,7 +116,7 @@ void setup()
         if (error == DeserializationError::Ok)
         {
             // 2. Extract LED_COUNT from the parsed document.
-            LED_COUNT = doc["led_count"] | 585;
+            LED_COUNT = doc["led_count"] | LED_COUNT_DEFAULT;
 
             // 3. Initialize hardware that depends on config values.
             initIMU();
@@ -90,7 +135,7 @@ void setup()
                     uint16_t start = segData["startLed"];
                     uint16_t end = segData["endLed"];
                     uint8_t brightness = segData["brightness"] | 255;
-                    const char* effectNameStr = segData["effect"] | "SolidColor";
+                    uint8_t effectId = effectIdFromJson(segData["effect"]);
                     uint8_t segmentId = segData["id"] | 0; // Get ID from JSON
 
                     PixelStrip::Segment *targetSeg = nullptr;
@@ -113,45 +158,18 @@ void setup()
                         targetSeg->setRange(start, end);
                         targetSeg->setBrightness(brightness);
 
-                        if (targetSeg->activeEffect) {
-                            if (strcmp(targetSeg->activeEffect->getName(), effectNameStr) != 0) {
-                                delete targetSeg->activeEffect;
-                                targetSeg->activeEffect = createEffectByName(effectNameStr, targetSeg);
-                            }
-                        } else {
-                            targetSeg->activeEffect = createEffectByName(effectNameStr, targetSeg);
+                        // Keep the running effect (and its state) if it is unchanged
+                        if (targetSeg->getEffectId() != effectId) {
+                            if (!targetSeg->setEffect(effectId))
+                                targetSeg->clearEffect();
                         }
 
-                        if (targetSeg->activeEffect)
-                        {
-                            // FIX: Removed the redundant .as<JsonObject>() cast on segData
-                            // segData is already a JsonObject in this loop context.
-                            for (int i = 0; i < targetSeg->activeEffect->getParameterCount(); ++i)
-                            {
-                                EffectParameter *p = targetSeg->activeEffect->getParameter(i);
-                                if (segData.containsKey(p->name))
-                                {
-                                    switch (p->type)
-                                    {
-                                    case ParamType::INTEGER:
-                                        targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<int>());
-                                        break;
-                                    case ParamType::FLOAT:
-                                        targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<float>());
-                                        break;
-                                    case ParamType::COLOR:
-                                        targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<uint32_t>());
-                                        break;
-                                    case ParamType::BOOLEAN:
-                                        targetSeg->activeEffect->setParameter(p->name, segData[p->name].as<bool>());
-                                        break;
-                                    }
-                                }
-                            }
-                        }
+                        applySegmentBlend(targetSeg, segData);
+                        applyEffectParameters(targetSeg->activeEffect, segData);
                     }
                 }
                 strip->show();
+                markConfigDirty(); // The first autosave migrates it to the binary state file
                 Serial.println("OK: Startup configuration restored.");
             }
         }
@@ -172,18 +190,16 @@ void setup()
         initAudio();
         initLEDs();
     }
-
-    bleManager.begin("RaveCape-V1", onBleCommandReceived);
-
-    Serial.println("Setup complete. Entering main loop...");
 }
 
 void loop()
 {
     static unsigned long lastBleCheck = 0;
     unsigned long currentMillis = millis();
+    Telemetry::getInstance().loopTick(micros());
 
     bleManager.update();
+    binaryCommandHandler.dispatchQueued(); // Everything received during the poll, coalesced
     binaryCommandHandler.update(); // Added: Call the update method for timeout checks
 
     // if (currentMillis - lastBleCheck > 500)
@@ -209,17 +225,40 @@ void loop()
     processSerial();
     processAudio();
     processAccel();
-
+    serviceConfigAutosave(); // At most one save step per pass
+    ShowClock::getInstance().service(micros());
     if (strip)
+        PresetBank::getInstance().service(*strip); // Preset switches scheduled on the show clock
+    reportArenaFailures();
+    logPoll(); // Drains the ring log sink, if enabled
+
+    // Segment updates and strip->show() run on core 1 unless the engine
+    // was configured to stay on this core.
+    if (!renderEngine.isRunningOnSecondCore())
     {
-        for (auto *s : strip->getSegments())
-        {
-            s->update();
-        }
-        strip->show();
+        renderEngine.renderFrame();
     }
 }
 
+// Buffered effects draw nothing while they have no scratch memory; the
+// render core only counts the failures, so say so from here
+void reportArenaFailures()
+{
+    static uint16_t reported = 0;
+    static unsigned long lastReportMs = 0;
+    if (!strip)
+        return;
+    const EffectArena &arena = strip->getArena();
+    uint16_t failed = arena.failedAllocations();
+    // A segment that cannot fit fails every frame; once every 5 s is enough
+    if (failed == reported || millis() - lastReportMs < 5000)
+        return;
+    reported = failed;
+    lastReportMs = millis();
+    LOG_ERROR("ERR: Effect arena full (%u of %u bytes in use); buffered effects cannot draw. Raise EFFECT_ARENA_SIZE.",
+              (unsigned)arena.used(), (unsigned)arena.capacity());
+}
+
 // --- Serial Command Processing ---
 void processSerial()
 {
@@ -271,17 +310,26 @@ void processSerial()
 // --- Hardware Processing Functions ---
 void processAudio()
 {
-    if (samplesRead > 0)
+    static int16_t frame[SAMPLES];
+
+    // Analyse every queued hop, but never more than AUDIO_MAX_BACKLOG_HOPS
+    // behind: after a long stall the oldest audio is skipped, so latency
+    // stays bounded instead of growing with the backlog.
+    audioRing.dropBacklog(SAMPLES + AUDIO_MAX_BACKLOG_HOPS * AUDIO_HOP_SIZE, AUDIO_HOP_SIZE);
+    while (true)
     {
-        audioTrigger.update(sampleBuffer);
-        samplesRead = 0;
+        // Timestamps come from the sample count, not millis()
+        uint64_t frameEnd = audioRing.samplesConsumed() + SAMPLES;
+        if (!audioRing.readFrame(frame, SAMPLES, AUDIO_HOP_SIZE))
+            break;
+        uint32_t startUs = micros();
+        audioTrigger.update(frame, (uint32_t)(frameEnd * 1000 / SAMPLING_FREQ));
+        Telemetry::getInstance().recordAudioFrame(micros() - startUs);
     }
 }
 
 void processAccel()
 {
-    if (IMU.accelerationAvailable())
-    {
-        IMU.readAcceleration(accelX, accelY, accelZ);
-    }
+    // Drains the IMU FIFO every IMU_POLL_INTERVAL_MS and publishes motion events
+    MotionSensor::getInstance().update();
 }